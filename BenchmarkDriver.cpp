@@ -0,0 +1,208 @@
+#include "SobolBatch.h"
+#include "ReferenceModels.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+/* Benchmark of the Sobol' index computations on the reference models
+ * of ReferenceModels.h.  For every model, form (scalar or batched) and
+ * N, it reports the model evaluations, wall time, evaluations per
+ * second and, where analytic indices are known, the largest absolute
+ * error of the lower and total indices over the index sets.
+ *
+ * Usage: ./a.out [max N] [results file]
+ *
+ * Runs headless; the table goes to stdout and, if given, to the
+ * results file.
+ */
+
+/* one model of the benchmark */
+struct BenchmarkCase
+{
+  std::string name;
+  std::vector<int> families;  /* InverseTransformation::*_PARAM */
+  std::vector<std::vector<Type> > distroParams;
+  std::vector<std::set<int> > sets;  /* index sets to estimate */
+  unsigned int maxN;  /* cap on N for expensive models */
+};
+
+/* Adds dim parameters of the same distribution to c */
+void AddParams(BenchmarkCase &c, int dim, int family, Type p0, Type p1)
+{
+  for (int j = 0; j < dim; ++j)
+    {
+      c.families.push_back(family);
+      c.distroParams.push_back(std::vector<Type>{p0, p1});
+    }
+}
+
+/* Adds the single-parameter index sets {1}, ..., {num} to c */
+void AddSingletons(BenchmarkCase &c, int num)
+{
+  for (int j = 1; j <= num; ++j)
+    {
+      c.sets.push_back(std::set<int>{j});
+    }
+}
+
+std::vector<BenchmarkCase> BenchmarkCases()
+{
+  std::vector<BenchmarkCase> cases;
+  const int U = InverseTransformation::UNIFORM_PARAM,
+    N = InverseTransformation::NORMAL_PARAM;
+
+  BenchmarkCase ishigami;
+  ishigami.name = "ishigami";
+  AddParams(ishigami, 3, U, -M_PI, M_PI);
+  AddSingletons(ishigami, 3);
+  ishigami.sets.push_back(std::set<int>{1, 3});
+  ishigami.maxN = 0;
+  cases.push_back(ishigami);
+
+  BenchmarkCase gfunction;
+  gfunction.name = "gfunction";
+  AddParams(gfunction, 8, U, 0, 1);
+  AddSingletons(gfunction, 8);
+  gfunction.sets.push_back(std::set<int>{1, 2});
+  gfunction.maxN = 0;
+  cases.push_back(gfunction);
+
+  BenchmarkCase bratley;
+  bratley.name = "bratley";
+  AddParams(bratley, 10, U, 0, 1);
+  AddSingletons(bratley, 10);
+  bratley.maxN = 0;
+  cases.push_back(bratley);
+
+  BenchmarkCase additive;
+  additive.name = "additive";
+  AddParams(additive, 100, U, 0, 1);
+  AddSingletons(additive, 5);
+  std::set<int> firstHalf;
+  for (int j = 1; j <= 50; ++j)
+    {
+      firstHalf.insert(j);
+    }
+  additive.sets.push_back(firstHalf);
+  additive.maxN = 0;
+  cases.push_back(additive);
+
+  /* log a, log b, log sigma */
+  BenchmarkCase vasicek;
+  vasicek.name = "vasicek";
+  vasicek.families = {N, N, N};
+  vasicek.distroParams = {{log(0.5), 0.01}, {log(0.04), 0.01},
+			  {log(0.02), 0.01}};
+  AddSingletons(vasicek, 3);
+  vasicek.maxN = 0;
+  cases.push_back(vasicek);
+
+  /* kappa, theta, sigma, rho, v0 */
+  BenchmarkCase heston;
+  heston.name = "heston";
+  heston.families = {N, N, N, N, N};
+  heston.distroParams = {{2, 0.04}, {0.04, 1e-5}, {0.3, 9e-4},
+			 {-0.7, 2.5e-3}, {0.04, 1e-5}};
+  AddSingletons(heston, 5);
+  heston.maxN = 10000;
+  cases.push_back(heston);
+
+  return cases;
+}
+
+int main(int argc, char** argv)
+{
+  unsigned int maxN = argc > 1 ? atoi(argv[1]) : 100000;
+  std::ofstream resultsFile;
+  if (argc > 2)
+    {
+      resultsFile.open(argv[2]);
+    }
+
+  RegisterReferenceModels();
+
+  /* specify constant model parameters, defaults of each model */
+  std::vector<Type> constants = {};
+
+  std::ostringstream header;
+  header << std::left << std::setw(10) << "# model" << std::setw(8)
+	 << "form" << std::setw(9) << "N" << std::setw(11) << "evals"
+	 << std::setw(12) << "wall(s)" << std::setw(13) << "evals/s"
+	 << std::setw(13) << "errLower" << "errTotal\n";
+  std::cout << header.str();
+  resultsFile << header.str();
+
+  for (const auto& c : BenchmarkCases())
+    {
+      ModelFunction model = ModelRegistry::Instance()->Lookup(c.name);
+      BatchModelFunction batchModel
+	= ModelRegistry::Instance()->LookupBatch(c.name);
+      int dim = c.distroParams.size();
+
+      for (int form = 0; form < 2; ++form)
+	{
+	  for (unsigned int N = 1000; N <= maxN; N *= 10)
+	    {
+	      if (c.maxN && N > c.maxN)
+		{
+		  break;
+		}
+
+	      SobolBatch batch(model, constants);
+	      if (form == 1)
+		{
+		  batch.SetBatchModel(batchModel);
+		}
+	      for (const auto& S : c.sets)
+		{
+		  batch.AddJob(S, c.families, c.distroParams, N);
+		}
+
+	      std::chrono::steady_clock::time_point tic
+		= std::chrono::steady_clock::now();
+	      batch.Run();
+	      Type wall = std::chrono::duration<Type>
+		(std::chrono::steady_clock::now() - tic).count();
+
+	      /* largest absolute error over the index sets */
+	      bool isAnalytic = true;
+	      Type errLower = 0, errTotal = 0;
+	      for (size_t i = 0; i < c.sets.size(); ++i)
+		{
+		  Type lower, total;
+		  if (!AnalyticIndices(c.name, c.sets[i], dim, constants,
+				       lower, total))
+		    {
+		      isAnalytic = false;
+		      break;
+		    }
+		  const SobolAccumulator &result = batch.GetResult(i);
+		  errLower = std::max(errLower,
+				      std::abs(result.LowerIndex() - lower));
+		  errTotal = std::max(errTotal,
+				      std::abs(result.TotalIndex() - total));
+		}
+
+	      std::ostringstream line;
+	      line << std::left << std::setw(10) << c.name << std::setw(8)
+		   << (form == 0 ? "scalar" : "batch") << std::setw(9) << N
+		   << std::setw(11) << batch.GetModelEvaluations()
+		   << std::setw(12) << std::setprecision(4) << wall
+		   << std::setw(13) << std::setprecision(4)
+		   << batch.GetModelEvaluations()/wall;
+	      if (isAnalytic)
+		{
+		  line << std::setw(13) << std::setprecision(3) << errLower
+		       << std::setprecision(3) << errTotal << "\n";
+		}
+	      else
+		{
+		  line << std::setw(13) << "n/a" << "n/a\n";
+		}
+	      std::cout << line.str() << std::flush;
+	      resultsFile << line.str();
+	    }
+	}
+    }
+}
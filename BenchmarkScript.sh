@@ -0,0 +1,6 @@
+#!/bin/bash
+
+g++ -O2 -std=c++0x -pthread BenchmarkDriver.cpp ReferenceModels.cpp SobolBatch.cpp ExternalModelPool.cpp SobolIndices.cpp EvaluationCache.cpp Philox.cpp Instrumentation.cpp QMCDesign.cpp DesignStore.cpp CorrelatedNormal.cpp ThreadPool.cpp WorkStealingPool.cpp ModelRegistry.cpp ModelPlugin.cpp ParseUtils.cpp Halton.cpp MT64.cpp InverseTransformation.cpp InverseCDFTable.cpp MersenneTwister.cpp DSFMT.cpp -ldl
+
+# ./a.out
+# ./a.out 1000000 BenchmarkResults.txt
@@ -0,0 +1,133 @@
+#include "CorrelatedNormal.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+/* Factors covariance (row-major dim x dim, symmetric positive
+ * definite) with the variables in the given order (a permutation of
+ * 0..dim-1, identity if empty).  Returns false, keeping the old factor,
+ * if the sizes do not match or the covariance is not positive
+ * definite. */
+bool CorrelatedNormal::
+Factor(const std::vector<Type> &mean_, const std::vector<Type> &covariance,
+       const std::vector<int> &order)
+{
+  int n = mean_.size();
+  if (n == 0 || covariance.size() != (size_t)n*n
+      || (!order.empty() && order.size() != (size_t)n))
+    {
+      std::cout << "CorrelatedNormal: size mismatch\n";
+      return false;
+    }
+
+  std::vector<int> perm(order);
+  if (perm.empty())
+    {
+      for (int i = 0; i < n; ++i)
+	{
+	  perm.push_back(i);
+	}
+    }
+
+  /* covariance of the permuted variables */
+  std::vector<Type> P((size_t)n*n), L;
+  for (int p = 0; p < n; ++p)
+    {
+      for (int q = 0; q < n; ++q)
+	{
+	  P[(size_t)p*n + q] = covariance[(size_t)perm[p]*n + perm[q]];
+	}
+    }
+  if (!Cholesky(P, n, L))
+    {
+      std::cout << "CorrelatedNormal: covariance not positive definite\n";
+      return false;
+    }
+
+  /* variable perm[p] = mean + sum_q L[p][q] Z[q], stored transposed */
+  dim = n;
+  mean = mean_;
+  factorT.assign((size_t)n*n, 0);
+  for (int p = 0; p < n; ++p)
+    {
+      for (int q = 0; q <= p; ++q)
+	{
+	  factorT[(size_t)q*n + perm[p]] = L[(size_t)p*n + q];
+	}
+    }
+  return true;
+}
+
+/* Cholesky factor A = L L' of the row-major n x n matrix A; L is lower
+ * triangular, row-major.  Returns false if A is not positive
+ * definite. */
+bool CorrelatedNormal::
+Cholesky(const std::vector<Type> &A, int n, std::vector<Type> &L)
+{
+  L.assign((size_t)n*n, 0);
+  for (int j = 0; j < n; ++j)
+    {
+      Type d = A[(size_t)j*n + j];
+      for (int k = 0; k < j; ++k)
+	{
+	  d -= L[(size_t)j*n + k]*L[(size_t)j*n + k];
+	}
+      if (!(d > 0))
+	{
+	  return false;
+	}
+      d = sqrt(d);
+      L[(size_t)j*n + j] = d;
+      for (int i = j + 1; i < n; ++i)
+	{
+	  Type s = A[(size_t)i*n + j];
+	  for (int k = 0; k < j; ++k)
+	    {
+	      s -= L[(size_t)i*n + k]*L[(size_t)j*n + k];
+	    }
+	  L[(size_t)i*n + j] = s/d;
+	}
+    }
+  return true;
+}
+
+/* Transforms n points: row r of Z (dim N(0,1) coordinates, rows ldz
+ * apart) becomes row r of X (dim values, rows dim apart).  The product
+ * is tiled over rows, the inner dimension and columns so that the
+ * tiles of Z, the factor and X stay in cache; the innermost loop runs
+ * along a row of X and is vectorized by the compiler. */
+void CorrelatedNormal::
+Transform(const Type *Z, size_t ldz, unsigned int n, Type *X) const
+{
+  for (unsigned int r0 = 0; r0 < n; r0 += CORRNORMAL_ROW_TILE)
+    {
+      unsigned int r1 = std::min(n, r0 + CORRNORMAL_ROW_TILE);
+      for (unsigned int r = r0; r < r1; ++r)
+	{
+	  std::copy(mean.begin(), mean.end(), X + (size_t)r*dim);
+	}
+
+      for (int j0 = 0; j0 < dim; j0 += CORRNORMAL_COL_TILE)
+	{
+	  int j1 = std::min(dim, j0 + CORRNORMAL_COL_TILE);
+	  for (int k0 = 0; k0 < dim; k0 += CORRNORMAL_K_TILE)
+	    {
+	      int k1 = std::min(dim, k0 + CORRNORMAL_K_TILE);
+	      for (unsigned int r = r0; r < r1; ++r)
+		{
+		  const Type *z = Z + (size_t)r*ldz;
+		  Type *x = X + (size_t)r*dim;
+		  for (int k = k0; k < k1; ++k)
+		    {
+		      const Type zk = z[k];
+		      const Type *f = &factorT[(size_t)k*dim];
+		      for (int j = j0; j < j1; ++j)
+			{
+			  x[j] += zk*f[j];
+			}
+		    }
+		}
+	    }
+	}
+    }
+}
@@ -0,0 +1,46 @@
+/* Class CorrelatedNormal maps independent N(0,1) numbers to a
+ * multivariate normal N(mean, covariance).  The covariance is factored
+ * once, C = L L', and whole blocks of points are then transformed by
+ * one matrix product, X = mean + Z L', instead of factoring and
+ * allocating per point as pdflib's r8vec_multinormal_sample does.
+ *
+ * The variables may be factored in any order.  With order = (y, z),
+ * the first |y| coordinates of Z fix y, and changing only the other
+ * coordinates draws z from its conditional distribution given y; this
+ * is the conditional sampling the dependent-input Sobol' estimators of
+ * Kucherenko et al. need, see SobolIndices.
+ */
+
+#ifndef CORRELATEDNORMAL_H
+#define CORRELATEDNORMAL_H
+
+#include <cstddef>
+#include <vector>
+
+#define CORRNORMAL_ROW_TILE 64  /* rows of Z per tile of the product */
+#define CORRNORMAL_K_TILE 64  /* inner dimension per tile */
+#define CORRNORMAL_COL_TILE 256  /* columns of X per tile */
+
+typedef double Type;
+
+class CorrelatedNormal
+{
+ private:
+  int dim;
+  std::vector<Type> mean;
+  /* transposed transform, row-major dim x dim: coordinate q of Z adds
+   * Z[q]*factorT[q*dim + i] to variable i */
+  std::vector<Type> factorT;
+
+ public:
+  CorrelatedNormal() : dim(0) {}
+  bool Factor(const std::vector<Type> &mean_,
+	      const std::vector<Type> &covariance,
+	      const std::vector<int> &order = std::vector<int>());
+  static bool Cholesky(const std::vector<Type> &A, int n,
+		       std::vector<Type> &L);
+  void Transform(const Type *Z, size_t ldz, unsigned int n,
+		 Type *X) const;
+  int GetDim() const {return dim;}
+};
+#endif
@@ -0,0 +1,186 @@
+#include "DSFMT.h"
+#include <algorithm>
+#include <cstring>
+
+/* Dflt ctor: same default seed as MersenneTwister's init_genrand64 */
+DSFMT::DSFMT()
+{
+  Seed(5489U);
+}
+
+/* Ctor
+ * Input:
+ *   seed = 32-bit seed, as dsfmt_init_gen_rand() of the reference code
+ */
+DSFMT::DSFMT(uint32_t seed)
+{
+  Seed(seed);
+}
+
+/* Restarts the generator from seed */
+void DSFMT::Seed(uint32_t seed)
+{
+  uint32_t *psfmt = &status[0].u32[0];
+  psfmt[0] = seed;
+  for (int i = 1; i < (DSFMT_N + 1)*4; ++i)
+    {
+      psfmt[i] = 1812433253UL*(psfmt[i - 1] ^ (psfmt[i - 1] >> 30)) + i;
+    }
+
+  /* put every double of the state into [1,2) */
+  for (int i = 0; i < DSFMT_N; ++i)
+    {
+      for (int k = 0; k < 2; ++k)
+	{
+	  status[i].u[k] = (status[i].u[k] & DSFMT_LOW_MASK)
+	    | DSFMT_HIGH_CONST;
+	}
+    }
+
+  PeriodCertification();
+  idx = DSFMT_N64;
+}
+
+/* Makes sure the state is on the orbit of period 2^19937 - 1 */
+void DSFMT::PeriodCertification()
+{
+  uint64_t tmp0 = status[DSFMT_N].u[0] ^ DSFMT_FIX1;
+  uint64_t tmp1 = status[DSFMT_N].u[1] ^ DSFMT_FIX2;
+  uint64_t inner = (tmp0 & DSFMT_PCV1) ^ (tmp1 & DSFMT_PCV2);
+  for (int i = 32; i > 0; i >>= 1)
+    {
+      inner ^= inner >> i;
+    }
+  if ((inner & 1) == 0)
+    {
+      status[DSFMT_N].u[1] ^= 1;
+    }
+}
+
+#ifdef __SSE2__
+/* r = recursion of a, b and the lung u; updates u */
+static inline void DoRecursion(DSFMTWord *r, const DSFMTWord *a,
+			       const DSFMTWord *b, DSFMTWord *u,
+			       __m128i mask)
+{
+  __m128i x = a->si;
+  __m128i z = _mm_slli_epi64(x, DSFMT_SL1);
+  __m128i y = _mm_shuffle_epi32(u->si, 0x1b);  /* swap 32-bit halves */
+  z = _mm_xor_si128(z, b->si);
+  y = _mm_xor_si128(y, z);
+  __m128i v = _mm_srli_epi64(y, DSFMT_SR);
+  __m128i w = _mm_and_si128(y, mask);
+  v = _mm_xor_si128(v, x);
+  v = _mm_xor_si128(v, w);
+  r->si = v;
+  u->si = y;
+}
+#else
+static inline void DoRecursion(DSFMTWord *r, const DSFMTWord *a,
+			       const DSFMTWord *b, DSFMTWord *u)
+{
+  uint64_t t0 = a->u[0], t1 = a->u[1];
+  uint64_t L0 = u->u[0], L1 = u->u[1];
+  u->u[0] = (t0 << DSFMT_SL1) ^ (L1 >> 32) ^ (L1 << 32) ^ b->u[0];
+  u->u[1] = (t1 << DSFMT_SL1) ^ (L0 >> 32) ^ (L0 << 32) ^ b->u[1];
+  r->u[0] = (u->u[0] >> DSFMT_SR) ^ (u->u[0] & DSFMT_MSK1) ^ t0;
+  r->u[1] = (u->u[1] >> DSFMT_SR) ^ (u->u[1] & DSFMT_MSK2) ^ t1;
+}
+#endif
+
+/* Refreshes the whole state, DSFMT_N64 new doubles in [1,2) */
+void DSFMT::GenRandAll()
+{
+  DSFMTWord lung = status[DSFMT_N];
+  int i;
+#ifdef __SSE2__
+  const __m128i mask = _mm_set_epi64x(DSFMT_MSK2, DSFMT_MSK1);
+  for (i = 0; i < DSFMT_N - DSFMT_POS1; ++i)
+    {
+      DoRecursion(&status[i], &status[i], &status[i + DSFMT_POS1], &lung,
+		  mask);
+    }
+  for (; i < DSFMT_N; ++i)
+    {
+      DoRecursion(&status[i], &status[i],
+		  &status[i + DSFMT_POS1 - DSFMT_N], &lung, mask);
+    }
+#else
+  for (i = 0; i < DSFMT_N - DSFMT_POS1; ++i)
+    {
+      DoRecursion(&status[i], &status[i], &status[i + DSFMT_POS1], &lung);
+    }
+  for (; i < DSFMT_N; ++i)
+    {
+      DoRecursion(&status[i], &status[i],
+		  &status[i + DSFMT_POS1 - DSFMT_N], &lung);
+    }
+#endif
+  status[DSFMT_N] = lung;
+}
+
+/* Returns a number in the open interval (0,1) */
+double DSFMT::genrand64_real3()
+{
+  if (idx >= DSFMT_N64)
+    {
+      GenRandAll();
+      idx = 0;
+    }
+  uint64_t bits;
+  std::memcpy(&bits, Doubles() + idx++, sizeof(bits));
+  bits |= 1;
+  double x;
+  std::memcpy(&x, &bits, sizeof(x));
+  return x - 1.0;
+}
+
+/* Fills array with n numbers in [0,1), continuing the same stream as
+ * genrand64_real3() */
+void DSFMT::fill(double *array, size_t n)
+{
+  while (n > 0)
+    {
+      if (idx >= DSFMT_N64)
+	{
+	  GenRandAll();
+	  idx = 0;
+	}
+      size_t m = std::min(n, (size_t)(DSFMT_N64 - idx));
+      const double *src = Doubles() + idx;
+      for (size_t i = 0; i < m; ++i)
+	{
+	  array[i] = src[i] - 1.0;
+	}
+      array += m;
+      n -= m;
+      idx += m;
+    }
+}
+
+/* Fills array with n numbers in the open interval (0,1), for inverse
+ * transforms that are infinite at 0 */
+void DSFMT::fill_open(double *array, size_t n)
+{
+  while (n > 0)
+    {
+      if (idx >= DSFMT_N64)
+	{
+	  GenRandAll();
+	  idx = 0;
+	}
+      size_t m = std::min(n, (size_t)(DSFMT_N64 - idx));
+      const uint64_t *src
+	= reinterpret_cast<const uint64_t*>(status) + idx;
+      for (size_t i = 0; i < m; ++i)
+	{
+	  uint64_t bits = src[i] | 1;
+	  double x;
+	  std::memcpy(&x, &bits, sizeof(x));
+	  array[i] = x - 1.0;
+	}
+      array += m;
+      n -= m;
+      idx += m;
+    }
+}
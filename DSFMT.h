@@ -0,0 +1,68 @@
+/* Class DSFMT is the double precision SIMD-oriented Fast Mersenne
+ * Twister of Saito and Matsumoto (dSFMT-19937, period 2^19937 - 1).
+ * The state is 191 128-bit words of doubles in [1,2); each pass of the
+ * recursion refreshes all of them at once, so numbers are best drawn in
+ * bulk with fill().  The recursion runs on SSE2 registers where
+ * available and on pairs of 64-bit words otherwise; both give the same
+ * sequence as the reference implementation.
+ *
+ * genrand64_real3() matches the interface of MersenneTwister.
+ */
+
+#ifndef DSFMT_H
+#define DSFMT_H
+
+#include <cstddef>
+#include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define DSFMT_MEXP 19937
+#define DSFMT_N ((DSFMT_MEXP - 128)/104 + 1)  /* 128-bit words */
+#define DSFMT_N64 (DSFMT_N*2)  /* doubles per pass */
+#define DSFMT_POS1 117
+#define DSFMT_SL1 19
+#define DSFMT_SR 12
+#define DSFMT_MSK1 0x000ffafffffffb3fULL
+#define DSFMT_MSK2 0x000ffdfffc90fffdULL
+#define DSFMT_FIX1 0x90014964b32f4329ULL
+#define DSFMT_FIX2 0x3b8d12ac548a7c7aULL
+#define DSFMT_PCV1 0x3d84e1ac0dc82880ULL
+#define DSFMT_PCV2 0x0000000000000001ULL
+#define DSFMT_LOW_MASK 0x000FFFFFFFFFFFFFULL
+#define DSFMT_HIGH_CONST 0x3FF0000000000000ULL
+
+/* one 128-bit word of the state */
+union DSFMTWord
+{
+  uint64_t u[2];
+  uint32_t u32[4];
+  double d[2];
+#ifdef __SSE2__
+  __m128i si;
+#endif
+};
+
+class DSFMT
+{
+ private:
+  DSFMTWord status[DSFMT_N + 1];  /* last word is the "lung" */
+  int idx;  /* next double of the current pass, DSFMT_N64 = used up */
+
+  void GenRandAll();
+  void PeriodCertification();
+  const double* Doubles() const
+  {
+    return reinterpret_cast<const double*>(status);
+  }
+
+ public:
+  DSFMT();
+  DSFMT(uint32_t seed);
+  void Seed(uint32_t seed);
+  double genrand64_real3();
+  void fill(double *array, size_t n);
+  void fill_open(double *array, size_t n);
+};
+#endif
@@ -0,0 +1,63 @@
+#include "DesignStore.h"
+#include <iostream>
+#include <sys/stat.h>
+
+/* Ctor
+ * Input:
+ *
+ * directory_ = directory of the design files, created if missing
+ */
+DesignStore::DesignStore(const std::string &directory_)
+{
+  directory = directory_.empty() ? "." : directory_;
+  mkdir(directory.c_str(), 0755);
+}
+
+/* Returns the file name of a design */
+std::string DesignStore::
+Path(const std::string &generator, unsigned int N, int cols,
+     bool standardNormal) const
+{
+  return directory + "/" + generator + "_N" + std::to_string(N) + "_c"
+    + std::to_string(cols) + (standardNormal ? "_normal" : "_unif")
+    + ".design";
+}
+
+/* Returns the design with N points of cols columns from the named
+ * generator.  If it is not stored yet, generate(design) fills a new
+ * Unif(0,1) design, which is mapped to N(0,1) if standardNormal and
+ * then saved.  If the directory cannot be written the generated design
+ * is returned from memory.
+ */
+std::shared_ptr<const QMCDesign> DesignStore::
+Get(const std::string &generator, unsigned int N, int cols,
+    bool standardNormal,
+    const std::function<void(QMCDesign&)> &generate) const
+{
+  std::string path = Path(generator, N, cols, standardNormal);
+  QMCDesign *stored = QMCDesign::Map(path);
+  if (stored && stored->GetN() == N && stored->GetCols() == cols
+      && stored->IsStandardNormal() == standardNormal)
+    {
+      return std::shared_ptr<const QMCDesign>(stored);
+    }
+  delete stored;
+
+  std::shared_ptr<QMCDesign> design(new QMCDesign(N, cols));
+  generate(*design);
+  if (standardNormal)
+    {
+      InverseTransformation invTrans;
+      design->TransformToStandardNormal(&invTrans);
+    }
+
+  if (design->Save(path))
+    {
+      stored = QMCDesign::Map(path);
+      if (stored)
+	{
+	  return std::shared_ptr<const QMCDesign>(stored);
+	}
+    }
+  return design;
+}
@@ -0,0 +1,38 @@
+/* Class DesignStore keeps QMC designs in a directory so that runs with
+ * the same generator settings generate them only once.  Get() maps the
+ * stored design read-only if there is one, and otherwise generates it,
+ * saves it and maps the saved file, so concurrent processes (e.g. the
+ * shards of a batch) share one copy in the page cache.
+ *
+ * Files are named by the generator name given by the caller, the
+ * number of points, the number of columns and whether the design is
+ * Unif(0,1) or N(0,1).  The name must identify everything else the
+ * points depend on, e.g. "philox-<seed>-<first sample>".  The halton
+ * (RASRAP) generator takes its random start and permutation from the
+ * clock, so a stored "halton" design is one fixed randomization that
+ * later runs reuse; delete the file to draw a new one.
+ */
+
+#ifndef DESIGNSTORE_H
+#define DESIGNSTORE_H
+
+#include <string>
+#include <memory>
+#include <functional>
+#include "QMCDesign.h"
+
+class DesignStore
+{
+ private:
+  std::string directory;
+
+ public:
+  DesignStore(const std::string &directory_);
+  std::string Path(const std::string &generator, unsigned int N,
+		   int cols, bool standardNormal) const;
+  std::shared_ptr<const QMCDesign>
+    Get(const std::string &generator, unsigned int N, int cols,
+	bool standardNormal,
+	const std::function<void(QMCDesign&)> &generate) const;
+};
+#endif
@@ -0,0 +1,357 @@
+#include "EvaluationCache.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* splitmix64 finalizer */
+static inline uint64_t Mix(uint64_t h)
+{
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h;
+}
+
+/* FNV-1a of s */
+static uint64_t HashString(const std::string &s)
+{
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (unsigned char c : s)
+    {
+      h = (h ^ c)*0x100000001b3ULL;
+    }
+  return h;
+}
+
+/* Ctor
+ * Input:
+ *
+ * directory_ = directory of the segment files, created if missing
+ * maxBytes = cap on the total size of the segment files
+ * tag = name of the model, mixed into every key
+ */
+EvaluationCache::
+EvaluationCache(const std::string &directory_, unsigned long long maxBytes,
+		const std::string &tag)
+{
+  directory = directory_.empty() ? "." : directory_;
+  tagHash = HashString(tag);
+  clock = 0;
+  hits = 0;
+  misses = 0;
+
+  /* largest power of 2 of entries that fits a segment's share */
+  unsigned long long segmentBytes = maxBytes/EVALCACHE_SEGMENTS;
+  capacity = EVALCACHE_MIN_CAPACITY;
+  while ((2*capacity)*sizeof(EvaluationCacheEntry) + EVALCACHE_HEADER_BYTES
+	 <= segmentBytes)
+    {
+      capacity *= 2;
+    }
+
+  mkdir(directory.c_str(), 0755);
+  std::string lockPath = directory + "/lock";
+  lockFd = open(lockPath.c_str(), O_RDWR | O_CREAT, 0644);
+  if (lockFd >= 0 && flock(lockFd, LOCK_EX | LOCK_NB) != 0)
+    {
+      close(lockFd);
+      lockFd = -1;
+    }
+  if (lockFd < 0)
+    {
+      std::cout << "evaluation cache " << directory
+		<< " is in use or not writable, running without it\n";
+      return;
+    }
+
+  /* map the existing segments, oldest first */
+  std::vector<std::pair<uint64_t, std::string> > files;
+  DIR *dir = opendir(directory.c_str());
+  if (dir)
+    {
+      struct dirent *entry;
+      while ((entry = readdir(dir)) != NULL)
+	{
+	  unsigned long long seq;
+	  char end;
+	  if (sscanf(entry->d_name, "segment_%llu.ev%c", &seq, &end) == 2
+	      && end == 'c')
+	    {
+	      files.push_back(std::make_pair(seq, directory + "/"
+					     + entry->d_name));
+	    }
+	}
+      closedir(dir);
+    }
+  std::sort(files.begin(), files.end());
+  for (const auto& i : files)
+    {
+      if (!OpenSegment(i.second, i.first, false))
+	{
+	  std::cout << "dropping invalid cache segment " << i.second << "\n";
+	  unlink(i.second.c_str());
+	}
+    }
+  for (const auto& i : segments)
+    {
+      clock = std::max(clock, i.header->lastUsed);
+    }
+
+  if (segments.empty() || segments.back().header->count
+      >= EVALCACHE_MAX_LOAD*segments.back().header->capacity)
+    {
+      AddSegment();
+    }
+}
+
+/* Computes the two hashes of (tag, dim, x, constants) */
+void EvaluationCache::
+Key(const Type *x, int dim, const std::vector<Type> &constants,
+    uint64_t &key1, uint64_t &key2) const
+{
+  uint64_t h1 = Mix(tagHash ^ 0x243f6a8885a308d3ULL ^ (uint64_t)dim);
+  uint64_t h2 = Mix(tagHash + 0x13198a2e03707344ULL + (uint64_t)dim);
+  for (int j = 0; j < dim; ++j)
+    {
+      uint64_t w;
+      std::memcpy(&w, &x[j], sizeof(w));
+      h1 = Mix(h1 ^ w);
+      h2 = Mix(h2 + w);
+    }
+  h1 = Mix(h1 ^ constants.size());
+  h2 = Mix(h2 + constants.size());
+  for (auto c : constants)
+    {
+      uint64_t w;
+      std::memcpy(&w, &c, sizeof(w));
+      h1 = Mix(h1 ^ w);
+      h2 = Mix(h2 + w);
+    }
+  key1 = h1 | 1;
+  key2 = h2;
+}
+
+/* Maps segment file path, creating it with the current capacity if
+ * create is set.  Returns false if it cannot be mapped or is not a
+ * segment of this version. */
+bool EvaluationCache::OpenSegment(const std::string &path, uint64_t seq,
+				  bool create)
+{
+  int fd = create ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)
+    : open(path.c_str(), O_RDWR);
+  if (fd < 0)
+    {
+      return false;
+    }
+
+  size_t length;
+  if (create)
+    {
+      length = EVALCACHE_HEADER_BYTES
+	+ capacity*sizeof(EvaluationCacheEntry);
+      if (ftruncate(fd, length) != 0)
+	{
+	  close(fd);
+	  return false;
+	}
+    }
+  else
+    {
+      struct stat st;
+      if (fstat(fd, &st) != 0 || st.st_size < EVALCACHE_HEADER_BYTES)
+	{
+	  close(fd);
+	  return false;
+	}
+      length = st.st_size;
+    }
+
+  void *map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+		   0);
+  close(fd);
+  if (map == MAP_FAILED)
+    {
+      return false;
+    }
+
+  EvaluationCacheSegment segment;
+  segment.path = path;
+  segment.mapping = map;
+  segment.length = length;
+  segment.header = (EvaluationCacheHeader*)map;
+  segment.entries = (EvaluationCacheEntry*)((char*)map
+					    + EVALCACHE_HEADER_BYTES);
+
+  EvaluationCacheHeader *header = segment.header;
+  if (create)
+    {
+      std::memcpy(header->magic, EVALCACHE_MAGIC, sizeof(header->magic));
+      header->version = EVALCACHE_VERSION;
+      header->seq = seq;
+      header->capacity = capacity;
+      header->count = 0;
+      header->lastUsed = ++clock;
+    }
+  else if (std::memcmp(header->magic, EVALCACHE_MAGIC,
+		       sizeof(header->magic))
+	   || header->version != EVALCACHE_VERSION
+	   || header->seq != seq || header->capacity == 0
+	   || (header->capacity & (header->capacity - 1))
+	   || length != EVALCACHE_HEADER_BYTES
+	   + header->capacity*sizeof(EvaluationCacheEntry))
+    {
+      munmap(map, length);
+      return false;
+    }
+
+  segments.push_back(segment);
+  return true;
+}
+
+/* Starts a new segment, then deletes the least recently used older
+ * one if there are more than EVALCACHE_SEGMENTS */
+bool EvaluationCache::AddSegment()
+{
+  uint64_t seq = segments.empty() ? 0 : segments.back().header->seq + 1;
+  std::string path = directory + "/segment_" + std::to_string(seq)
+    + ".evc";
+  if (!OpenSegment(path, seq, true))
+    {
+      std::cout << "cannot create cache segment " << path << "\n";
+      return false;
+    }
+
+  while (segments.size() > EVALCACHE_SEGMENTS)
+    {
+      size_t lru = 0;
+      for (size_t s = 1; s + 1 < segments.size(); ++s)
+	{
+	  if (segments[s].header->lastUsed < segments[lru].header->lastUsed)
+	    {
+	      lru = s;
+	    }
+	}
+      unlink(segments[lru].path.c_str());
+      CloseSegment(segments[lru]);
+      segments.erase(segments.begin() + lru);
+    }
+  return true;
+}
+
+void EvaluationCache::CloseSegment(EvaluationCacheSegment &segment)
+{
+  munmap(segment.mapping, segment.length);
+}
+
+/* Returns the entry of (key1, key2) in segment, or the empty slot
+ * where it would go */
+EvaluationCacheEntry* EvaluationCache::
+Find(EvaluationCacheSegment &segment, uint64_t key1, uint64_t key2)
+{
+  uint64_t mask = segment.header->capacity - 1;
+  uint64_t i = key2 & mask;
+  while (segment.entries[i].key1 != 0)
+    {
+      if (segment.entries[i].key1 == key1 && segment.entries[i].key2 == key2)
+	{
+	  break;
+	}
+      i = (i + 1) & mask;
+    }
+  return &segment.entries[i];
+}
+
+/* Looks up the output for inputs x[0..dim-1] and constants.  Returns
+ * false if it is not cached. */
+bool EvaluationCache::
+Lookup(const Type *x, int dim, const std::vector<Type> &constants, Type &y)
+{
+  uint64_t key1, key2;
+  Key(x, dim, constants, key1, key2);
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  for (size_t s = segments.size(); s-- > 0; )
+    {
+      EvaluationCacheEntry *entry = Find(segments[s], key1, key2);
+      if (entry->key1 != 0)
+	{
+	  y = entry->value;
+	  segments[s].header->lastUsed = ++clock;
+	  ++hits;
+	  return true;
+	}
+    }
+  ++misses;
+  return false;
+}
+
+/* Adds the output y for inputs x[0..dim-1] and constants.  The value
+ * is written before the key, so a crash never leaves a key without
+ * its value. */
+void EvaluationCache::
+Insert(const Type *x, int dim, const std::vector<Type> &constants, Type y)
+{
+  uint64_t key1, key2;
+  Key(x, dim, constants, key1, key2);
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  if (segments.empty())
+    {
+      return;
+    }
+  EvaluationCacheSegment &segment = segments.back();
+  if (segment.header->count + 1 >= segment.header->capacity)
+    {
+      return;  /* no new segment could be made; keep a free slot */
+    }
+  EvaluationCacheEntry *entry = Find(segment, key1, key2);
+  if (entry->key1 != 0)
+    {
+      return;
+    }
+  entry->value = y;
+  entry->key2 = key2;
+  __atomic_store_n(&entry->key1, key1, __ATOMIC_RELEASE);
+  segment.header->lastUsed = ++clock;
+  if (++segment.header->count
+      >= EVALCACHE_MAX_LOAD*segment.header->capacity)
+    {
+      AddSegment();
+    }
+}
+
+/* Returns model(x, constants), from the cache if it is there */
+Type EvaluationCache::
+Evaluate(ModelFunction model, const std::vector<Type> &x,
+	 const std::vector<Type> &constants)
+{
+  Type y;
+  if (Lookup(x.data(), x.size(), constants, y))
+    {
+      return y;
+    }
+  y = model(x, constants);
+  Insert(x.data(), x.size(), constants, y);
+  return y;
+}
+
+/* Dtor: unmaps the segments and releases the directory */
+EvaluationCache::~EvaluationCache()
+{
+  for (auto& i : segments)
+    {
+      CloseSegment(i);
+    }
+  if (lockFd >= 0)
+    {
+      close(lockFd);
+    }
+}
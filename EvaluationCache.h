@@ -0,0 +1,102 @@
+/* Class EvaluationCache keeps model outputs on local disk, keyed by the
+ * exact bits of the input vector and of the constants, so that a rerun
+ * (after a crash, at a larger N, or with some distributions unchanged)
+ * is served from the cache for every point already evaluated.
+ *
+ * The cache is a set of segment files in one directory, each an
+ * open-addressing hash table of EvaluationCacheEntry mapped shared, so
+ * entries reach the page cache as soon as they are written and survive
+ * a crash of the process.  Entries are only ever added.  New entries go
+ * to the newest segment; once it is EVALCACHE_MAX_LOAD full a new one
+ * is started, and when there are more than EVALCACHE_SEGMENTS the
+ * least recently used segment (by a use clock kept in the segment
+ * headers) is deleted, which keeps the directory under maxBytes.
+ *
+ * A key is two independent 64-bit hashes of (tag, dim, inputs,
+ * constants); the tag tells apart models sharing a directory.  All
+ * methods are thread safe.  One process at a time uses a directory: a
+ * second one finds it locked and runs without the cache.
+ */
+
+#ifndef EVALUATIONCACHE_H
+#define EVALUATIONCACHE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ModelRegistry.h"
+
+#define EVALCACHE_MAGIC "EVALCHE"  /* 8 bytes with the terminating 0 */
+#define EVALCACHE_VERSION 1
+#define EVALCACHE_HEADER_BYTES 64
+#define EVALCACHE_SEGMENTS 8
+#define EVALCACHE_MAX_LOAD 0.7
+#define EVALCACHE_MIN_CAPACITY 1024  /* entries per segment */
+#define EVALCACHE_DEFAULT_BYTES (1ULL << 30)
+
+typedef double Type;
+
+struct EvaluationCacheHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t seq;  /* segments are numbered in creation order */
+  uint64_t capacity;  /* entries, a power of 2 */
+  uint64_t count;  /* entries in use */
+  uint64_t lastUsed;  /* use clock of the last hit or insert */
+};
+
+/* key (0, 0) marks an empty slot; key1 always has its low bit set */
+struct EvaluationCacheEntry
+{
+  uint64_t key1, key2;
+  Type value;
+};
+
+struct EvaluationCacheSegment
+{
+  std::string path;
+  void *mapping;
+  size_t length;
+  EvaluationCacheHeader *header;
+  EvaluationCacheEntry *entries;
+};
+
+class EvaluationCache
+{
+ private:
+  std::string directory;
+  uint64_t tagHash;
+  uint64_t capacity;  /* entries per new segment */
+  int lockFd;  /* holds the directory lock, -1 if the cache is off */
+  std::vector<EvaluationCacheSegment> segments;  /* oldest first */
+  uint64_t clock;  /* use clock, above every segment's lastUsed */
+  unsigned long long hits, misses;
+  std::mutex cacheMutex;
+
+  void Key(const Type *x, int dim, const std::vector<Type> &constants,
+	   uint64_t &key1, uint64_t &key2) const;
+  bool OpenSegment(const std::string &path, uint64_t seq, bool create);
+  bool AddSegment();
+  void CloseSegment(EvaluationCacheSegment &segment);
+  EvaluationCacheEntry* Find(EvaluationCacheSegment &segment,
+			     uint64_t key1, uint64_t key2);
+
+ public:
+  EvaluationCache(const std::string &directory_,
+		  unsigned long long maxBytes = EVALCACHE_DEFAULT_BYTES,
+		  const std::string &tag = "");
+  bool IsOpen() const {return lockFd >= 0;}
+  bool Lookup(const Type *x, int dim, const std::vector<Type> &constants,
+	      Type &y);
+  void Insert(const Type *x, int dim, const std::vector<Type> &constants,
+	      Type y);
+  Type Evaluate(ModelFunction model, const std::vector<Type> &x,
+		const std::vector<Type> &constants);
+  unsigned long long GetHits() const {return hits;}
+  unsigned long long GetMisses() const {return misses;}
+  ~EvaluationCache();
+};
+#endif
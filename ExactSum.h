@@ -0,0 +1,148 @@
+/* Class ExactSum adds doubles without rounding, so the sum of a set of
+ * numbers does not depend on the order they are added in or on how
+ * partial sums are grouped and merged.  Parallel Monte Carlo sums built
+ * from it are therefore identical to the last bit whatever the number
+ * of threads or the way runs are split among them.
+ *
+ * Every finite double is an integer multiple of 2^-1074 below 2^1024,
+ * so the sum is kept as a fixed-point number of EXACTSUM_LIMBS signed
+ * 32-bit digits, each stored in an int64_t: value = sum of
+ * limbs[i]*2^(32i - 1074).  Add() splits the 53-bit significand over
+ * three neighbouring limbs without propagating carries, which leaves
+ * 31 bits of headroom per limb; carries are propagated every
+ * EXACTSUM_MAX_PENDING adds and by Value().  Value() rounds the
+ * canonical form once, so equal exact sums give equal doubles.
+ * Infinities and NaNs are summed separately and take over the result.
+ */
+
+#ifndef EXACTSUM_H
+#define EXACTSUM_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#define EXACTSUM_LIMBS 68  /* 32-bit digits from 2^-1074 to 2^1102 */
+#define EXACTSUM_MAX_PENDING (1U << 28)  /* adds between carry passes */
+
+typedef double Type;
+
+class ExactSum
+{
+ private:
+  int64_t limbs[EXACTSUM_LIMBS];
+  Type special;  /* sum of the infinite and NaN terms */
+  unsigned int pending;  /* adds and merges since the last Normalize() */
+
+  /* propagates carries: limbs 0..EXACTSUM_LIMBS-2 into [0, 2^32), the
+   * last one keeps the sign */
+  void Normalize()
+  {
+    int64_t carry = 0;
+    for (int i = 0; i < EXACTSUM_LIMBS - 1; ++i)
+      {
+	int64_t v = limbs[i] + carry;
+	carry = v >> 32;  /* floor division */
+	limbs[i] = v - carry*4294967296LL;
+      }
+    limbs[EXACTSUM_LIMBS - 1] += carry;
+    pending = 0;
+  }
+
+ public:
+  ExactSum() {Clear();}
+
+  void Clear()
+  {
+    std::memset(limbs, 0, sizeof(limbs));
+    special = 0;
+    pending = 0;
+  }
+
+  void Add(Type x)
+  {
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    unsigned int biased = (bits >> 52) & 0x7ff;
+    if (biased == 0x7ff)
+      {
+	special += x;
+	return;
+      }
+    uint64_t mant = bits & 0xfffffffffffffULL;
+    if (biased)
+      {
+	mant |= 1ULL << 52;
+      }
+    else
+      {
+	biased = 1;  /* subnormal */
+      }
+
+    /* x = +-mant*2^(p - 1074), mant < 2^53 */
+    unsigned int p = biased - 1, s = p % 32;
+    uint64_t lo = (mant & 0xffffffffULL) << s;  /* < 2^64 */
+    uint64_t hi = (mant >> 32) << s;  /* < 2^53 */
+    int64_t d0 = (int64_t)(lo & 0xffffffffULL);
+    int64_t d1 = (int64_t)((lo >> 32) + (hi & 0xffffffffULL));
+    int64_t d2 = (int64_t)(hi >> 32);
+    /* negate without a branch, the signs of MC terms are random */
+    int64_t sign = -(int64_t)(bits >> 63);
+    int64_t *limb = limbs + p/32;
+    limb[0] += (d0 ^ sign) - sign;
+    limb[1] += (d1 ^ sign) - sign;
+    limb[2] += (d2 ^ sign) - sign;
+    if (++pending == EXACTSUM_MAX_PENDING)
+      {
+	Normalize();
+      }
+  }
+
+  void Merge(const ExactSum &other)
+  {
+    for (int i = 0; i < EXACTSUM_LIMBS; ++i)
+      {
+	limbs[i] += other.limbs[i];
+      }
+    special += other.special;
+    pending += other.pending + 1;
+    if (pending >= EXACTSUM_MAX_PENDING)
+      {
+	Normalize();
+      }
+  }
+
+  /* the sum rounded to a double */
+  Type Value() const
+  {
+    if (special != 0 || special != special)
+      {
+	return special;
+      }
+
+    ExactSum c = *this;
+    c.Normalize();
+    bool negative = c.limbs[EXACTSUM_LIMBS - 1] < 0;
+    if (negative)
+      {
+	for (int i = 0; i < EXACTSUM_LIMBS; ++i)
+	  {
+	    c.limbs[i] = -c.limbs[i];
+	  }
+	c.Normalize();
+      }
+
+    /* digits are non-overlapping, so adding them from the least
+     * significant up loses only what the last additions round off */
+    Type r = 0;
+    for (int i = 0; i < EXACTSUM_LIMBS; ++i)
+      {
+	if (c.limbs[i])
+	  {
+	    r += std::ldexp((Type)c.limbs[i], 32*i - 1074);
+	  }
+      }
+    return negative ? -r : r;
+  }
+};
+#endif
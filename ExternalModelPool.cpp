@@ -0,0 +1,412 @@
+#include "ExternalModelPool.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* Ctor
+ * Input:
+ *
+ * command_ = program to run and its arguments, looked up in PATH
+ * numWorkers = number of worker processes, 0 for one per hardware
+ *   thread
+ * timeout_ = milliseconds a worker with queued work may go without
+ *   reading or answering, and that a stopped worker gets to exit,
+ *   before it is killed; <= 0 waits forever
+ */
+ExternalModelPool::
+ExternalModelPool(const std::vector<std::string> &command_,
+		  unsigned int numWorkers, int timeout_)
+{
+  command = command_;
+  timeout = timeout_;
+  if (numWorkers == 0)
+    {
+      numWorkers = std::thread::hardware_concurrency();
+    }
+  if (numWorkers == 0)
+    {
+      numWorkers = 1;
+    }
+
+  /* a worker that exits makes writes fail with EPIPE instead of
+   * killing this process */
+  signal(SIGPIPE, SIG_IGN);
+
+  workers.resize(numWorkers);
+  for (auto& i : workers)
+    {
+      Start(i);
+    }
+}
+
+/* Forks and execs one worker with pipes on its stdin and stdout */
+bool ExternalModelPool::Start(ExternalWorker &worker)
+{
+  worker.alive = false;
+  worker.pid = -1;
+  worker.toFd = worker.fromFd = -1;
+  worker.outPos = 0;
+  if (command.empty())
+    {
+      return false;
+    }
+
+  /* close-on-exec, so no worker inherits another worker's pipes */
+  int toChild[2], fromChild[2];
+  if (pipe2(toChild, O_CLOEXEC) != 0)
+    {
+      return false;
+    }
+  if (pipe2(fromChild, O_CLOEXEC) != 0)
+    {
+      close(toChild[0]);
+      close(toChild[1]);
+      return false;
+    }
+
+  std::vector<char*> args;
+  for (auto& i : command)
+    {
+      args.push_back(const_cast<char*>(i.c_str()));
+    }
+  args.push_back(NULL);
+
+  pid_t pid = fork();
+  if (pid == 0)
+    {
+      dup2(toChild[0], STDIN_FILENO);
+      dup2(fromChild[1], STDOUT_FILENO);
+      execvp(args[0], &args[0]);
+      _exit(127);
+    }
+
+  close(toChild[0]);
+  close(fromChild[1]);
+  if (pid < 0)
+    {
+      close(toChild[1]);
+      close(fromChild[0]);
+      std::cout << "cannot start " << command[0] << "\n";
+      return false;
+    }
+
+  fcntl(toChild[1], F_SETFL, fcntl(toChild[1], F_GETFL) | O_NONBLOCK);
+  worker.pid = pid;
+  worker.toFd = toChild[1];
+  worker.fromFd = fromChild[0];
+  worker.alive = true;
+  return true;
+}
+
+/* Closes the worker's stdin, which ends it, and reaps it.  A worker
+ * that has not exited after timeout milliseconds, or any worker if
+ * kill, is killed with SIGKILL first.  Work queued at the worker is
+ * dropped. */
+void ExternalModelPool::Stop(ExternalWorker &worker, bool kill)
+{
+  if (worker.toFd >= 0)
+    {
+      close(worker.toFd);
+    }
+  if (worker.fromFd >= 0)
+    {
+      close(worker.fromFd);
+    }
+  if (worker.pid > 0)
+    {
+      std::chrono::steady_clock::time_point giveUp
+	= std::chrono::steady_clock::now()
+	+ std::chrono::milliseconds(timeout);
+      while (!kill && waitpid(worker.pid, NULL, WNOHANG) == 0)
+	{
+	  if (timeout > 0 && std::chrono::steady_clock::now() >= giveUp)
+	    {
+	      std::cout << "model worker " << worker.pid
+			<< " did not exit, killing it\n";
+	      kill = true;
+	      break;
+	    }
+	  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+      if (kill)
+	{
+	  ::kill(worker.pid, SIGKILL);
+	  waitpid(worker.pid, NULL, 0);
+	}
+    }
+  worker.toFd = worker.fromFd = -1;
+  worker.pid = -1;
+  worker.alive = false;
+  worker.inFlight.clear();
+  worker.out.clear();
+  worker.outPos = 0;
+  worker.in.clear();
+}
+
+/* Restarts the worker's timeout, after it has read or answered */
+void ExternalModelPool::Touch(ExternalWorker &worker)
+{
+  worker.deadline = std::chrono::steady_clock::now()
+    + std::chrono::milliseconds(timeout);
+}
+
+/* Returns the number of workers still running */
+unsigned int ExternalModelPool::GetNumWorkers()
+{
+  std::lock_guard<std::mutex> lock(poolMutex);
+  unsigned int alive = 0;
+  for (const auto& i : workers)
+    {
+      alive += i.alive;
+    }
+  return alive;
+}
+
+/* Evaluates the model at the n points stored row-major in X (n x dim)
+ * and writes the outputs to Y.  Returns false, with NaN for the points
+ * not evaluated, if every worker has died or sent a malformed reply. */
+bool ExternalModelPool::
+Evaluate(const Type *X, unsigned int n, int dim,
+	 const std::vector<Type> &constants, Type *Y)
+{
+  std::lock_guard<std::mutex> lock(poolMutex);
+
+  bool anyAlive = false;
+  for (const auto& i : workers)
+    {
+      anyAlive |= i.alive;
+    }
+  if (!anyAlive)
+    {
+      std::fill(Y, Y + n, NAN);
+      return false;
+    }
+
+  /* blocks small enough that every worker gets EXTMODEL_IN_FLIGHT */
+  size_t perWorker = (n + EXTMODEL_IN_FLIGHT*workers.size() - 1)
+    /(EXTMODEL_IN_FLIGHT*workers.size());
+  size_t blockSize = std::max((size_t)1,
+			      std::min((size_t)EXTMODEL_BATCH, perWorker));
+  size_t numBlocks = (n + blockSize - 1)/blockSize;
+  std::deque<size_t> pending;
+  for (size_t b = 0; b < numBlocks; ++b)
+    {
+      pending.push_back(b);
+    }
+  size_t done = 0;
+
+  std::vector<struct pollfd> fds;
+  std::vector<ExternalWorker*> polled;
+  while (done < numBlocks)
+    {
+      /* top up every worker's queue */
+      for (auto& w : workers)
+	{
+	  if (w.alive && !pending.empty() && w.inFlight.empty())
+	    {
+	      Touch(w);
+	    }
+	  while (w.alive && !pending.empty()
+		 && w.inFlight.size() < EXTMODEL_IN_FLIGHT)
+	    {
+	      size_t b = pending.front();
+	      pending.pop_front();
+	      uint32_t head[3] = {(uint32_t)std::min(blockSize,
+						     n - b*blockSize),
+				  (uint32_t)dim,
+				  (uint32_t)constants.size()};
+	      const char *points = (const char*)(X + b*blockSize*dim);
+	      const char *c = (const char*)constants.data();
+	      w.out.insert(w.out.end(), (const char*)head,
+			   (const char*)head + sizeof(head));
+	      w.out.insert(w.out.end(), points,
+			   points + (size_t)head[0]*dim*sizeof(Type));
+	      w.out.insert(w.out.end(), c,
+			   c + constants.size()*sizeof(Type));
+	      w.inFlight.push_back(b);
+	    }
+	}
+
+      /* wait no longer than the first deadline of a busy worker */
+      std::chrono::steady_clock::time_point now
+	= std::chrono::steady_clock::now();
+      int wait = -1;
+      fds.clear();
+      polled.clear();
+      for (auto& w : workers)
+	{
+	  if (!w.alive || w.inFlight.empty())
+	    {
+	      continue;
+	    }
+	  if (timeout > 0)
+	    {
+	      long long left = std::chrono::duration_cast
+		<std::chrono::milliseconds>(w.deadline - now).count() + 1;
+	      left = std::max(0LL, left);
+	      if (wait < 0 || left < wait)
+		{
+		  wait = (int)left;
+		}
+	    }
+	  struct pollfd in = {w.fromFd, POLLIN, 0};
+	  fds.push_back(in);
+	  polled.push_back(&w);
+	  if (w.outPos < w.out.size())
+	    {
+	      struct pollfd out = {w.toFd, POLLOUT, 0};
+	      fds.push_back(out);
+	      polled.push_back(&w);
+	    }
+	}
+      if (fds.empty())
+	{
+	  std::cout << "no model workers left, " << numBlocks - done
+		    << " blocks not evaluated\n";
+	  break;
+	}
+      if (poll(&fds[0], fds.size(), wait) < 0)
+	{
+	  if (errno == EINTR)
+	    {
+	      continue;
+	    }
+	  break;
+	}
+
+      for (size_t f = 0; f < fds.size(); ++f)
+	{
+	  ExternalWorker &w = *polled[f];
+	  if (!w.alive || fds[f].revents == 0)
+	    {
+	      continue;
+	    }
+	  bool failed = false;
+	  Touch(w);
+
+	  if (fds[f].fd == w.toFd)
+	    {
+	      ssize_t k = write(w.toFd, &w.out[w.outPos],
+				w.out.size() - w.outPos);
+	      if (k > 0)
+		{
+		  w.outPos += k;
+		  if (w.outPos == w.out.size())
+		    {
+		      w.out.clear();
+		      w.outPos = 0;
+		    }
+		}
+	      else if (k < 0 && errno != EAGAIN && errno != EINTR)
+		{
+		  failed = true;
+		}
+	    }
+	  else
+	    {
+	      char buffer[65536];
+	      ssize_t k = read(w.fromFd, buffer, sizeof(buffer));
+	      if (k > 0)
+		{
+		  w.in.insert(w.in.end(), buffer, buffer + k);
+		}
+	      else if (k == 0 || (errno != EAGAIN && errno != EINTR))
+		{
+		  failed = true;
+		}
+
+	      /* take the complete replies */
+	      while (!failed && w.in.size() >= sizeof(uint32_t))
+		{
+		  if (w.inFlight.empty())
+		    {
+		      failed = true;  /* reply nobody asked for */
+		      break;
+		    }
+		  uint32_t count;
+		  std::memcpy(&count, &w.in[0], sizeof(count));
+		  size_t b = w.inFlight.front();
+		  size_t rows = std::min(blockSize, n - b*blockSize);
+		  if (count != rows)
+		    {
+		      failed = true;
+		      break;
+		    }
+		  size_t length = sizeof(count) + rows*sizeof(Type);
+		  if (w.in.size() < length)
+		    {
+		      break;
+		    }
+		  std::memcpy(Y + b*blockSize, &w.in[sizeof(count)],
+			      rows*sizeof(Type));
+		  w.in.erase(w.in.begin(), w.in.begin() + length);
+		  w.inFlight.pop_front();
+		  ++done;
+		}
+	    }
+
+	  if (failed)
+	    {
+	      std::cout << "model worker " << w.pid << " failed\n";
+	      pending.insert(pending.end(), w.inFlight.begin(),
+			     w.inFlight.end());
+	      Stop(w);
+	    }
+	}
+
+      /* workers that let their deadline pass without a byte moving */
+      now = std::chrono::steady_clock::now();
+      for (auto& w : workers)
+	{
+	  if (timeout > 0 && w.alive && !w.inFlight.empty()
+	      && now >= w.deadline)
+	    {
+	      std::cout << "model worker " << w.pid << " timed out after "
+			<< timeout << " ms, killing it\n";
+	      pending.insert(pending.end(), w.inFlight.begin(),
+			     w.inFlight.end());
+	      Stop(w, true);
+	    }
+	}
+    }
+
+  if (done < numBlocks)
+    {
+      /* a live worker may still hold part of a request or owe a reply,
+       * which the next call would take for its own: restart it */
+      for (auto& w : workers)
+	{
+	  pending.insert(pending.end(), w.inFlight.begin(), w.inFlight.end());
+	  if (w.alive && (!w.inFlight.empty() || !w.in.empty()))
+	    {
+	      Stop(w, true);
+	      Start(w);
+	    }
+	}
+      for (auto b : pending)
+	{
+	  std::fill(Y + b*blockSize,
+		    Y + std::min((size_t)n, (b + 1)*blockSize), NAN);
+	}
+      return false;
+    }
+  return true;
+}
+
+/* Dtor: ends and reaps the workers, killing those that do not exit
+ * within the timeout */
+ExternalModelPool::~ExternalModelPool()
+{
+  for (auto& i : workers)
+    {
+      Stop(i);
+    }
+}
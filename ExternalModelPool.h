@@ -0,0 +1,76 @@
+/* Class ExternalModelPool evaluates a model that is a separate
+ * executable.  It starts numWorkers copies of the program once and
+ * keeps them running, streaming blocks of points to their stdin and
+ * reading the outputs from their stdout, so a model run costs a pipe
+ * round trip instead of a process start.  Each worker only ever has
+ * one evaluation running, so legacy codes that are not thread safe
+ * still use all cores.
+ *
+ * Framing, native byte order, one request per block:
+ *
+ *   request:  uint32 n, uint32 dim, uint32 numConstants,
+ *             n*dim doubles (row-major points), numConstants doubles
+ *   reply:    uint32 n, n doubles (the outputs, in point order)
+ *
+ * A worker loops reading requests until end of file on stdin, and must
+ * flush stdout after each reply; see ExternalModelWorker.cpp.
+ * Evaluate() splits the points into blocks, keeps up to
+ * EXTMODEL_IN_FLIGHT blocks queued at every worker, and gives the
+ * blocks of a worker that dies to the others.  A worker that has work
+ * queued but neither reads nor answers for timeout milliseconds is
+ * taken as hung: it is killed with SIGKILL and reaped, and its blocks
+ * too go to the others.
+ */
+
+#ifndef EXTERNALMODELPOOL_H
+#define EXTERNALMODELPOOL_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#define EXTMODEL_BATCH 256  /* most points per request */
+#define EXTMODEL_IN_FLIGHT 2  /* requests queued at a worker */
+#define EXTMODEL_TIMEOUT 60000  /* default timeout, in milliseconds */
+
+typedef double Type;
+
+struct ExternalWorker
+{
+  pid_t pid;
+  int toFd, fromFd;  /* worker's stdin and stdout */
+  bool alive;
+  std::deque<size_t> inFlight;  /* blocks sent, oldest first */
+  std::vector<char> out;  /* encoded requests not yet written */
+  size_t outPos;
+  std::vector<char> in;  /* reply bytes read so far */
+  /* hung if no bytes move before this, while inFlight is not empty */
+  std::chrono::steady_clock::time_point deadline;
+};
+
+class ExternalModelPool
+{
+ private:
+  std::vector<std::string> command;  /* program and its arguments */
+  std::vector<ExternalWorker> workers;
+  std::mutex poolMutex;  /* one Evaluate() at a time */
+  int timeout;  /* milliseconds, <= 0 waits forever */
+
+  bool Start(ExternalWorker &worker);
+  void Stop(ExternalWorker &worker, bool kill = false);
+  void Touch(ExternalWorker &worker);
+
+ public:
+  ExternalModelPool(const std::vector<std::string> &command_,
+		    unsigned int numWorkers = 0,
+		    int timeout_ = EXTMODEL_TIMEOUT);
+  unsigned int GetNumWorkers();
+  bool Evaluate(const Type *X, unsigned int n, int dim,
+		const std::vector<Type> &constants, Type *Y);
+  ~ExternalModelPool();
+};
+#endif
@@ -0,0 +1,53 @@
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+typedef double Type;
+
+/* Example model program for ExternalModelPool: the linear model of
+ * ModelRegistry, Y = c*(x_1 + ... + x_dim) with c = constants[0] if
+ * given, 1 otherwise, speaking the pool's binary framing on stdin and
+ * stdout.  A wrapper around a legacy code keeps this loop and replaces
+ * the evaluation.
+ *
+ * Usage: run by the pool, e.g.
+ *   ./a.out SobolBatchJobs.txt BatchResults.txt exec:./linear_worker
+ */
+static bool ReadAll(void *buffer, size_t length)
+{
+  return fread(buffer, 1, length, stdin) == length;
+}
+
+int main()
+{
+  uint32_t head[3];
+  std::vector<Type> X, constants, Y;
+
+  /* one request per loop, until the pool closes stdin */
+  while (ReadAll(head, sizeof(head)))
+    {
+      uint32_t n = head[0], dim = head[1], numConstants = head[2];
+      X.resize((size_t)n*dim);
+      constants.resize(numConstants);
+      if (!ReadAll(X.data(), X.size()*sizeof(Type))
+	  || !ReadAll(constants.data(), constants.size()*sizeof(Type)))
+	{
+	  return 1;
+	}
+
+      Type c = constants.empty() ? 1.0 : constants[0];
+      Y.assign(n, 0.0);
+      for (uint32_t i = 0; i < n; ++i)
+	{
+	  for (uint32_t j = 0; j < dim; ++j)
+	    {
+	      Y[i] += c*X[(size_t)i*dim + j];
+	    }
+	}
+
+      fwrite(&n, sizeof(n), 1, stdout);
+      fwrite(Y.data(), sizeof(Type), n, stdout);
+      fflush(stdout);
+    }
+  return 0;
+}
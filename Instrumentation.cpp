@@ -0,0 +1,109 @@
+#include "Instrumentation.h"
+#include <fstream>
+#include <iostream>
+
+std::atomic<bool> Instrumentation::enabled(false);
+std::mutex Instrumentation::registryMutex;
+std::vector<std::unique_ptr<PhaseCounters> >
+Instrumentation::threadCounters;
+
+/* Returns the calling thread's counters, registering them on first
+ * use */
+PhaseCounters& Instrumentation::Local()
+{
+  thread_local PhaseCounters *counters = NULL;
+  if (counters == NULL)
+    {
+      std::lock_guard<std::mutex> lock(registryMutex);
+      threadCounters.push_back(std::unique_ptr<PhaseCounters>
+			       (new PhaseCounters()));
+      counters = threadCounters.back().get();
+    }
+  return *counters;
+}
+
+const char* Instrumentation::PhaseName(int phase)
+{
+  static const char *names[NUM_PHASES] =
+    {"genHalton", "transform", "assign", "model", "accumulate",
+     "super_genHalton", "super_transform", "super_assign", "super_sobol",
+     "super_accumulate"};
+  return names[phase];
+}
+
+/* Zeroes the counters of all threads.  Call while no instrumented
+ * computation is running. */
+void Instrumentation::Reset()
+{
+  std::lock_guard<std::mutex> lock(registryMutex);
+  for (auto& counters : threadCounters)
+    {
+      *counters = PhaseCounters();
+    }
+}
+
+/* Writes the per-thread and total counters to filename as JSON.
+ * wallSeconds is the wall time of the whole run, for reference.  Call
+ * while no instrumented computation is running.
+ *
+ * Output:
+ *   true if the file was written
+ */
+bool Instrumentation::WriteJSON(const std::string &filename,
+				double wallSeconds)
+{
+  std::ofstream file(filename.c_str());
+  if (!file.is_open())
+    {
+      std::cout << "unable to open instrumentation file " << filename
+		<< "\n";
+      return false;
+    }
+
+  std::lock_guard<std::mutex> lock(registryMutex);
+
+  PhaseCounters total;
+  for (const auto& counters : threadCounters)
+    {
+      for (int p = 0; p < NUM_PHASES; ++p)
+	{
+	  total.calls[p] += counters->calls[p];
+	  total.ns[p] += counters->ns[p];
+	}
+    }
+
+  /* writes the phases that were hit as a JSON object */
+  auto writePhases = [&](const PhaseCounters &counters)
+    {
+      file << "{";
+      bool first = true;
+      for (int p = 0; p < NUM_PHASES; ++p)
+	{
+	  if (counters.calls[p] == 0)
+	    {
+	      continue;
+	    }
+	  file << (first ? "" : ", ") << "\"" << PhaseName(p)
+	       << "\": {\"calls\": " << counters.calls[p]
+	       << ", \"seconds\": " << counters.ns[p]*1e-9
+	       << ", \"ns_per_call\": "
+	       << (double)counters.ns[p]/counters.calls[p] << "}";
+	  first = false;
+	}
+      file << "}";
+    };
+
+  file << "{\n  \"wall_seconds\": " << wallSeconds
+       << ",\n  \"threads\": [\n";
+  for (size_t t = 0; t < threadCounters.size(); ++t)
+    {
+      file << "    ";
+      writePhases(*threadCounters[t]);
+      file << (t + 1 < threadCounters.size() ? ",\n" : "\n");
+    }
+  file << "  ],\n  \"total\": ";
+  writePhases(total);
+  file << "\n}\n";
+
+  return true;
+}
@@ -0,0 +1,114 @@
+/* Opt-in instrumentation of the Sobol' index hot paths.  Each phase of
+ * an MC iteration (drawing the Halton point, transforming it, assembling
+ * the model arguments, evaluating the model, accumulating the sums) is
+ * timed with std::chrono::steady_clock and counted per thread.
+ *
+ * Instrumentation is off by default; a disabled PhaseTimer costs one
+ * relaxed atomic load and a branch.  Typical use:
+ *
+ *   Instrumentation::Enable(true);
+ *   sobol.ComputeSensitivityIndices();
+ *   Instrumentation::WriteJSON("Instrumentation.json", wallSeconds);
+ *
+ * The SUPER_* phases belong to ComputeSuperSobolIndices(); its
+ * SUPER_SOBOL phase contains the inner index computations, whose own
+ * phases are reported separately.
+ */
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum InstrumentationPhase
+{
+  PHASE_GENHALTON = 0,
+  PHASE_TRANSFORM,
+  PHASE_ASSIGN,
+  PHASE_MODEL,
+  PHASE_ACCUMULATE,
+  PHASE_SUPER_GENHALTON,
+  PHASE_SUPER_TRANSFORM,
+  PHASE_SUPER_ASSIGN,
+  PHASE_SUPER_SOBOL,
+  PHASE_SUPER_ACCUMULATE,
+  NUM_PHASES
+};
+
+/* call counts and accumulated wall time of one thread */
+struct PhaseCounters
+{
+  unsigned long long calls[NUM_PHASES];
+  unsigned long long ns[NUM_PHASES];
+
+  PhaseCounters()
+  {
+    for (int p = 0; p < NUM_PHASES; ++p)
+      {
+	calls[p] = 0;
+	ns[p] = 0;
+      }
+  }
+};
+
+class Instrumentation
+{
+ private:
+  static std::atomic<bool> enabled;
+  static std::mutex registryMutex;  /* guards threadCounters */
+  /* one entry per thread that recorded anything; never shrinks, so
+   * the thread_local pointers stay valid after Reset() */
+  static std::vector<std::unique_ptr<PhaseCounters> > threadCounters;
+
+ public:
+  static void Enable(bool enabled_)
+  {
+    enabled.store(enabled_, std::memory_order_relaxed);
+  }
+  static bool IsEnabled()
+  {
+    return enabled.load(std::memory_order_relaxed);
+  }
+  static PhaseCounters& Local();
+  static const char* PhaseName(int phase);
+  static void Reset();
+  static bool WriteJSON(const std::string &filename, double wallSeconds);
+};
+
+/* Adds the steady_clock time between construction and destruction to
+ * phase, plus calls_ calls, in the calling thread's counters */
+class PhaseTimer
+{
+ private:
+  int phase;
+  unsigned long long calls;
+  bool active;
+  std::chrono::steady_clock::time_point tic;
+
+ public:
+  PhaseTimer(int phase_, unsigned long long calls_ = 1)
+    : phase(phase_), calls(calls_), active(Instrumentation::IsEnabled())
+  {
+    if (active)
+      {
+	tic = std::chrono::steady_clock::now();
+      }
+  }
+  ~PhaseTimer()
+  {
+    if (active)
+      {
+	PhaseCounters &counters = Instrumentation::Local();
+	counters.ns[phase] += std::chrono::duration_cast
+	  <std::chrono::nanoseconds>(std::chrono::steady_clock::now()
+				     - tic).count();
+	counters.calls[phase] += calls;
+      }
+  }
+};
+#endif
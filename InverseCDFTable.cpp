@@ -0,0 +1,185 @@
+#include "InverseCDFTable.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+/* Returns knot i (0..INVCDF_SIDE + 1) of a half in the tail variable
+ * q: cell i spans [KnotQ(i), KnotQ(i+1)] */
+Type InverseCDFTable::KnotQ(int i)
+{
+  int j = i/INVCDF_CELLS, m = i % INVCDF_CELLS;
+  return ldexp(1.0 + (Type)m/INVCDF_CELLS, j - INVCDF_OCTAVES);
+}
+
+/* Builds the table from the quantile function, evaluated at every knot
+ * (2*INVCDF_SIDE + 2 calls).  Returns false if a value is not
+ * finite. */
+bool InverseCDFTable::
+BuildFromQuantile(const std::function<Type(Type)> &quantile)
+{
+  /* knot INVCDF_SIDE + 1 lies past u = 1/2, in the other half, and
+   * only serves the slope at u = 1/2 */
+  std::vector<Type> xLower(INVCDF_SIDE + 2), xUpper(INVCDF_SIDE + 2);
+  for (int i = 0; i <= INVCDF_SIDE + 1; ++i)
+    {
+      Type q = KnotQ(i);
+      xLower[i] = quantile(0.5*q);
+      xUpper[i] = quantile(1.0 - 0.5*q);
+    }
+  return BuildFromKnots(xLower, xUpper);
+}
+
+/* Builds the table from a CDF by solving cdf(x) = u at every knot by
+ * bisection.  [lower, upper] is the initial bracket; it is widened as
+ * needed, so for unbounded support any interval will do.  cdf must be
+ * nondecreasing. */
+bool InverseCDFTable::
+BuildFromCDF(const std::function<Type(Type)> &cdf, Type lower, Type upper)
+{
+  if (!(lower < upper))
+    {
+      std::cout << "InverseCDFTable: need lower < upper\n";
+      return false;
+    }
+
+  auto quantile = [&](Type u)
+    {
+      Type lo = lower, hi = upper, width = upper - lower;
+      for (int i = 0; i < 1100 && cdf(lo) > u; ++i, width *= 2)
+	{
+	  lo -= width;
+	}
+      for (int i = 0; i < 1100 && cdf(hi) < u; ++i, width *= 2)
+	{
+	  hi += width;
+	}
+      for (int i = 0; i < 200; ++i)
+	{
+	  Type mid = 0.5*(lo + hi);
+	  if (mid <= lo || mid >= hi)
+	    {
+	      break;
+	    }
+	  if (cdf(mid) < u)
+	    {
+	      lo = mid;
+	    }
+	  else
+	    {
+	      hi = mid;
+	    }
+	}
+      return 0.5*(lo + hi);
+    };
+  return BuildFromQuantile(quantile);
+}
+
+/* Builds the table of the empirical distribution of samples: the
+ * quantile interpolates linearly between the sorted samples, sample i
+ * (0 based) at u = (i + 0.5)/n, and is flat beyond the first and last
+ * ones.  Needs at least two samples. */
+bool InverseCDFTable::BuildFromSamples(const std::vector<Type> &samples)
+{
+  if (samples.size() < 2)
+    {
+      std::cout << "InverseCDFTable: need at least two samples\n";
+      return false;
+    }
+  std::vector<Type> sorted(samples);
+  std::sort(sorted.begin(), sorted.end());
+  size_t n = sorted.size();
+
+  auto quantile = [&](Type u)
+    {
+      Type t = u*n - 0.5;
+      if (t <= 0)
+	{
+	  return sorted[0];
+	}
+      if (t >= n - 1)
+	{
+	  return sorted[n-1];
+	}
+      size_t i = (size_t)t;
+      Type w = t - i;
+      return (1 - w)*sorted[i] + w*sorted[i+1];
+    };
+  return BuildFromQuantile(quantile);
+}
+
+/* Fits the monotone cubics of both halves to the knot values and
+ * stores their coefficients */
+bool InverseCDFTable::
+BuildFromKnots(const std::vector<Type> &xLower,
+	       const std::vector<Type> &xUpper)
+{
+  const int n = INVCDF_SIDE;
+  std::vector<Type> newCoef(8*n);
+  std::vector<Type> h(n + 1), delta(n + 1), d(n + 1);
+
+  for (int side = 0; side < 2; ++side)
+    {
+      const std::vector<Type> &x = side ? xUpper : xLower;
+      for (int i = 0; i <= n + 1; ++i)
+	{
+	  if (!std::isfinite(x[i]))
+	    {
+	      std::cout << "InverseCDFTable: quantile not finite at knot "
+			<< i << "\n";
+	      return false;
+	    }
+	}
+
+      /* secants, and slopes of the three-point parabola, limited to
+       * three times the smaller neighbouring secant and set to 0 at a
+       * change of direction (Hyman's filter), which keeps the cubics
+       * monotone */
+      for (int i = 0; i <= n; ++i)
+	{
+	  h[i] = KnotQ(i+1) - KnotQ(i);
+	  delta[i] = (x[i+1] - x[i])/h[i];
+	}
+      d[0] = ((2*h[0] + h[1])*delta[0] - h[0]*delta[1])/(h[0] + h[1]);
+      if (d[0]*delta[0] <= 0)
+	{
+	  d[0] = 0;
+	}
+      for (int i = 1; i <= n; ++i)
+	{
+	  if (delta[i-1]*delta[i] <= 0)
+	    {
+	      d[i] = 0;
+	    }
+	  else
+	    {
+	      Type limit = 3*std::min(fabs(delta[i-1]), fabs(delta[i]));
+	      d[i] = (h[i]*delta[i-1] + h[i-1]*delta[i])/(h[i-1] + h[i]);
+	      d[i] = copysign(std::min(fabs(d[i]), limit), delta[i]);
+	    }
+	}
+
+      /* Hermite cubic of cell i in s = (q - q_i)/h_i */
+      for (int i = 0; i < n; ++i)
+	{
+	  Type *c = &newCoef[4*(side*n + i)];
+	  Type d0 = h[i]*d[i], d1 = h[i]*d[i+1], dx = x[i+1] - x[i];
+	  c[0] = x[i];
+	  c[1] = d0;
+	  c[2] = 3*dx - 2*d0 - d1;
+	  c[3] = -2*dx + d0 + d1;
+	}
+    }
+
+  coef.swap(newCoef);
+  return true;
+}
+
+/* Transforms n numbers u in (0,1) into x; the loop body is
+ * branch-free */
+void InverseCDFTable::Evaluate(const Type *u, Type *x, size_t n) const
+{
+  for (size_t i = 0; i < n; ++i)
+    {
+      x[i] = Evaluate(u[i]);
+    }
+}
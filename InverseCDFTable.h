@@ -0,0 +1,88 @@
+/* Class InverseCDFTable is a precomputed inverse CDF (quantile
+ * function) for marginals without a cheap closed-form inverse: CDFs
+ * that must be root-solved, empirical samples, or the iterative Gamma
+ * and Beta inverses of InverseTransformation.  The quantile is
+ * evaluated once at the knots of a fixed grid when the table is built;
+ * after that each transform is a table lookup and one cubic.
+ *
+ * Grid: u is folded to the tail variable q = 2 min(u, 1-u) in (0,1]
+ * and the two halves of (0,1) get their own cells.  Each half is split
+ * into octaves q in [2^-(k+1), 2^-k), k = 0..INVCDF_OCTAVES-1, and each
+ * octave into INVCDF_CELLS equal cells, so cells get finer towards the
+ * tails in proportion to q.  The octave and cell of q are its binary
+ * exponent and top mantissa bits, so the lookup needs no search, no log
+ * and no branches.  u closer to 0 or 1 than 2^-(INVCDF_OCTAVES+1) is
+ * clamped to the last knot.
+ *
+ * Between knots the quantile is a piecewise cubic Hermite
+ * interpolant.  The knot slopes are those of the three-point parabola,
+ * passed through Hyman's monotonicity filter (at most three times the
+ * smaller neighbouring secant, 0 where the secants change sign), so
+ * the table is monotone whenever the data are.
+ */
+
+#ifndef INVERSECDFTABLE_H
+#define INVERSECDFTABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#define INVCDF_OCTAVES 50  /* octaves of q per half, down to 2^-50 */
+#define INVCDF_CELLS_LOG2 5
+#define INVCDF_CELLS (1 << INVCDF_CELLS_LOG2)  /* cells per octave */
+#define INVCDF_SIDE (INVCDF_OCTAVES*INVCDF_CELLS)  /* cells per half */
+
+typedef double Type;
+
+class InverseCDFTable
+{
+ private:
+  /* 4 Horner coefficients of the cubic of each cell, in the local
+   * variable s in [0,1]; lower half then upper half, q increasing */
+  std::vector<Type> coef;
+
+  static Type KnotQ(int i);
+  bool BuildFromKnots(const std::vector<Type> &xLower,
+		      const std::vector<Type> &xUpper);
+
+ public:
+  InverseCDFTable() {}
+  bool IsBuilt() const {return !coef.empty();}
+  bool BuildFromQuantile(const std::function<Type(Type)> &quantile);
+  bool BuildFromCDF(const std::function<Type(Type)> &cdf, Type lower,
+		    Type upper);
+  bool BuildFromSamples(const std::vector<Type> &samples);
+  Type Evaluate(Type u) const;
+  void Evaluate(const Type *u, Type *x, size_t n) const;
+};
+
+/* Returns the quantile at u in (0,1) */
+inline Type InverseCDFTable::Evaluate(Type u) const
+{
+  const Type qMin = 1.0/(1ULL << INVCDF_OCTAVES);
+  const Type qMax = 1.0 - 1.0/(1ULL << 53);
+  const int fracBits = 52 - INVCDF_CELLS_LOG2;
+
+  /* fold to q = 2u (lower half) or 2(1-u) (upper half) */
+  int upper = u > 0.5;
+  Type q = 2.0*u + upper*(2.0 - 4.0*u);
+  q = std::min(std::max(q, qMin), qMax);
+
+  /* octave from the exponent, cell and position from the mantissa */
+  uint64_t bits;
+  std::memcpy(&bits, &q, sizeof(bits));
+  int k = 1022 - (int)(bits >> 52);
+  uint64_t mantissa = bits & ((1ULL << 52) - 1);
+  int m = (int)(mantissa >> fracBits);
+  Type s = (Type)(mantissa & ((1ULL << fracBits) - 1))
+    *(1.0/(1ULL << fracBits));
+
+  const Type *c = &coef[4*(upper*INVCDF_SIDE
+			   + (INVCDF_OCTAVES - 1 - k)*INVCDF_CELLS + m)];
+  return c[0] + s*(c[1] + s*(c[2] + s*c[3]));
+}
+#endif
@@ -58,6 +58,28 @@ Type InverseTransformation::GenPareto(Type k, Type sigma, Type theta)
   return result;
 }
 
+/* Fills values with n samples from the Generalized Pareto
+ * distribution.  The uniforms are drawn in bulk from the DSFMT
+ * generator, then transformed in one pass.
+ *
+ * Input:
+ * k = shape parameter
+ * sigma = scale parameter, > 0
+ * theta = location parameter
+ * values = output array of length n
+ */
+void InverseTransformation::GenPareto(Type k, Type sigma, Type theta,
+				      Type *values, size_t n)
+{
+  /* u in [0,1), so 1-u is never 0 */
+  bulkRNG.fill(values, n);
+  Type scale = sigma/k;
+  for (size_t i = 0; i < n; ++i)
+    {
+      values[i] = theta + scale*(std::pow(1.0 - values[i], -k) - 1);
+    }
+}
+
 /* Returns a normally-distributed pseudo-/quasi- random number.
  * Input:
  * 
@@ -98,86 +120,953 @@ Type InverseTransformation::Uniform(Type u, Type a, Type b)
   return (b-a)*u + a;
 }
 
-/* Function AndersonDarlingNormal computes the Anderson Darling test
- * statistic for a standard normal distribution.  The vector "values"
- * is sorted in this function.  This function
- * normalizes the data to N(0,1) before computing the Anderson
- * Darling statistic for a standard normal, A^2.
+/* Returns a lognormal number: exp of a normal number with the given
+ * mean and variance */
+Type InverseTransformation::LogNormal(Type u, Type mean, Type variance)
+{
+  return exp(Normal(u, mean, variance));
+}
+
+/* Returns an exponentially-distributed number with rate lambda */
+Type InverseTransformation::Exponential(Type u, Type lambda)
+{
+  return -log1p(-u)/lambda;
+}
+
+/* Returns a Gamma(k, theta) number, shape k and scale theta, by
+ * inverting the regularized incomplete gamma function P(k, x): a
+ * Wilson-Hilferty (k > 1) or power-law (k <= 1) first guess followed by
+ * Halley steps, as invgammp of Numerical Recipes, 3rd ed., 6.2.1.
+ */
+Type InverseTransformation::Gamma(Type u, Type k, Type theta)
+{
+  const Type eps = 1e-12;
+  if (u <= 0)
+    {
+      return 0;
+    }
+  if (u >= 1)
+    {
+      return theta*std::max(100.0, k + 100*sqrt(k));
+    }
+
+  Type k1 = k - 1, gln = lgamma(k), lnk1 = 0, afac = 0, x, t;
+  if (k > 1)
+    {
+      lnk1 = log(k1);
+      afac = exp(k1*(lnk1 - 1) - gln);
+      Type pp = (u < 0.5) ? u : 1 - u;
+      t = sqrt(-2*log(pp));
+      x = (2.30753 + t*0.27061)/(1 + t*(0.99229 + t*0.04481)) - t;
+      if (u < 0.5)
+	{
+	  x = -x;
+	}
+      x = std::max(1e-3, k*pow(1 - 1/(9*k) - x/(3*sqrt(k)), 3));
+    }
+  else
+    {
+      t = 1 - k*(0.253 + k*0.12);
+      if (u < t)
+	{
+	  x = pow(u/t, 1/k);
+	}
+      else
+	{
+	  x = 1 - log(1 - (u - t)/(1 - t));
+	}
+    }
+
+  for (int j = 0; j < 12; ++j)
+    {
+      if (x <= 0)
+	{
+	  return 0;
+	}
+      Type err = GammaP(k, x) - u;
+      if (k > 1)
+	{
+	  t = afac*exp(-(x - k1) + k1*(log(x) - lnk1));
+	}
+      else
+	{
+	  t = exp(-x + k1*log(x) - gln);
+	}
+      if (t == 0)
+	{
+	  break;
+	}
+      Type r = err/t;
+      t = r/(1 - 0.5*std::min(1.0, r*(k1/x - 1)));
+      x -= t;
+      if (x <= 0)
+	{
+	  x = 0.5*(x + t);
+	}
+      if (fabs(t) < eps*x)
+	{
+	  break;
+	}
+    }
+  return theta*x;
+}
+
+/* Returns a Beta(alpha, beta) number on [0,1] by inverting the
+ * regularized incomplete beta function, as invbetai of Numerical
+ * Recipes, 3rd ed., 6.4: an approximate first guess followed by Halley
+ * steps.
+ */
+Type InverseTransformation::Beta(Type u, Type alpha, Type beta)
+{
+  const Type eps = 1e-12;
+  if (u <= 0)
+    {
+      return 0;
+    }
+  if (u >= 1)
+    {
+      return 1;
+    }
+
+  Type a1 = alpha - 1, b1 = beta - 1, x, t, w;
+  if (alpha >= 1 && beta >= 1)
+    {
+      Type pp = (u < 0.5) ? u : 1 - u;
+      t = sqrt(-2*log(pp));
+      x = (2.30753 + t*0.27061)/(1 + t*(0.99229 + t*0.04481)) - t;
+      if (u < 0.5)
+	{
+	  x = -x;
+	}
+      Type al = (x*x - 3)/6;
+      Type h = 2/(1/(2*alpha - 1) + 1/(2*beta - 1));
+      w = x*sqrt(al + h)/h
+	- (1/(2*beta - 1) - 1/(2*alpha - 1))*(al + 5.0/6 - 2/(3*h));
+      x = alpha/(alpha + beta*exp(2*w));
+    }
+  else
+    {
+      Type lna = log(alpha/(alpha + beta)), lnb = log(beta/(alpha + beta));
+      t = exp(alpha*lna)/alpha;
+      Type v = exp(beta*lnb)/beta;
+      w = t + v;
+      if (u < t/w)
+	{
+	  x = pow(alpha*w*u, 1/alpha);
+	}
+      else
+	{
+	  x = 1 - pow(beta*w*(1 - u), 1/beta);
+	}
+    }
+
+  Type afac = -lgamma(alpha) - lgamma(beta) + lgamma(alpha + beta);
+  for (int j = 0; j < 10; ++j)
+    {
+      if (x == 0 || x == 1)
+	{
+	  return x;
+	}
+      Type err = BetaI(alpha, beta, x) - u;
+      t = exp(a1*log(x) + b1*log(1 - x) + afac);
+      Type r = err/t;
+      t = r/(1 - 0.5*std::min(1.0, r*(a1/x - b1/(1 - x))));
+      x -= t;
+      if (x <= 0)
+	{
+	  x = 0.5*(x + t);
+	}
+      if (x >= 1)
+	{
+	  x = 0.5*(x + t + 1);
+	}
+      if (fabs(t) < eps*x && j > 0)
+	{
+	  break;
+	}
+    }
+  return x;
+}
+
+/* Returns a triangular number on [a,b] with mode c */
+Type InverseTransformation::Triangular(Type u, Type a, Type c, Type b)
+{
+  if (u < (c - a)/(b - a))
+    {
+      return a + sqrt(u*(b - a)*(c - a));
+    }
+  return b - sqrt((1 - u)*(b - a)*(b - c));
+}
+
+/* Returns a Weibull number with shape k and scale lambda */
+Type InverseTransformation::Weibull(Type u, Type k, Type lambda)
+{
+  return lambda*pow(-log1p(-u), 1/k);
+}
+
+/* Returns a normal number conditioned on [lower, upper].  u is mapped
+ * into [Phi(alpha), Phi(beta)] of the standardized bounds and sent
+ * through the inverse normal CDF; bounds in the upper tail use the
+ * mirrored form so that Phi does not round to 1.  The bounds may be
+ * infinite.
  */
 Type InverseTransformation::
-AndersonDarlingNormal(std::vector<Type> values, 
-		      Type mean,
-		      Type variance)
+TruncatedNormal(Type u, Type mean, Type variance, Type lower, Type upper)
 {
+  Type sd = sqrt(variance);
+  Type alpha = (lower - mean)/sd, beta = (upper - mean)/sd;
+  Type x;
+  if (alpha > 0)
+    {
+      /* upper tail probabilities Q(z) = 1 - Phi(z) */
+      Type qa = 0.5*erfc(alpha/M_SQRT2), qb = 0.5*erfc(beta/M_SQRT2);
+      x = -Normal(qa - u*(qa - qb), 0.0, 1.0);
+    }
+  else
+    {
+      Type pa = 0.5*erfc(-alpha/M_SQRT2), pb = 0.5*erfc(-beta/M_SQRT2);
+      x = Normal(pa + u*(pb - pa), 0.0, 1.0);
+    }
+  return mean + sd*std::min(std::max(x, alpha), beta);
+}
 
-  /* sort the values in increasing order */
-  std::sort(values.begin(), values.end());
+/* Returns u transformed to the distribution family (one of the
+ * *_PARAM values) with parameters params, see the header */
+Type InverseTransformation::
+Transform(Type u, int family, const std::vector<Type> &params)
+{
+  switch (family)
+    {
+    case UNIFORM_PARAM:
+      return Uniform(u, params[0], params[1]);
+    case LOGNORMAL_PARAM:
+      return LogNormal(u, params[0], params[1]);
+    case EXPONENTIAL_PARAM:
+      return Exponential(u, params[0]);
+    case GAMMA_PARAM:
+      return Gamma(u, params[0], params[1]);
+    case BETA_PARAM:
+      return Beta(u, params[0], params[1]);
+    case TRIANGULAR_PARAM:
+      return Triangular(u, params[0], params[1], params[2]);
+    case WEIBULL_PARAM:
+      return Weibull(u, params[0], params[1]);
+    case TRUNCNORMAL_PARAM:
+      return TruncatedNormal(u, params[0], params[1], params[2],
+			     params[3]);
+    default:
+      return Normal(u, params[0], params[1]);
+    }
+}
 
-  /* number of random numbers of values vector */
-  unsigned int N = values.size();
+/* Builds table, an interpolation table of the inverse CDF of family
+ * with parameters params.  Worth it for the iterative families: a
+ * Gamma or Beta inverse takes a root solve of several incomplete
+ * gamma or beta evaluations, the table a lookup and a cubic, within
+ * about 1e-6 relative.  Returns false on invalid parameters. */
+bool InverseTransformation::
+Tabulate(int family, const std::vector<Type> &params,
+	 InverseCDFTable &table)
+{
+  if (!ValidParams(family, params))
+    {
+      return false;
+    }
+  return table.BuildFromQuantile([&](Type u)
+				 {
+				   return Transform(u, family, params);
+				 });
+}
 
-  /* normalize the data in the output member vector */
-  for (int i = 0; i < N; ++i) {
-    values[i] = (values[i] - mean) / sqrt(variance);
-  }
+/* Returns the family called name in job files ("normal", "uniform",
+ * "lognormal", "exponential", "gamma", "beta", "triangular", "weibull",
+ * "truncnormal"), or -1 */
+int InverseTransformation::FamilyFromName(const std::string &name)
+{
+  static const char *names[NUM_PARAM_FAMILIES] =
+    {"normal", "uniform", "lognormal", "exponential", "gamma", "beta",
+     "triangular", "weibull", "truncnormal"};
+  for (int i = 0; i < NUM_PARAM_FAMILIES; ++i)
+    {
+      if (name == names[i])
+	{
+	  return i;
+	}
+    }
+  return -1;
+}
 
-  /* print sorted normalized data for debugging */
-  // std::cout << "output in ADN after normalizing:\n";
-  //   for (auto i : values)
-  //     std::cout << i << " ";
-  // std::cout << "\n";
+/* True if params has the right number of valid parameters for
+ * family */
+bool InverseTransformation::
+ValidParams(int family, const std::vector<Type> &params)
+{
+  static const size_t count[NUM_PARAM_FAMILIES] = {2, 2, 2, 1, 2, 2, 3, 2, 4};
+  if (family < 0 || family >= NUM_PARAM_FAMILIES
+      || params.size() != count[family])
+    {
+      return false;
+    }
 
-  /* compute the standard normal cdf values of the normalized data */
-  std::vector<Type> CDFValues;
+  switch (family)
+    {
+    case NORMAL_PARAM:
+    case LOGNORMAL_PARAM:
+      return params[1] >= 0;
+    case UNIFORM_PARAM:
+      return params[0] <= params[1];
+    case TRIANGULAR_PARAM:
+      return params[0] <= params[1] && params[1] <= params[2]
+	&& params[0] < params[2];
+    case TRUNCNORMAL_PARAM:
+      return params[1] > 0 && params[2] < params[3];
+    default:
+      /* rate, shape and scale parameters */
+      return params[0] > 0 && (params.size() < 2 || params[1] > 0);
+    }
+}
 
-  for (auto i : values) {
-    Type val = NormCDF(i);  // NormCDF = standard normal CDF
-    CDFValues.push_back(val);
-  }
+/* Regularized lower incomplete gamma function P(a, x), by its series
+ * for x < a + 1 and by the continued fraction of Q = 1 - P otherwise
+ * (modified Lentz) */
+Type InverseTransformation::GammaP(Type a, Type x)
+{
+  const Type eps = 1e-15, tiny = 1e-300;
+  if (x <= 0)
+    {
+      return 0;
+    }
+  Type gln = lgamma(a);
+  if (x < a + 1)
+    {
+      Type ap = a, del = 1/a, sum = del;
+      for (int n = 0; n < 1000; ++n)
+	{
+	  ++ap;
+	  del *= x/ap;
+	  sum += del;
+	  if (fabs(del) < fabs(sum)*eps)
+	    {
+	      break;
+	    }
+	}
+      return sum*exp(-x + a*log(x) - gln);
+    }
 
-  /* print CDFValues of normalized data for debugging */
-  // std::cout << "verifying CDFValues are sorted in ADN:\n";
-  // for (auto i : CDFValues)
-  //   std::cout << i << " ";
-  // std::cout << "\n";
+  Type b = x + 1 - a, c = 1/tiny, d = 1/b, h = d;
+  for (int i = 1; i < 1000; ++i)
+    {
+      Type an = -i*(i - a);
+      b += 2;
+      d = an*d + b;
+      if (fabs(d) < tiny)
+	{
+	  d = tiny;
+	}
+      c = b + an/c;
+      if (fabs(c) < tiny)
+	{
+	  c = tiny;
+	}
+      d = 1/d;
+      Type del = d*c;
+      h *= del;
+      if (fabs(del - 1) < eps)
+	{
+	  break;
+	}
+    }
+  return 1 - exp(-x + a*log(x) - gln)*h;
+}
 
-  /* compute sum in the Anderson-Darling statistic */
-  Type sum = 0;
-  //  Type sum2 = 0;
-  for (int i = 1; i <= N; ++i) {
-    sum += (2*i - 1) * ( log(CDFValues[i-1]) + log(1-CDFValues[N-i]) );
-    // sum2 += (2*i-1)*log(CDFValues[i-1]) + 
-    //   (2*N + 1 - 2*i)*log(1-CDFValues[i-1]);
-  }
+/* Regularized incomplete beta function I_x(a, b) */
+Type InverseTransformation::BetaI(Type a, Type b, Type x)
+{
+  if (x <= 0)
+    {
+      return 0;
+    }
+  if (x >= 1)
+    {
+      return 1;
+    }
+  Type bt = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a*log(x)
+		+ b*log(1 - x));
+  if (x < (a + 1)/(a + b + 2))
+    {
+      return bt*BetaContinuedFraction(a, b, x)/a;
+    }
+  return 1 - bt*BetaContinuedFraction(b, a, 1 - x)/b;
+}
+
+/* Continued fraction of the incomplete beta function (modified
+ * Lentz) */
+Type InverseTransformation::BetaContinuedFraction(Type a, Type b, Type x)
+{
+  const Type eps = 1e-15, tiny = 1e-300;
+  Type qab = a + b, qap = a + 1, qam = a - 1;
+  Type c = 1, d = 1 - qab*x/qap;
+  if (fabs(d) < tiny)
+    {
+      d = tiny;
+    }
+  d = 1/d;
+  Type h = d;
+  for (int m = 1; m < 1000; ++m)
+    {
+      int m2 = 2*m;
+      Type aa = m*(b - m)*x/((qam + m2)*(a + m2));
+      d = 1 + aa*d;
+      if (fabs(d) < tiny)
+	{
+	  d = tiny;
+	}
+      c = 1 + aa/c;
+      if (fabs(c) < tiny)
+	{
+	  c = tiny;
+	}
+      d = 1/d;
+      h *= d*c;
+      aa = -(a + m)*(qab + m)*x/((a + m2)*(qap + m2));
+      d = 1 + aa*d;
+      if (fabs(d) < tiny)
+	{
+	  d = tiny;
+	}
+      c = 1 + aa/c;
+      if (fabs(c) < tiny)
+	{
+	  c = tiny;
+	}
+      d = 1/d;
+      Type del = d*c;
+      h *= del;
+      if (fabs(del - 1) < eps)
+	{
+	  break;
+	}
+    }
+  return h;
+}
+
+/* The normal tail P(Z > y) below NORMTAIL_MAX is a polynomial of
+ * degree NORMTAIL_DEGREE in each interval [k w, (k+1) w),
+ * w = 1/NORMTAIL_SCALE, in s = 2 NORMTAIL_SCALE y - (2k+1) in [-1,1],
+ * which is exact.  The coefficients interpolate the tail at the
+ * Chebyshev points of the interval, to 2e-16 relative, so the factor
+ * exp(-y^2/2) is part of the polynomial: there is no exp(), no division
+ * and no branch on the argument, which random arguments would
+ * mispredict.  Beyond NORMTAIL_MAX, P(Z > y) = R(y) exp(-y^2/2) with R
+ * the asymptotic rational function of W. J. Cody, Math. Comp. 23
+ * (1969), as used by R's pnorm(). */
+#define NORMTAIL_SCALE 8
+#define NORMTAIL_DEGREE 12
+#define NORMTAIL_INTERVALS 48
+#define NORMTAIL_MAX ((Type)NORMTAIL_INTERVALS/NORMTAIL_SCALE)
+
+static const Type normTailCoef[NORMTAIL_INTERVALS][NORMTAIL_DEGREE + 1] =
+  {
+   {0.47508233097075275, -0.02488524104293041, 4.860398641197346e-05,
+    1.6138042363350563e-05, -4.7403027315754755e-08, -9.418850582185185e-09,
+    3.082114090806544e-11, 4.3628465459173315e-12, -1.5029769200176235e-14,
+    -1.6503730948382268e-15, 5.8633449239551e-18, 5.249127997502324e-19,
+    -1.904425806204669e-21},
+   {0.42563431184410283, -0.024499431140785743, 0.00014355135434054145,
+    1.5389403004389644e-05, -1.3854405459654615e-07, -8.692515694923821e-09,
+    8.913593148568165e-11, 3.893055404097029e-12, -4.3008492770273984e-14,
+    -1.4224813019658966e-15, 1.660046928520292e-17, 4.365679140858628e-19,
+    -5.3344670853198756e-21},
+   {0.37733028152984294, -0.023745662887414233, 0.00023189123913490463,
+    1.3949707354209108e-05, -2.1908466425226103e-07, -7.317857183121458e-09,
+    1.3792774564935813e-10, 3.018178343045764e-12, -6.509505551309193e-14,
+    -1.004961009550204e-15, 2.456525637753783e-17, 2.773599140368911e-19,
+    -7.71457147268536e-21},
+   {0.3308743880408792, -0.022658269815027825, 0.0003097810326273336,
+    1.1927952707190857e-05, -2.832190989927328e-07, -5.440180341753133e-09,
+    1.7230243592868212e-10, 1.8567893786896026e-12, -7.845963274627227e-14,
+    -4.667852625169675e-16, 2.851928499016293e-17, 7.828130927826162e-20,
+    -8.610827055104897e-21},
+   {0.2868877018163652, -0.021285474644989418, 0.0003741587339939546,
+    9.47305822467333e-06, -3.2685222658010716e-07, -3.2524403353781902e-09,
+    1.8929280226724414e-10, 5.617922578040839e-13, -8.16929217194634e-14,
+    1.0575848617339176e-16, 2.7993782131869e-17, -1.2308964446276617e-19,
+    -7.916828490804435e-21},
+   {0.24588385038026145, -0.01968584596416208, 0.0004229380968862947,
+    6.758598849390363e-06, -3.47952459571117e-07, -9.6990006387545e-10,
+    1.881711382548968e-10, -7.040359749664536e-13, -7.497321842886434e-14,
+    6.253194226966098e-16, 2.3345441485417662e-17, -2.9072340859307015e-19,
+    -5.8624961083269584e-21},
+   {0.20825239328810896, -0.017924166722900904, 0.00045510579569865576,
+    3.965765647614488e-06, -3.4663946993954315e-07, 1.1968663074242848e-09,
+    1.704116627311962e-10, -1.7928237748310873e-12, -5.994161640900948e-14,
+    1.0190801579249804e-15, 1.5638041033774558e-17, -3.9749979480670183e-19,
+    -2.942905547307776e-21},
+   {0.17425071188054236, -0.016067119209170918, 0.0004707163830811793,
+    1.266684711416368e-06, -3.250109303958643e-07, 3.066523767480923e-09,
+    1.3933000508103968e-10, -2.5922916007829282e-12, -3.932682843143364e-14,
+    1.2405193043075766e-15, 6.3864803830171025e-18, -4.3010973272403167e-19,
+    2.1029700513627995e-22},
+   {0.14400437900197094, -0.01417918293555079, 0.0004707931834069598,
+    -1.1899643882069298e-06, -2.867507106169812e-07, 4.505652634096714e-09,
+    9.948207924084702e-11, -3.0390099749469376e-12, -1.6409757843312353e-14,
+    1.2752164700369355e-15, -2.770399381886496e-18, -3.905372170852357e-19,
+    2.978758704797996e-21},
+   {0.11751522829321415, -0.012319087619911706, 0.00045715364214516096,
+    -3.2895512901070382e-06, -2.3658947290176456e-07, 5.439346447432623e-09,
+    5.594010144543801e-11, -3.1225728981167926e-12, 5.556751307217521e-15,
+    1.14004883425768e-15, -1.0390722819836262e-17, -2.940818100157958e-19,
+    4.889830831217572e-21},
+   {0.09467574302164258, -0.010537074032382195, 0.00043218467710942594,
+    -4.957475524878708e-06, -1.7970325395556423e-07, 5.853027325567087e-09,
+    1.3573586801786512e-11, -2.8808973739410534e-12, 2.3859541930018668e-14,
+    8.766209781640278e-16, -1.5475588755907918e-17, -1.6473206339410272e-19,
+    5.701016304041081e-21},
+   {0.0752879864124234, -0.00887310595032597, 0.00039859655636229947,
+    -6.16037476714831e-06, -1.2113517376021014e-07, 5.78624224362976e-09,
+    -2.3551713929241257e-11, -2.388492810331508e-12, 3.668091699114655e-14,
+    5.40915969420948e-16, -1.7596215444001556e-17, -2.925447233801778e-20,
+    5.421600539963986e-21},
+   {0.059085122932667544, -0.007356063201520002, 0.00035918277351171886,
+    -6.903043928428347e-06, -6.531160559613011e-08, 5.320369598612941e-09,
+    -5.257809602110525e-11, -1.7406188236029917e-12, 4.325312989734633e-14,
+    1.9171603816781963e-16, -1.6890669703443506e-17, 8.849621720040428e-20,
+    4.274447152581559e-21},
+   {0.04575362496174111, -0.006003843806569585, 0.0003166089507370679,
+    -7.222030946114637e-06, -1.5700974882438214e-08, 4.562851196415525e-09,
+    -7.202877760238745e-11, -1.0366065859642176e-12, 4.381217287419693e-14,
+    -1.197470760946562e-16, -1.3949599006627424e-17, 1.7179838270317688e-19,
+    2.6156614739693816e-21},
+   {0.03495448696823474, -0.00482422402748192, 0.0002732470640565931,
+    -7.177152140495104e-06, 2.536396748368746e-08, 3.630710194019103e-09,
+    -8.175896459212431e-11, -3.6528005327340245e-13, 3.9390739281927385e-14,
+    -3.570793293435476e-16, -9.632299006389916e-18, 2.1310513098854191e-19,
+    8.377421401330478e-22},
+   {0.02634212668914146, -0.0038162753150666464, 0.00023106354446692586,
+    -6.842229454350753e-06, 5.670581065129177e-08, 2.6357749691977087e-09,
+    -8.273025557692834e-11, 2.0544574869344153e-13, 3.151505343120281e-14,
+    -5.020534712763924e-16, -4.8631731498533046e-18, 2.1382411287552115e-19,
+    -7.1822443713631375e-22},
+   {0.019580078778377457, -0.0029721182037899764, 0.00019156230610365083,
+    -6.29622005146548e-06, 7.819048596607452e-08, 1.6733429700927192e-09,
+    -7.667493931374963e-11, 6.338284163705814e-13, 2.187746035920349e-14,
+    -5.540606577011966e-16, -4.541536629230403e-19, 1.8229670261692377e-19,
+    -1.822503297189091e-21},
+   {0.014353021608801655, -0.0022788020735120085, 0.00015577748549398498,
+    -5.615639265017538e-06, 9.052316140588267e-08, 8.151709371541171e-10,
+    -6.572233849290414e-11, 9.045606768462981e-13, 1.20477584506623e-14,
+    -5.265460222200402e-16, 3.015619619140851e-18, 1.3076853609583466e-19,
+    -2.3803478712497126e-21},
+   {0.010375072658058005, -0.0017201300501815291, 0.00012430627315764957,
+    -4.86883734601858e-06, 9.499622366300887e-08, 1.0684979217390661e-10,
+    -5.2051055495340126e-11, 1.0250265401116293e-12, 3.2662150604649102e-15,
+    -4.4173100939201006e-16, 5.2502883919635376e-18, 7.22164688796818e-20,
+    -2.4214360010064278e-21},
+   {0.007394607110880697, -0.0012782921107988372, 9.736990687725519e-05,
+    -4.1123441573092886e-06, 9.323061609722539e-08, -4.3104367953893847e-10,
+    -3.761314412484544e-11, 1.0190377718949667e-12, -3.663396132405102e-15,
+    -3.249938289974274e-16, 6.223087907383498e-18, 1.7745299105820865e-20,
+    -2.0650258765073936e-21},
+   {0.005196079382091164, -0.0009352184866196216, 7.489054287383689e-05,
+    -3.38919663348633e-06, 8.694339198279454e-08, -7.99048122015509e-10,
+    -2.3954258192448307e-11, 9.196417527972955e-13, -8.385298122025125e-15,
+    -2.0003886511413274e-16, 6.115307288575371e-18, -2.5022481329237964e-20,
+    -1.4743425682797341e-21},
+   {0.0035994551144099673, -0.0006736126062669315, 5.657293372944932e-05,
+    -2.7289451135844467e-06, 7.776303782340332e-08, -1.0133607743890861e-09,
+    -1.2132758437495191e-11, 7.623749580983323e-13, -1.0929011701134336e-14,
+    -8.55602512079997e-17, 5.2319392367777995e-18, -5.2464758149026955e-20,
+    -8.130647186222216e-22},
+   {0.0024579011751966876, -0.0004776628636716501, 4.198208762739112e-05,
+    -2.1489095200478846e-06, 6.710241209364655e-08, -1.0999425032642187e-09,
+    -2.724294940122289e-12, 5.799174247298776e-13, -1.160213582173974e-14,
+    6.366394069847549e-18, 3.916609467273728e-18, -6.455542519498643e-20,
+    -2.1307953361961734e-22},
+   {0.0016543508595475074, -0.0003334624207241447, 3.061080815241172e-05,
+    -1.6562197562516645e-06, 5.6088987411022545e-08, -1.0890762430697846e-09,
+    4.1115843069411676e-12, 3.98615554423629e-13, -1.086872371961027e-14,
+    7.033041322829787e-17, 2.482639923947874e-18, -6.386781706610155e-20,
+    2.4235936397196402e-22},
+   {0.0010974823774378647, -0.00022918514664338913, 2.19337347373556e-05,
+    -1.2502088916780336e-06, 4.55446736985546e-08, -1.0109627675552008e-09,
+    8.52958115322992e-12, 2.368970404499522e-13, -9.237804952272708e-15,
+    1.0649629508761784e-16, 1.169165898297458e-18, -5.435686362671366e-20,
+    5.206496085193945e-22},
+   {0.0007175422898444507, -0.00015507442725645623, 1.5446866777498572e-05,
+    -9.248085833648424e-07, 3.600324860020305e-08, -8.926244070990037e-10,
+    1.0886227787686784e-11, 1.0527681663875734e-13, -7.177817401737446e-15,
+    1.1890254326996394e-16, 1.2353673215604339e-19, -4.0234275456667515e-20,
+    6.308766693852475e-22},
+   {0.0004623306301886043, -0.00010330183890039112, 1.06933544174233e-05,
+    -6.706990425432804e-07, 2.7752096005708003e-08, -7.561225049961416e-10,
+    1.1635947890774308e-11, 7.475920353581813e-15, -5.0634245118849726e-15,
+    1.1363719392674026e-16, -5.945108153907776e-19, -2.51384266197475e-20,
+    6.09103640353434e-22},
+   {0.0002935553597519711, -6.774699994466574e-05, 7.2775097596808905e-06,
+    -4.77069709388172e-07, 2.088589926096569e-08, -6.179079510249839e-10,
+    1.124753769375118e-11, -5.786343786704789e-14, -3.1534460512185183e-15,
+    9.725264263803705e-17, -9.944650453992601e-19, -1.1675577936515074e-20,
+    5.028622179117859e-22},
+   {0.00018366995423736373, -4.374075068418392e-05, 4.869575759762663e-06,
+    -3.329367746932029e-07, 1.5362316716475382e-08, -4.890230248587416e-10,
+    1.0146132189953257e-11, -9.53182742579772e-14, -1.593526905442333e-15,
+    7.562264656238046e-17, -1.130477012211236e-18, -1.3054272514281475e-21,
+    3.5841183282323087e-22},
+   {0.00011323404682250717, -2.7803312757050643e-05, 3.2038973684882574e-06,
+    -2.280316254717212e-07, 1.1052670238124393e-08, -3.758467382387059e-10,
+    8.680222243218958e-12, -1.1100864797661746e-13, -4.3490247273754384e-16,
+    5.3295079155335274e-17, -1.0772768605037847e-18, 5.5203697470644855e-21,
+    2.125486197603483e-22},
+   {6.87841146467492e-05, -1.739886853739763e-05, 2.0729120718383893e-06,
+    -1.5331797150187882e-07, 7.7836473441299e-09, -2.811046948168054e-10,
+    7.10968001856858e-12, -1.1129272812690126e-13, 3.39279770935324e-16,
+    3.328346778952428e-17, -9.108878993240247e-19, 9.080681110664689e-21,
+    8.913153119018618e-23},
+   {4.116746597159935e-05, -1.0719131949670218e-05, 1.3189556891195776e-06,
+    -1.0121698234335713e-07, 5.368521577036244e-09, -2.0492509577793987e-10,
+    5.6090258934774e-12, -1.0189604807637296e-13, 7.869699943881787e-16,
+    1.717880133638081e-17, -6.9601295614145e-19, 1.0071949924393639e-20,
+    -6.0970944080735815e-25},
+   {2.427497385668885e-05, -6.501482172980244e-06, 8.253834789916324e-07,
+    -6.562393886453905e-08, 3.628223021029248e-09, -1.4579417360819958e-10,
+    4.27997582533177e-12, -8.744602900645484e-14, 9.841021376770152e-16,
+    5.446462831585967e-18, -4.799912405944565e-19, 9.333803698074867e-21,
+    -5.541796146789649e-23},
+   {1.4102201050166802e-05, -3.8822123231510105e-06, 5.080238782248392e-07,
+    -4.179230947850094e-08, 2.4037130366956414e-09, -1.01331672929478e-10,
+    3.1681325891396505e-12, -7.132914213165485e-14, 1.0075733904431332e-15,
+    -2.211116849642671e-18, -2.919828671949977e-19, 7.652125630885243e-21,
+    -8.042377450965889e-23},
+   {8.070944122868076e-06, -2.28223488940233e-06, 3.0756681126711085e-07,
+    -2.6147125693658183e-08, 1.5616280586110098e-09, -6.886093107337203e-11,
+    2.2800141908683813e-12, -5.576834260118382e-14, 9.246668758374662e-16,
+    -6.512463690405998e-18, -1.4553373277386564e-19, 5.647973429430067e-21,
+    -8.371931017900209e-23},
+   {4.550486098528922e-06, -1.3208562195903422e-06, 1.8316560857600447e-07,
+    -1.6073346483204618e-08, 9.952121040919839e-10, -4.5785194943849917e-11,
+    1.5980333058201305e-12, -4.202345736103998e-14, 7.880481636761592e-16,
+    -8.32504319009233e-18, -4.273805949697088e-20, 3.740024125299637e-21,
+    -7.372443421031732e-23},
+   {2.527404681784421e-06, -7.526011878615934e-07, 1.0730446623807876e-07,
+    -9.70953833521999e-09, 6.22324206685228e-10, -2.980274479422442e-11,
+    1.0922792998894299e-12, -3.063658941247564e-14, 6.34878724282447e-16,
+    -8.48052838116146e-18, 2.138348329325767e-20, 2.158237105730706e-21,
+    -5.755865434786082e-23},
+   {1.3828135064100918e-06, -4.2217100475893476e-07, 6.184145577523458e-08,
+    -5.764353750993654e-09, 3.8193251380960384e-10, -1.9001307205059083e-11,
+    7.288750190961702e-13, -2.166919852597386e-14, 4.884960318270041e-16,
+    -7.672161304110055e-18, 5.515360910634863e-20, 9.851774457354704e-22,
+    -4.0332694879081157e-23},
+   {7.452693639045835e-07, -2.3314497176590584e-07, 3.506281801948193e-08,
+    -3.3636256531473384e-09, 2.3010152663999716e-10, -1.1871170555796684e-11,
+    4.752597079976064e-13, -1.490086795965085e-14, 3.613287934422083e-16,
+    -6.416693810411108e-18, 6.754068731668624e-20, 2.0567870423622794e-22,
+    -2.511541477832941e-23},
+   {3.9565203278849396e-07, -1.2675872247849775e-07, 1.955847475742446e-08,
+    -1.929349146611046e-09, 1.3611289004946906e-10, -7.270239417148532e-12,
+    3.0303294395517104e-13, -9.978275515155143e-15, 2.580767784940816e-16,
+    -5.05949566764061e-18, 6.652285392758251e-20, -2.479567578211047e-22,
+    -1.3293774452898088e-23},
+   {2.0689703270164973e-07, -6.784905487108295e-08, 1.0733932508901794e-08,
+    -1.0879218825332082e-09, 7.906808347583529e-11, -4.3660729294085785e-12,
+    1.8906083365977665e-13, -6.51536463030446e-15, 1.785607382546254e-16,
+    -3.803158895546822e-18, 5.833405355881353e-20, -4.616190592533474e-22,
+    -5.083758920638073e-24},
+   {1.0656796268647949e-07, -3.5753939415222275e-08, 5.796048772389548e-09,
+    -6.031185916676059e-10, 4.5112119720200124e-11, -2.5718492133015907e-12,
+    1.1547772716658015e-13, -4.152591337304459e-15, 1.199629746136655e-16,
+    -2.7445359429713994e-18, 4.732918523328806e-20, -5.173756993234786e-22,
+    -2.5640502774830345e-26},
+   {5.406571334852228e-08, -1.8548899413820534e-08, 3.0794071292475494e-09,
+    -3.287436930717857e-10, 2.5283472485289798e-11, -1.486357337067073e-12,
+    6.908437217608582e-14, -2.5856810940052827e-15, 7.840220548924906e-17,
+    -1.9104675021378747e-18, 3.621050347722608e-20, -4.8219819367672745e-22,
+    2.6250168995673474e-24},
+   {2.701667517982307e-08, -9.47385080462653e-09, 1.6098144921923986e-09,
+    -1.7619392632607477e-10, 1.392154485244815e-11, -8.429913729831623e-13,
+    4.0496753624724644e-14, -1.5740651531587295e-15, 4.991804942124452e-17,
+    -1.2871369112122966e-18, 2.6409890580259277e-20, -4.045056265122027e-22,
+    3.637468638801267e-24},
+   {1.329685158056389e-08, -4.7637513495516266e-09, 8.280739650587788e-10,
+    -9.28602958534577e-11, 7.53175490324077e-12, -4.692820035143166e-13,
+    2.3268681243608716e-14, -9.374131107521276e-16, 3.0998624476611373e-17,
+    -8.41424046201745e-19, 1.848922586306728e-20, -3.154691761500289e-22,
+    3.6648717423680615e-24},
+   {6.44563015906951e-09, -2.3582279220586783e-09, 4.1913816583464794e-10,
+    -4.812820199208805e-11, 4.004141540420163e-12, -2.5646931928449037e-13,
+    1.310898100426709e-14, -5.464245751968111e-16, 1.879314790252373e-17,
+    -5.347459802234679e-19, 1.2483154236816708e-20, -2.325668373758488e-22,
+    3.1920802635275968e-24},
+   {3.0773341907976776e-09, -1.1493084992306382e-09, 2.0876111411806514e-10,
+    -2.4531418441881172e-11, 2.0920389052892956e-12, -1.3762582371911724e-13,
+    7.243209948989687e-15, -3.119030909243485e-16, 1.1132090712707293e-17,
+    -3.308893184058023e-19, 8.1552829921116e-21, -1.6366394323078173e-22,
+    2.5388046263366132e-24},
+   {1.4470052276663568e-09, -5.514442443985638e-10, 1.0231875628488977e-10,
+    -1.2297603808418292e-11, 1.074277204697081e-12, -7.252588405459969e-14,
+    3.926131003535641e-15, -1.7441083076243668e-16, 6.447155162003554e-18,
+    -1.9959637312863709e-19, 5.168304105834793e-21, -1.106417093482557e-22,
+    1.89017187182429e-24}
+  };
+
+static const Type codyP[6] =
+  {0.21589853405795699, 0.1274011611602473639, 0.022235277870649807,
+   0.001421619193227893466, 2.9112874951168792e-5, 0.02307344176494017303};
+static const Type codyQ[5] =
+  {1.28426009614491121, 0.468238212480865118, 0.0659881378689285515,
+   0.00378239633202758244, 7.29751555083966205e-5};
+
+/* Returns the polynomial of the interval of y, 0 <= y < NORMTAIL_MAX,
+ * by Estrin's scheme, which has a third of the dependent operations of
+ * Horner's rule */
+static inline Type NormTailPolynomial(Type y)
+{
+  int k = (int)(y*NORMTAIL_SCALE);
+  Type s = 2*NORMTAIL_SCALE*y - (2*k + 1);
+  const Type *c = normTailCoef[k];
+  Type s2 = s*s, s4 = s2*s2;
+  Type p0 = (c[0] + c[1]*s) + (c[2] + c[3]*s)*s2;
+  Type p1 = (c[4] + c[5]*s) + (c[6] + c[7]*s)*s2;
+  Type p2 = (c[8] + c[9]*s) + (c[10] + c[11]*s)*s2;
+  return p0 + p1*s4 + (p2 + c[12]*s4)*(s4*s4);
+}
+
+/* Returns Cody's R(y) = P(Z > y) exp(y^2/2), for y >= NORMTAIL_MAX */
+static inline Type NormTailFactor(Type y)
+{
+  Type r = 1.0/(y*y);
+  Type num = codyP[5]*r, den = r;
+  for (int i = 0; i < 4; ++i)
+    {
+      num = (num + codyP[i])*r;
+      den = (den + codyQ[i])*r;
+    }
+  const Type oneOverSqrt2Pi = 0.398942280401432677939946059934;
+  return (oneOverSqrt2Pi - r*(num + codyP[4])/(den + codyQ[4]))/y;
+}
 
-  Type ASquared =  -(1.0/N)*sum - N;
-  //  Type ASquared2 = -(1.0/N)*sum2 - N;
+/* Returns a*b - p exactly for p = a*b rounded (Dekker's product), for
+ * |a|, |b| < 1e150 */
+static inline Type ProductError(Type a, Type b, Type p)
+{
+  const Type split = 134217729.0;  /* 2^27 + 1 */
+  Type ca = split*a, cb = split*b;
+  Type aHi = ca - (ca - a), aLo = a - aHi;
+  Type bHi = cb - (cb - b), bLo = b - bHi;
+  return ((aHi*bHi - p) + aHi*bLo + aLo*bHi) + aLo*bLo;
+}
 
-  //  std::cout << "ASquared2: " << ASquared2 << "\n";
+/* Sets h + l = a*a exactly; beyond 1e150, where the split would
+ * overflow, l = 0 */
+static inline void ExactSquare(Type a, Type &h, Type &l)
+{
+  h = a*a;
+  l = (fabs(a) < 1e150) ? ProductError(a, a, h) : 0;
+}
 
-  return ASquared;
+/* Returns P(Z > y), y >= 0 (NaN for NaN).  In the far tail
+ * exp(-y^2/2) is taken with y^2 split exactly, so the tail keeps the
+ * relative accuracy of exp() instead of losing y^2 ulps to the rounding
+ * of its argument. */
+static inline Type NormTailKernel(Type y)
+{
+  if (y < NORMTAIL_MAX)
+    {
+      return NormTailPolynomial(y);
+    }
+  Type h, l;
+  ExactSquare(y, h, l);
+  return NormTailFactor(y)*exp(-0.5*h)*(1.0 - 0.5*l);
+}
+
+/* Returns log P(Z > y), y >= 0, with no exp() in the far tail, so it
+ * stays finite where the tail itself underflows */
+static inline Type LogNormTailKernel(Type y)
+{
+  if (y < NORMTAIL_MAX)
+    {
+      return log(NormTailPolynomial(y));
+    }
+  Type h, l;
+  ExactSquare(y, h, l);
+  return log(NormTailFactor(y)) - 0.5*h - 0.5*l;
 }
 
-/* Approximates the standard normal cdf at x */
+/* Returns erfc(a)/2 = P(Z > a sqrt(2)), a >= 0.  The argument is taken
+ * in two parts, y + dy = a sqrt(2) to twice double precision, and the
+ * tail at y is corrected by exp(-y dy), to first order: the tail falls
+ * off as exp(-y^2/2), and dropping dy would cost y^2 ulps. */
+static inline Type ErfcTailKernel(Type a)
+{
+  const Type sqrt2Lo = -9.667293313452913e-17;  /* sqrt(2) - M_SQRT2 */
+  Type y = a*M_SQRT2;
+  Type dy = (a < 1e150) ? ProductError(a, M_SQRT2, y) + a*sqrt2Lo : 0;
+  return NormTailKernel(y)*(1.0 - y*dy);
+}
+
+/* Returns log P(Z > |x|), Z ~ N(0,1), i.e. log(erfc(|x|/sqrt(2))/2) */
+Type InverseTransformation::LogNormTail(Type x)
+{
+  return LogNormTailKernel(fabs(x));
+}
+
+/* Returns the standard normal cdf at x, to about 1e-15 relative; the
+ * lower tail is computed directly, so it keeps its relative accuracy
+ * where 1 - cdf(-x) would round to 0.  The sign is applied as
+ * (1 + sgn)/2 - sgn tail, exact for either sign, rather than by a
+ * branch, which random arguments mispredict half the time. */
 Type InverseTransformation::NormCDF(Type x)
 {
-  // constants
-  Type a1 =  0.254829592;
-  Type a2 = -0.284496736;
-  Type a3 =  1.421413741;
-  Type a4 = -1.453152027;
-  Type a5 =  1.061405429;
-  Type p  =  0.3275911;
- 
-  // Save the sign of x
-  int sign = 1;
-  if (x < 0)
-    sign = -1;
-  x = fabs(x)/sqrt(2.0);
- 
-  // A&S formula 7.1.26
-  Type t = 1.0/(1.0 + p*x);
-  Type y = 1.0 - (((((a5*t + a4)*t) + a3)*t + a2)*t + a1)*t*exp(-x*x);
- 
-  return 0.5*(1.0 + sign*y);
+  Type sgn = copysign(1.0, x);
+  return 0.5*(1.0 + sgn) - sgn*NormTailKernel(fabs(x));
+}
+
+/* Returns log of the standard normal cdf at x, finite down to the
+ * underflow of the log itself (x near -3.8e154) */
+Type InverseTransformation::LogNormCDF(Type x)
+{
+  return (x < 0) ? LogNormTailKernel(-x) : log1p(-NormTailKernel(x));
+}
+
+/* Batch versions: cdf[i] = NormCDF(x[i]), logCdf[i] = LogNormCDF(x[i])
+ * and y[i] = erfc(x[i]) for i = 0..n-1.  Outputs may alias the
+ * inputs. */
+void InverseTransformation::NormCDF(const Type *x, size_t n, Type *cdf)
+{
+  for (size_t i = 0; i < n; ++i)
+    {
+      Type sgn = copysign(1.0, x[i]);
+      cdf[i] = 0.5*(1.0 + sgn) - sgn*NormTailKernel(fabs(x[i]));
+    }
+}
+
+void InverseTransformation::LogNormCDF(const Type *x, size_t n,
+				       Type *logCdf)
+{
+  for (size_t i = 0; i < n; ++i)
+    {
+      Type xi = x[i];
+      logCdf[i] = (xi < 0) ? LogNormTailKernel(-xi)
+	: log1p(-NormTailKernel(xi));
+    }
+}
+
+void InverseTransformation::Erfc(const Type *x, size_t n, Type *y)
+{
+  for (size_t i = 0; i < n; ++i)
+    {
+      Type sgn = copysign(1.0, x[i]);
+      y[i] = (1.0 - sgn) + 2.0*sgn*ErfcTailKernel(fabs(x[i]));
+    }
+}
+
+/* Function AndersonDarlingNormal computes the Anderson Darling test
+ * statistic for a standard normal distribution.  The function works on
+ * its copy of "values", see the in-place version below, and
+ * normalizes the data to N(0,1) before computing the Anderson
+ * Darling statistic for a standard normal, A^2.
+ */
+Type InverseTransformation::
+AndersonDarlingNormal(std::vector<Type> values, 
+		      Type mean,
+		      Type variance)
+{
+  return AndersonDarlingNormal(values.data(), values.size(), mean,
+			       variance);
+}
+
+/* In-place version of AndersonDarlingNormal() for large samples: the
+ * N values are sorted in the caller's buffer, by numThreads threads
+ * (0 = all hardware threads) sorting chunks that are then merged
+ * pairwise.  The statistic is summed in one pass over the sorted data
+ * with the form
+ *
+ *   A^2 = -N - 1/N sum_i [(2i+1) log F_i + (2N-1-2i) log(1 - F_i)],
+ *
+ * i = 0..N-1, which needs each value once instead of a second CDF
+ * vector read in reverse.  The pass normalizes and takes both logs of
+ * the CDF in one loop over the piecewise normal tail kernel: below
+ * NORMTAIL_MAX the log of its interval polynomial, beyond it
+ * log R(y) - y^2/2 with Cody's factor R, so no exp() is taken that
+ * could underflow, whereas log(1 - F) is -inf beyond 8 sd.  Blocks of
+ * AD_BLOCK values go to the threads and their partial sums are added
+ * in block order, so the result does not depend on numThreads.
+ */
+Type InverseTransformation::
+AndersonDarlingNormal(Type *values, size_t N, Type mean, Type variance,
+		      unsigned int numThreads)
+{
+  if (N == 0)
+    {
+      return 0;
+    }
+
+  ThreadPool pool(numThreads);
+
+  /* sort: one chunk per thread, then merge neighbours pairwise */
+  size_t numChunks = std::min((size_t)pool.GetNumThreads(),
+			      std::max((size_t)1, N/AD_MIN_SORT_CHUNK));
+  std::vector<size_t> bounds(numChunks + 1);
+  for (size_t c = 0; c <= numChunks; ++c)
+    {
+      bounds[c] = N*c/numChunks;
+    }
+  for (size_t c = 0; c < numChunks; ++c)
+    {
+      Type *first = values + bounds[c], *last = values + bounds[c+1];
+      pool.Enqueue([first, last]() {std::sort(first, last);});
+    }
+  pool.Wait();
+  for (size_t width = 1; width < numChunks; width *= 2)
+    {
+      for (size_t c = 0; c + width < numChunks; c += 2*width)
+	{
+	  Type *first = values + bounds[c];
+	  Type *middle = values + bounds[c + width];
+	  Type *last = values + bounds[std::min(c + 2*width, numChunks)];
+	  pool.Enqueue([first, middle, last]()
+		       {
+			 std::inplace_merge(first, middle, last);
+		       });
+	}
+      pool.Wait();
+    }
+
+  const Type scale = 1.0/sqrt(variance);
+
+  size_t numBlocks = (N + AD_BLOCK - 1)/AD_BLOCK;
+  std::vector<Type> partial(numBlocks);
+  for (size_t b = 0; b < numBlocks; ++b)
+    {
+      size_t begin = b*AD_BLOCK;
+      size_t end = std::min(N, begin + AD_BLOCK);
+      Type *sum = &partial[b];
+      pool.Enqueue([=]()
+		   {
+		     Type s = 0;
+		     for (size_t i = begin; i < end; ++i)
+		       {
+			 /* log of the tail beyond |y|, and of the rest */
+			 Type y = (values[i] - mean)*scale;
+			 Type a = fabs(y);
+			 Type tail = NormTailKernel(a);
+			 Type logTail = (a < NORMTAIL_MAX) ? log(tail)
+			   : LogNormTailKernel(a);
+			 Type logNear = log1p(-tail);
+			 Type logF = (y < 0) ? logTail : logNear;
+			 Type log1mF = (y < 0) ? logNear : logTail;
+			 s += (2.0*i + 1)*logF + (2.0*(N - i) - 1)*log1mF;
+		       }
+		     *sum = s;
+		   });
+    }
+  pool.Wait();
+
+  Type sum = 0;
+  for (size_t b = 0; b < numBlocks; ++b)
+    {
+      sum += partial[b];
+    }
+
+  return -sum/N - (Type)N;
 }
@@ -10,14 +10,24 @@
 
 #include <cmath>
 #include <vector>
+#include <string>
 #include <algorithm>
 #include "MersenneTwister.h"
+#include "DSFMT.h"
+#include "InverseCDFTable.h"
+#include "ThreadPool.h"
+
+/* sorted samples per task in the Anderson-Darling sum, and the least
+ * number per thread worth a parallel sort */
+#define AD_BLOCK 65536
+#define AD_MIN_SORT_CHUNK 32768
 
 typedef double Type;
 class InverseTransformation
 {
  private:
   MersenneTwister MT;
+  DSFMT bulkRNG;  /* bulk uniforms for the array form of GenPareto */
   /* values needed in BSM approximation of inverse normal CDF */
   static constexpr Type a0 = 2.50662823884;
   static constexpr Type a1 = -18.61500062529;
@@ -39,14 +49,66 @@ class InverseTransformation
   static constexpr Type c7 = 0.0000002888167364;
   static constexpr Type c8 = 0.0000003960315187;
 
+  static Type GammaP(Type a, Type x);
+  static Type BetaI(Type a, Type b, Type x);
+  static Type BetaContinuedFraction(Type a, Type b, Type x);
+
  public:
+  /* parameter distributions for Transform(), with their parameters:
+   *   NORMAL_PARAM       mean, variance
+   *   UNIFORM_PARAM      a, b
+   *   LOGNORMAL_PARAM    mean, variance of log x
+   *   EXPONENTIAL_PARAM  rate lambda
+   *   GAMMA_PARAM        shape k, scale theta
+   *   BETA_PARAM         alpha, beta, on [0,1]
+   *   TRIANGULAR_PARAM   a, mode c, b
+   *   WEIBULL_PARAM      shape k, scale lambda
+   *   TRUNCNORMAL_PARAM  mean, variance, lower, upper bound
+   * TABULATED_PARAM is a parameter given by an InverseCDFTable; it has
+   * no name and no parameters.
+   */
+  enum {NORMAL_PARAM = 0, UNIFORM_PARAM, LOGNORMAL_PARAM,
+	EXPONENTIAL_PARAM, GAMMA_PARAM, BETA_PARAM, TRIANGULAR_PARAM,
+	WEIBULL_PARAM, TRUNCNORMAL_PARAM, NUM_PARAM_FAMILIES,
+	TABULATED_PARAM = NUM_PARAM_FAMILIES};
+
   InverseTransformation();
+  /* generator used by GenPareto, e.g. a jumped copy per thread */
+  void SetGenerator(const MersenneTwister &MT_) {MT = MT_;}
+  void SetBulkGenerator(const DSFMT &bulkRNG_) {bulkRNG = bulkRNG_;}
   Type GenPareto(Type k, Type sigma, Type theta);
+  void GenPareto(Type k, Type sigma, Type theta, Type *values,
+		 size_t n);
   Type Normal(Type u, Type mean, Type variance);
   Type Uniform(Type u, Type a, Type b);
+  Type LogNormal(Type u, Type mean, Type variance);
+  Type Exponential(Type u, Type lambda);
+  Type Gamma(Type u, Type k, Type theta);
+  Type Beta(Type u, Type alpha, Type beta);
+  Type Triangular(Type u, Type a, Type c, Type b);
+  Type Weibull(Type u, Type k, Type lambda);
+  Type TruncatedNormal(Type u, Type mean, Type variance, Type lower,
+		       Type upper);
+  Type Transform(Type u, int family, const std::vector<Type> &params);
+  static int FamilyFromName(const std::string &name);
+  static bool ValidParams(int family, const std::vector<Type> &params);
+  /* true for families whose inverse CDF is iterative (Gamma, Beta) */
+  static bool IsIterative(int family)
+  {
+    return family == GAMMA_PARAM || family == BETA_PARAM;
+  }
+  bool Tabulate(int family, const std::vector<Type> &params,
+		InverseCDFTable &table);
   Type AndersonDarlingNormal(std::vector<Type> values, 
 			     Type mean,
 			     Type variance);
-  Type NormCDF(Type x);
+  Type AndersonDarlingNormal(Type *values, size_t N, Type mean,
+			     Type variance, unsigned int numThreads = 0);
+  static Type LogNormTail(Type x);
+  static Type NormCDF(Type x);
+  static Type LogNormCDF(Type x);
+  static void NormCDF(const Type *x, size_t n, Type *cdf);
+  static void LogNormCDF(const Type *x, size_t n, Type *logCdf);
+  static void Erfc(const Type *x, size_t n, Type *y);
 };
 #endif
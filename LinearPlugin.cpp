@@ -0,0 +1,45 @@
+#include "SobolModelPlugin.h"
+#include <cstddef>
+
+/* Example model plugin: the linear model of ModelRegistry,
+ * Y = c*(x_1 + ... + x_dim) with c = constants[0] if given, 1
+ * otherwise, registered as "linear_plugin".  It keeps no state, so it
+ * is thread safe and needs no per-thread init. */
+
+static double Evaluate(const double *x, int dim, const double *constants,
+		       int numConstants)
+{
+  double c = numConstants > 0 ? constants[0] : 1.0;
+  double Y = 0;
+  for (int j = 0; j < dim; ++j)
+    {
+      Y += c*x[j];
+    }
+  return Y;
+}
+
+static void EvaluateBatch(const double *X, unsigned int n, int dim,
+			  const double *constants, int numConstants,
+			  double *Y)
+{
+  for (unsigned int i = 0; i < n; ++i)
+    {
+      Y[i] = Evaluate(X + (size_t)i*dim, dim, constants, numConstants);
+    }
+}
+
+static const SobolModelPlugin plugin =
+  {
+    SOBOL_PLUGIN_ABI_VERSION,
+    "linear_plugin",
+    1,
+    Evaluate,
+    EvaluateBatch,
+    0,
+    0
+  };
+
+extern "C" const SobolModelPlugin* sobol_model_plugin(void)
+{
+  return &plugin;
+}
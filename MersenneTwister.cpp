@@ -1,16 +1,37 @@
 #include "MersenneTwister.h"
+#include <map>
+#include <mutex>
+#include <vector>
 
-/* init static member */
-int MersenneTwister::mti = NN+1;
-unsigned long long MersenneTwister::mt[NN] = {};
-
-MersenneTwister::MersenneTwister() {
+/* Default ctor: seeds with the fixed key of the reference code */
+MersenneTwister::MersenneTwister() : mti(NN+1) {
   unsigned long long init[4] = {0x12345ULL, 0x23456ULL, 0x34567ULL,
 				0x45678ULL};
   unsigned long long length = 4;
   init_by_array64(init, length);
 }
 
+/* Ctor
+ * Input:
+ *   seed = seed passed to init_genrand64()
+ */
+MersenneTwister::MersenneTwister(unsigned long long seed) : mti(NN+1) {
+  init_genrand64(seed);
+}
+
+/* Restarts the generator from a single seed */
+void MersenneTwister::Seed(unsigned long long seed)
+{
+  init_genrand64(seed);
+}
+
+/* Restarts the generator from an array of length seeds */
+void MersenneTwister::Seed(const unsigned long long key[],
+			   unsigned long long length)
+{
+  init_by_array64(key, length);
+}
+
 /* initializes mt[NN] with a seed */
 void MersenneTwister::init_genrand64(unsigned long long seed)
 {
@@ -22,7 +43,7 @@ void MersenneTwister::init_genrand64(unsigned long long seed)
 /* initialize by an array with array-length */
 /* init_key is the array for initializing keys */
 /* key_length is its length */
-void MersenneTwister::init_by_array64(unsigned long long init_key[],
+void MersenneTwister::init_by_array64(const unsigned long long init_key[],
 		     unsigned long long key_length)
 {
   unsigned long long i, j, k;
@@ -93,3 +114,220 @@ double MersenneTwister::genrand64_real3(void)
 {
   return ((genrand64_int64() >> 12) + 0.5) * (1.0/4503599627370496.0);
 }
+
+/* fills array with n random numbers on [0,1)-real-interval, the same
+ * entry point as DSFMT::fill() */
+void MersenneTwister::fill(double *array, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    array[i] = (genrand64_int64() >> 11) * (1.0/9007199254740992.0);
+}
+
+/**** Jump ahead ****/
+
+/* The jump uses the characteristic polynomial P(x) of the linear
+ * recurrence (degree MEXP = 19937): advancing the state by J steps is
+ * the same as applying g(T) to it, where g(x) = x^J mod P(x) and T is
+ * the one-step transition.  P is found once per process by
+ * Berlekamp-Massey on 2*MEXP output bits, g by repeated squaring, and
+ * g(T) is applied with Horner's rule.  Polynomials over GF(2) are
+ * stored as bit vectors in 64-bit words, lowest degree first.
+ */
+
+#define MEXP 19937
+#define POLY_WORDS ((2*MEXP + 63)/64 + 1)
+
+typedef std::vector<unsigned long long> GF2Poly;
+
+/* working copy of the state for Horner's rule; the window of NN words
+ * starts at index start and is advanced one word at a time */
+struct MTJumpState {
+  unsigned long long mt[NN];
+  int start;
+};
+
+/* advances s by one word of the recurrence */
+static inline void NextState(MTJumpState &s)
+{
+  static const unsigned long long mag01[2]={0ULL, MATRIX_A};
+  int i = s.start;
+  unsigned long long x = (s.mt[i]&UM)|(s.mt[(i+1)%NN]&LM);
+  s.mt[i] = s.mt[(i+MM)%NN] ^ (x>>1) ^ mag01[(int)(x&1ULL)];
+  s.start = (i+1)%NN;
+}
+
+/* a += b, word by word from each window's start */
+static inline void AddState(MTJumpState &a, const MTJumpState &b)
+{
+  int j = b.start - a.start;
+  if (j < 0) j += NN;
+  for (int i = 0; i < NN; i++) {
+    a.mt[i] ^= b.mt[(i+j)%NN];
+  }
+}
+
+static inline int PolyBit(const GF2Poly &p, int i)
+{
+  return (p[i/64] >> (i%64)) & 1ULL;
+}
+
+static inline void SetPolyBit(GF2Poly &p, int i)
+{
+  p[i/64] |= 1ULL << (i%64);
+}
+
+/* Characteristic polynomial of MT19937-64, by Berlekamp-Massey on the
+ * lowest bit of 2*MEXP successive words of the recurrence */
+static GF2Poly CharacteristicPolynomial()
+{
+  const int n = 2*MEXP;
+
+  /* the sequence, stored reversed: bit t of rev is s_(n-1-t) */
+  GF2Poly rev(POLY_WORDS, 0);
+  MTJumpState s;
+  unsigned long long x = 5489ULL;
+  for (int i = 0; i < NN; i++) {
+    s.mt[i] = x;
+    x = 6364136223846793005ULL * (x ^ (x >> 62)) + i + 1;
+  }
+  s.start = 0;
+  for (int i = 0; i < n; i++) {
+    int newest = s.start;
+    NextState(s);
+    if (s.mt[newest] & 1ULL) SetPolyBit(rev, n-1-i);
+  }
+
+  /* C = connection polynomial, B = C before the last length change */
+  GF2Poly C(POLY_WORDS, 0), B(POLY_WORDS, 0), T;
+  C[0] = B[0] = 1ULL;
+  int L = 0, m = 1;
+  for (int i = 0; i < n; i++) {
+    /* discrepancy = sum_{j=0..L} C_j s_(i-j), and s_(i-j) is bit
+     * (n-1-i)+j of rev; deg C <= L */
+    int offset = n-1-i;
+    unsigned long long d = 0;
+    for (int w = 0; w <= L/64; w++) {
+      int bit = offset + 64*w;
+      int word = bit/64, shift = bit%64;
+      unsigned long long r = rev[word] >> shift;
+      if (shift && word+1 < POLY_WORDS) r |= rev[word+1] << (64-shift);
+      d ^= C[w] & r;
+    }
+    d = __builtin_parityll(d);
+
+    if (!d) {
+      m++;
+      continue;
+    }
+    T = C;
+    /* C -= x^m B */
+    int ws = m/64, bs = m%64;
+    for (int w = POLY_WORDS-1; w >= ws; w--) {
+      unsigned long long v = B[w-ws] << bs;
+      if (bs && w-ws-1 >= 0) v |= B[w-ws-1] >> (64-bs);
+      C[w] ^= v;
+    }
+    if (2*L <= i) {
+      L = i+1-L;
+      B = T;
+      m = 1;
+    }
+    else {
+      m++;
+    }
+  }
+
+  if (L != MEXP) {
+    std::cout << "MersenneTwister: characteristic polynomial has degree "
+	      << L << ", expected " << MEXP << "\n";
+  }
+
+  /* P is the reciprocal of the connection polynomial */
+  GF2Poly P(POLY_WORDS, 0);
+  for (int j = 0; j <= L; j++) {
+    if (PolyBit(C, j)) SetPolyBit(P, L-j);
+  }
+  return P;
+}
+
+/* a = a^2 mod P, for deg a < MEXP */
+static void SquareMod(GF2Poly &a, const GF2Poly &P)
+{
+  GF2Poly sq(POLY_WORDS, 0);
+  for (int i = 0; i < MEXP; i++) {
+    if (PolyBit(a, i)) SetPolyBit(sq, 2*i);
+  }
+  for (int t = 2*MEXP-2; t >= MEXP; t--) {
+    if (!PolyBit(sq, t)) continue;
+    /* sq -= x^(t-MEXP) P */
+    int ws = (t-MEXP)/64, bs = (t-MEXP)%64;
+    for (int w = (MEXP+63)/64 + ws; w >= ws; w--) {
+      unsigned long long v = P[w-ws] << bs;
+      if (bs && w-ws-1 >= 0) v |= P[w-ws-1] >> (64-bs);
+      sq[w] ^= v;
+    }
+  }
+  a.swap(sq);
+}
+
+/* x^(2^k) mod P, computed once per k and cached */
+static const GF2Poly& JumpPolynomial(unsigned int k)
+{
+  static std::mutex jumpMutex;
+  static GF2Poly P;
+  static std::map<unsigned int, GF2Poly> cache;
+
+  std::lock_guard<std::mutex> lock(jumpMutex);
+  std::map<unsigned int, GF2Poly>::iterator it = cache.find(k);
+  if (it != cache.end()) return it->second;
+
+  if (P.empty()) P = CharacteristicPolynomial();
+
+  /* start from the largest cached power below k */
+  GF2Poly g(POLY_WORDS, 0);
+  unsigned int done = 0;
+  SetPolyBit(g, 1);
+  for (it = cache.begin(); it != cache.end() && it->first < k; ++it) {
+    g = it->second;
+    done = it->first;
+  }
+  for (; done < k; done++) {
+    SquareMod(g, P);
+  }
+  return cache[k] = g;
+}
+
+/* Advances the generator by 2^k numbers, as if genrand64_real3() had
+ * been called 2^k times.  The first call computes and caches the
+ * characteristic polynomial (well under a second); each new k adds k
+ * polynomial squarings.
+ */
+void MersenneTwister::Jump(unsigned int k)
+{
+  if (mti == NN+1) init_genrand64(5489ULL);
+
+  /* mt[] is the window of the recurrence that ends at the current
+   * block, with mti words of the block already used.  Advancing that
+   * window by J words and keeping mti leaves the next output J words
+   * further on.  The low bits of the oldest word, which g(T) may get
+   * wrong, are never read again. */
+  const GF2Poly &g = JumpPolynomial(k);
+
+  MTJumpState base, acc;
+  for (int i = 0; i < NN; i++) {
+    base.mt[i] = mt[i];
+    acc.mt[i] = 0;
+  }
+  base.start = acc.start = 0;
+
+  int degree = MEXP-1;
+  while (degree > 0 && !PolyBit(g, degree)) degree--;
+  for (int i = degree; i >= 0; i--) {
+    NextState(acc);
+    if (PolyBit(g, i)) AddState(acc, base);
+  }
+
+  for (int i = 0; i < NN; i++) {
+    mt[i] = acc.mt[(acc.start+i)%NN];
+  }
+}
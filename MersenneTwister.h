@@ -1,4 +1,3 @@
-
 #ifndef MERSENNETWISTER_H
 #define MERSENNETWISTER_H
 
@@ -12,20 +11,32 @@
 #include <iostream>
 #include <ctime>  // time seed to init_genrand64()
 
+/* 64-bit Mersenne Twister (MT19937-64).  Every object has its own
+ * state, so generators can be used from different threads as long as
+ * each thread has its own object.
+ *
+ * For parallel streams, seed one generator, copy it once per thread
+ * and call Jump(k) on the copies 1, 2, ... times: the streams are then
+ * 2^k numbers apart and do not overlap for fewer than 2^k draws each.
+ */
 class MersenneTwister {
  private:
   /* The array for the state vector */
-  static unsigned long long mt[NN]; 
+  unsigned long long mt[NN];
   /* mti==NN+1 means mt[NN] is not initialized */
-  static int mti;
+  int mti;
   void init_genrand64(unsigned long long seed);
-  void init_by_array64(unsigned long long init_key[],
+  void init_by_array64(const unsigned long long init_key[],
 		       unsigned long long key_length);
   unsigned long long genrand64_int64(void);
 
  public:
   MersenneTwister();
+  MersenneTwister(unsigned long long seed);
+  void Seed(unsigned long long seed);
+  void Seed(const unsigned long long key[], unsigned long long length);
+  void Jump(unsigned int k);
   double genrand64_real3(void);
+  void fill(double *array, size_t n);
 };
 #endif
-
@@ -0,0 +1,413 @@
+#include "Halton.h"
+#include "MT64.h"
+#include "InverseTransformation.h"
+#include "MersenneTwister.h"
+#include "DSFMT.h"
+#include "Philox.h"
+#include "rnglib.h"
+#include "pdflib.h"
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/* Microbenchmarks of the generator and transform kernels: per-call
+ * cost of halton::genHalton, halton::get_rnd, InverseTransformation::
+ * Normal, NormCDF (one at a time and in bulk, next to the
+ * Abramowitz-Stegun approximation it replaced) and LogNormCDF,
+ * MersenneTwister::genrand64_real3 and fill, DSFMT::fill, Philox::Fill,
+ * genRand_64::genrand64_real3, rnglib's r8_uni_01, GenPareto and
+ * pdflib's normal and gamma samplers (one at a time and in bulk), and
+ * the Gamma inverse CDF by root solve and by table, swept over
+ * dimension (Halton) or batch size (the others).
+ *
+ * Every case is run WARMUP times untimed, then REPS times timed.  The
+ * table reports the median ns per element (a Halton point or one
+ * generated/transformed number), elements per second and TSC cycles
+ * per element; the JSON file also holds min, mean and standard
+ * deviation over the repetitions.
+ *
+ * Usage: ./a.out [JSON file] [repetitions]
+ */
+
+#define WARMUP 3
+
+/* volatile sink so the compiler cannot drop the benchmarked calls */
+volatile Type sink;
+
+/* timings of one (kernel, dim, batch) case */
+struct MicroResult
+{
+  std::string kernel;
+  unsigned int dim;  /* Halton dimension, 1 for scalar kernels */
+  unsigned int batch;  /* elements per timed repetition */
+  std::vector<double> ns;  /* ns per element, one per repetition */
+  std::vector<double> cycles;  /* TSC cycles per element */
+};
+
+static inline unsigned long long ReadTSC()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/* The Abramowitz-Stegun 7.1.26 normal cdf (about 1e-7) that NormCDF
+ * used before, as the reference for its timings */
+static Type NormCDFAS(Type x)
+{
+  const Type a1 =  0.254829592;
+  const Type a2 = -0.284496736;
+  const Type a3 =  1.421413741;
+  const Type a4 = -1.453152027;
+  const Type a5 =  1.061405429;
+  const Type p  =  0.3275911;
+
+  Type z = fabs(x)*M_SQRT1_2;
+  Type t = 1.0/(1.0 + p*z);
+  Type y = 1.0 - ((((a5*t + a4)*t + a3)*t + a2)*t + a1)*t*exp(-z*z);
+  return (x < 0) ? 0.5*(1.0 - y) : 0.5*(1.0 + y);
+}
+
+/* Runs run() WARMUP + reps times; run() processes batch elements */
+template <class Kernel>
+MicroResult Measure(const std::string &kernel, unsigned int dim,
+		    unsigned int batch, int reps, Kernel run)
+{
+  MicroResult result;
+  result.kernel = kernel;
+  result.dim = dim;
+  result.batch = batch;
+
+  for (int r = 0; r < WARMUP; ++r)
+    {
+      run();
+    }
+
+  for (int r = 0; r < reps; ++r)
+    {
+      std::chrono::steady_clock::time_point tic
+	= std::chrono::steady_clock::now();
+      unsigned long long c0 = ReadTSC();
+      run();
+      unsigned long long c1 = ReadTSC();
+      double ns = std::chrono::duration<double, std::nano>
+	(std::chrono::steady_clock::now() - tic).count();
+
+      result.ns.push_back(ns/batch);
+      result.cycles.push_back((double)(c1 - c0)/batch);
+    }
+  return result;
+}
+
+/* min, median, mean and standard deviation of v */
+static void Statistics(std::vector<double> v, double &min, double &median,
+		       double &mean, double &sd)
+{
+  std::sort(v.begin(), v.end());
+  size_t n = v.size();
+  min = v[0];
+  median = (n % 2) ? v[n/2] : 0.5*(v[n/2 - 1] + v[n/2]);
+  mean = 0;
+  for (auto i : v)
+    {
+      mean += i;
+    }
+  mean /= n;
+  sd = 0;
+  for (auto i : v)
+    {
+      sd += (i - mean)*(i - mean);
+    }
+  sd = n > 1 ? sqrt(sd/(n - 1)) : 0;
+}
+
+int main(int argc, char** argv)
+{
+  std::string jsonFilename = argc > 1 ? argv[1] : "MicroBench.json";
+  int reps = argc > 2 ? atoi(argv[2]) : 15;
+  if (reps < 1)
+    {
+      std::cout << "reps must be a positive integer, got " << argv[2]
+		<< "\n";
+      return 1;
+    }
+
+  std::vector<MicroResult> results;
+  const unsigned int dims[] = {1, 2, 4, 8, 16, 64, 256, 1000};
+  const unsigned int batches[] = {64, 1024, 65536};
+
+  /**** Halton kernels, swept over dimension ****/
+  for (auto dim : dims)
+    {
+      const unsigned int points = 4096;
+      halton *RNG = new halton();
+      RNG->init(dim,true,true);
+
+      results.push_back
+	(Measure("genHalton", dim, points, reps, [&]()
+		 {
+		   for (unsigned int i = 0; i < points; ++i)
+		     {
+		       RNG->genHalton();
+		     }
+		   sink = RNG->get_rnd(1);
+		 }));
+
+      results.push_back
+	(Measure("get_rnd", dim, points*dim, reps, [&]()
+		 {
+		   Type sum = 0;
+		   for (unsigned int i = 0; i < points; ++i)
+		     {
+		       for (unsigned int d = 1; d <= dim; ++d)
+			 {
+			   sum += RNG->get_rnd(d);
+			 }
+		     }
+		   sink = sum;
+		 }));
+
+      delete RNG;
+    }
+
+  /**** scalar kernels, swept over batch size ****/
+  InverseTransformation invTrans;
+  MersenneTwister MT;
+  DSFMT dsfmt;
+  Philox philox(12345);
+  genRand_64 *pgR64 = genRand_64::Instance();
+  InverseCDFTable gammaTable;
+  invTrans.Tabulate(InverseTransformation::GAMMA_PARAM,
+		    std::vector<Type>{2.5, 1.0}, gammaTable);
+
+  for (auto batch : batches)
+    {
+      std::vector<Type> u(batch), x(batch), y(batch);
+      for (unsigned int i = 0; i < batch; ++i)
+	{
+	  u[i] = MT.genrand64_real3();
+	  x[i] = invTrans.Normal(u[i], 0, 1);
+	}
+
+      results.push_back
+	(Measure("Normal", 1, batch, reps, [&]()
+		 {
+		   Type sum = 0;
+		   for (unsigned int i = 0; i < batch; ++i)
+		     {
+		       sum += invTrans.Normal(u[i], 0, 1);
+		     }
+		   sink = sum;
+		 }));
+
+      results.push_back
+	(Measure("NormCDF (A&S 7.1.26, before)", 1, batch, reps, [&]()
+		 {
+		   Type sum = 0;
+		   for (unsigned int i = 0; i < batch; ++i)
+		     {
+		       sum += NormCDFAS(x[i]);
+		     }
+		   sink = sum;
+		 }));
+
+      results.push_back
+	(Measure("NormCDF", 1, batch, reps, [&]()
+		 {
+		   Type sum = 0;
+		   for (unsigned int i = 0; i < batch; ++i)
+		     {
+		       sum += invTrans.NormCDF(x[i]);
+		     }
+		   sink = sum;
+		 }));
+
+      results.push_back
+	(Measure("NormCDF (batch)", 1, batch, reps, [&]()
+		 {
+		   InverseTransformation::NormCDF(&x[0], batch, &y[0]);
+		   sink = y[batch - 1];
+		 }));
+
+      results.push_back
+	(Measure("LogNormCDF (batch)", 1, batch, reps, [&]()
+		 {
+		   InverseTransformation::LogNormCDF(&x[0], batch, &y[0]);
+		   sink = y[batch - 1];
+		 }));
+
+      results.push_back
+	(Measure("MersenneTwister::genrand64_real3", 1, batch, reps, [&]()
+		 {
+		   Type sum = 0;
+		   for (unsigned int i = 0; i < batch; ++i)
+		     {
+		       sum += MT.genrand64_real3();
+		     }
+		   sink = sum;
+		 }));
+
+      results.push_back
+	(Measure("MersenneTwister::fill", 1, batch, reps, [&]()
+		 {
+		   MT.fill(&u[0], batch);
+		   sink = u[batch - 1];
+		 }));
+
+      results.push_back
+	(Measure("DSFMT::fill", 1, batch, reps, [&]()
+		 {
+		   dsfmt.fill(&u[0], batch);
+		   sink = u[batch - 1];
+		 }));
+
+      results.push_back
+	(Measure("Philox::Fill", 1, batch, reps, [&]()
+		 {
+		   philox.Fill(0, batch, 1, &u[0]);
+		   sink = u[batch - 1];
+		 }));
+
+      results.push_back
+	(Measure("GenPareto", 1, batch, reps, [&]()
+		 {
+		   Type sum = 0;
+		   for (unsigned int i = 0; i < batch; ++i)
+		     {
+		       sum += invTrans.GenPareto(0.1, 1, 0);
+		     }
+		   sink = sum;
+		 }));
+
+      results.push_back
+	(Measure("GenPareto (bulk)", 1, batch, reps, [&]()
+		 {
+		   invTrans.GenPareto(0.1, 1, 0, &x[0], batch);
+		   sink = x[batch - 1];
+		 }));
+
+      results.push_back
+	(Measure("Gamma", 1, batch, reps, [&]()
+		 {
+		   Type sum = 0;
+		   for (unsigned int i = 0; i < batch; ++i)
+		     {
+		       sum += invTrans.Gamma(u[i], 2.5, 1.0);
+		     }
+		   sink = sum;
+		 }));
+
+      results.push_back
+	(Measure("InverseCDFTable (Gamma)", 1, batch, reps, [&]()
+		 {
+		   gammaTable.Evaluate(&u[0], &x[0], batch);
+		   sink = x[batch - 1];
+		 }));
+
+      results.push_back
+	(Measure("genRand_64::genrand64_real3", 1, batch, reps, [&]()
+		 {
+		   Type sum = 0;
+		   for (unsigned int i = 0; i < batch; ++i)
+		     {
+		       sum += pgR64->genrand64_real3();
+		     }
+		   sink = sum;
+		 }));
+
+      results.push_back
+	(Measure("r8_uni_01", 1, batch, reps, [&]()
+		 {
+		   Type sum = 0;
+		   for (unsigned int i = 0; i < batch; ++i)
+		     {
+		       sum += r8_uni_01();
+		     }
+		   sink = sum;
+		 }));
+
+      results.push_back
+	(Measure("r8_normal_01_sample", 1, batch, reps, [&]()
+		 {
+		   Type sum = 0;
+		   for (unsigned int i = 0; i < batch; ++i)
+		     {
+		       sum += r8_normal_01_sample();
+		     }
+		   sink = sum;
+		 }));
+
+      results.push_back
+	(Measure("r8_normal_01_fill", 1, batch, reps, [&]()
+		 {
+		   r8_normal_01_fill(batch, &x[0]);
+		   sink = x[batch - 1];
+		 }));
+
+      results.push_back
+	(Measure("r8_gamma_01_sample", 1, batch, reps, [&]()
+		 {
+		   Type sum = 0;
+		   for (unsigned int i = 0; i < batch; ++i)
+		     {
+		       sum += r8_gamma_01_sample(2.5);
+		     }
+		   sink = sum;
+		 }));
+
+      results.push_back
+	(Measure("r8_gamma_01_fill", 1, batch, reps, [&]()
+		 {
+		   r8_gamma_01_fill(2.5, batch, &x[0]);
+		   sink = x[batch - 1];
+		 }));
+    }
+
+  /**** report ****/
+  std::cout << std::left << std::setw(34) << "# kernel" << std::setw(6)
+	    << "dim" << std::setw(8) << "batch" << std::setw(12)
+	    << "ns/elem" << std::setw(13) << "elem/s" << "cycles/elem\n";
+
+  std::ofstream jsonFile(jsonFilename.c_str());
+  jsonFile << "{\n  \"warmup\": " << WARMUP << ",\n  \"repetitions\": "
+	   << reps << ",\n  \"results\": [\n";
+
+  for (size_t i = 0; i < results.size(); ++i)
+    {
+      const MicroResult &r = results[i];
+      double min, median, mean, sd, cMin, cMedian, cMean, cSd;
+      Statistics(r.ns, min, median, mean, sd);
+      Statistics(r.cycles, cMin, cMedian, cMean, cSd);
+
+      std::cout << std::left << std::setw(34) << r.kernel << std::setw(6)
+		<< r.dim << std::setw(8) << r.batch << std::setw(12)
+		<< std::setprecision(4) << median << std::setw(13)
+		<< std::setprecision(4) << 1e9/median
+		<< std::setprecision(4) << cMedian << "\n";
+
+      jsonFile << std::setprecision(6)
+	       << "    {\"kernel\": \"" << r.kernel << "\", \"dim\": "
+	       << r.dim << ", \"batch\": " << r.batch
+	       << ", \"ns_per_element\": {\"min\": " << min
+	       << ", \"median\": " << median << ", \"mean\": " << mean
+	       << ", \"stddev\": " << sd << "}"
+	       << ", \"elements_per_second\": " << 1e9/median
+	       << ", \"cycles_per_element\": {\"min\": " << cMin
+	       << ", \"median\": " << cMedian << ", \"mean\": " << cMean
+	       << ", \"stddev\": " << cSd << "}}"
+	       << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+  jsonFile << "  ]\n}\n";
+
+  std::cout << "\nJSON written to " << jsonFilename << "\n";
+}
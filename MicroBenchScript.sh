@@ -0,0 +1,6 @@
+#!/bin/bash
+
+g++ -O2 -std=c++0x -pthread MicroBenchDriver.cpp Halton.cpp MT64.cpp InverseTransformation.cpp ThreadPool.cpp InverseCDFTable.cpp MersenneTwister.cpp DSFMT.cpp Philox.cpp rnglib.cpp RngStream.cpp pdflib.cpp
+
+# ./a.out
+# ./a.out MicroBench.json 31
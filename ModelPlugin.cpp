@@ -0,0 +1,167 @@
+#include "ModelPlugin.h"
+#include <iostream>
+#include <mutex>
+#include <dlfcn.h>
+
+/* one loaded plugin */
+struct PluginSlot
+{
+  const SobolModelPlugin *plugin;
+  std::mutex callMutex;  /* serializes calls if !plugin->threadSafe */
+};
+
+static PluginSlot slots[MODELPLUGIN_SLOTS];
+static int numSlots = 0;
+static std::mutex loadMutex;
+
+/* which plugins the current thread has initialized; finishes them
+ * when the thread exits */
+struct PluginThreadState
+{
+  bool initialized[MODELPLUGIN_SLOTS];
+
+  PluginThreadState()
+  {
+    for (int k = 0; k < MODELPLUGIN_SLOTS; ++k)
+      {
+	initialized[k] = false;
+      }
+  }
+  ~PluginThreadState()
+  {
+    for (int k = 0; k < MODELPLUGIN_SLOTS; ++k)
+      {
+	if (initialized[k] && slots[k].plugin->threadFinish)
+	  {
+	    if (slots[k].plugin->threadSafe)
+	      {
+		slots[k].plugin->threadFinish();
+	      }
+	    else
+	      {
+		std::lock_guard<std::mutex> lock(slots[k].callMutex);
+		slots[k].plugin->threadFinish();
+	      }
+	  }
+      }
+  }
+};
+
+static thread_local PluginThreadState threadState;
+
+static inline void EnterThread(int k)
+{
+  if (!threadState.initialized[k])
+    {
+      threadState.initialized[k] = true;
+      if (slots[k].plugin->threadInit)
+	{
+	  slots[k].plugin->threadInit();
+	}
+    }
+}
+
+/* calls f, under the slot's lock if the plugin is not thread safe */
+template <class F>
+static inline void Call(int k, F f)
+{
+  if (slots[k].plugin->threadSafe)
+    {
+      EnterThread(k);
+      f(slots[k].plugin);
+    }
+  else
+    {
+      std::lock_guard<std::mutex> lock(slots[k].callMutex);
+      EnterThread(k);
+      f(slots[k].plugin);
+    }
+}
+
+/* ModelFunction and BatchModelFunction of slot k */
+template <int k>
+static Type PluginModel(const std::vector<Type> &x,
+			const std::vector<Type> &constants)
+{
+  Type y = 0;
+  Call(k, [&](const SobolModelPlugin *p)
+       {
+	 y = p->evaluate(x.data(), x.size(), constants.data(),
+			 constants.size());
+       });
+  return y;
+}
+
+template <int k>
+static void PluginBatchModel(const Type *X, unsigned int n, int dim,
+			     const std::vector<Type> &constants, Type *Y)
+{
+  Call(k, [&](const SobolModelPlugin *p)
+       {
+	 p->evaluateBatch(X, n, dim, constants.data(), constants.size(),
+			  Y);
+       });
+}
+
+#define PLUGIN_SLOT(k) {PluginModel<k>, PluginBatchModel<k>}
+static const struct
+{
+  ModelFunction model;
+  BatchModelFunction batchModel;
+} forward[MODELPLUGIN_SLOTS] =
+  {PLUGIN_SLOT(0), PLUGIN_SLOT(1), PLUGIN_SLOT(2), PLUGIN_SLOT(3),
+   PLUGIN_SLOT(4), PLUGIN_SLOT(5), PLUGIN_SLOT(6), PLUGIN_SLOT(7),
+   PLUGIN_SLOT(8), PLUGIN_SLOT(9), PLUGIN_SLOT(10), PLUGIN_SLOT(11),
+   PLUGIN_SLOT(12), PLUGIN_SLOT(13), PLUGIN_SLOT(14), PLUGIN_SLOT(15)};
+
+/* Loads the plugin at path (a path with a '/', or a name searched like
+ * any shared library) and registers its model.  Returns the name it is
+ * registered under, or "" after printing why it could not be loaded.
+ * Loading the same plugin again returns its name without a new slot.
+ */
+std::string ModelPlugin::Load(const std::string &path)
+{
+  std::lock_guard<std::mutex> lock(loadMutex);
+
+  void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!handle)
+    {
+      std::cout << "cannot load plugin: " << dlerror() << "\n";
+      return "";
+    }
+  SobolModelPluginEntry entry
+    = (SobolModelPluginEntry)dlsym(handle, SOBOL_PLUGIN_ENTRY);
+  const SobolModelPlugin *plugin = entry ? entry() : NULL;
+  if (!plugin || plugin->abiVersion != SOBOL_PLUGIN_ABI_VERSION
+      || !plugin->name || !plugin->evaluate)
+    {
+      std::cout << path << " is not a model plugin of ABI version "
+		<< SOBOL_PLUGIN_ABI_VERSION << "\n";
+      dlclose(handle);
+      return "";
+    }
+
+  for (int k = 0; k < numSlots; ++k)
+    {
+      if (slots[k].plugin == plugin)
+	{
+	  dlclose(handle);  /* drop the extra reference */
+	  return plugin->name;
+	}
+    }
+  if (numSlots == MODELPLUGIN_SLOTS)
+    {
+      std::cout << "cannot load " << path << ": more than "
+		<< MODELPLUGIN_SLOTS << " plugins\n";
+      dlclose(handle);
+      return "";
+    }
+
+  int k = numSlots++;
+  slots[k].plugin = plugin;
+  ModelRegistry::Instance()->Register(plugin->name, forward[k].model,
+				      plugin->evaluateBatch
+				      ? forward[k].batchModel : NULL,
+				      plugin->threadSafe != 0);
+  return plugin->name;
+}
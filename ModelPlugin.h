@@ -0,0 +1,29 @@
+/* Class ModelPlugin loads models from shared objects implementing the
+ * C ABI of SobolModelPlugin.h and registers them in ModelRegistry, so
+ * drivers, SobolBatch and SobolServer can use them by name like the
+ * built-in models, without recompiling.
+ *
+ * ModelRegistry holds plain function pointers, so each loaded plugin
+ * takes one of MODELPLUGIN_SLOTS slots, each with its own pair of
+ * scalar and batched forwarding functions.  The forwarding functions
+ * call the plugin's threadInit in every thread on first use (and
+ * threadFinish when the thread exits), and hold a per-plugin lock
+ * around every call of a plugin that is not thread safe.  Plugins stay
+ * loaded until the process ends.
+ */
+
+#ifndef MODELPLUGIN_H
+#define MODELPLUGIN_H
+
+#include <string>
+#include "ModelRegistry.h"
+#include "SobolModelPlugin.h"
+
+#define MODELPLUGIN_SLOTS 16
+
+class ModelPlugin
+{
+ public:
+  static std::string Load(const std::string &path);
+};
+#endif
@@ -0,0 +1,97 @@
+#include "ModelRegistry.h"
+
+ModelRegistry* ModelRegistry::_instance = NULL;
+
+/* Private ctor registers the built-in models */
+ModelRegistry::ModelRegistry()
+{
+  models["linear"] = LinearModel;
+}
+
+/* Returns the process-wide registry, constructing it on first use */
+ModelRegistry* ModelRegistry::Instance()
+{
+  static std::once_flag once;
+  std::call_once(once, [](){ _instance = new ModelRegistry(); });
+  return _instance;
+}
+
+/* Adds (or replaces) the model stored under name.  batchModel is the
+ * optional batched form of the same model; isThreadSafe false tells
+ * callers not to run the model in several threads, since they would
+ * only wait for each other. */
+void ModelRegistry::Register(const std::string &name, ModelFunction model,
+			     BatchModelFunction batchModel,
+			     bool isThreadSafe)
+{
+  std::lock_guard<std::mutex> lock(registryMutex);
+  models[name] = model;
+  threadSafe[name] = isThreadSafe;
+  if (batchModel)
+    {
+      batchModels[name] = batchModel;
+    }
+  else
+    {
+      batchModels.erase(name);
+    }
+}
+
+/* Returns the model stored under name, NULL if there is none */
+ModelFunction ModelRegistry::Lookup(const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(registryMutex);
+  std::map<std::string, ModelFunction>::iterator it = models.find(name);
+  if (it == models.end())
+    {
+      return NULL;
+    }
+  return it->second;
+}
+
+/* Returns the batched form of the model stored under name, NULL if the
+ * model has none */
+BatchModelFunction ModelRegistry::LookupBatch(const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(registryMutex);
+  std::map<std::string, BatchModelFunction>::iterator it
+    = batchModels.find(name);
+  if (it == batchModels.end())
+    {
+      return NULL;
+    }
+  return it->second;
+}
+
+/* Returns whether the model stored under name may be called from
+ * several threads at once */
+bool ModelRegistry::IsThreadSafe(const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(registryMutex);
+  std::map<std::string, bool>::iterator it = threadSafe.find(name);
+  return it == threadSafe.end() || it->second;
+}
+
+/* Returns the names of all registered models */
+std::vector<std::string> ModelRegistry::GetNames()
+{
+  std::lock_guard<std::mutex> lock(registryMutex);
+  std::vector<std::string> names;
+  for (const auto& i : models)
+    {
+      names.push_back(i.first);
+    }
+  return names;
+}
+
+Type LinearModel(const std::vector<Type> &parameters,
+		 const std::vector<Type> &constants)
+{
+  Type Y = 0;
+  Type c = constants.empty() ? 1.0 : constants[0];
+  for (size_t i = 0; i < parameters.size(); ++i)
+    {
+      Y += c*parameters[i];
+    }
+  return Y;
+}
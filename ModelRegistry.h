@@ -0,0 +1,54 @@
+/* Class ModelRegistry maps model names to model functions so that a
+ * model can be chosen at run time (by the sensitivity-analysis server,
+ * for instance) instead of being hard-coded in a driver.
+ */
+
+#ifndef MODELREGISTRY_H
+#define MODELREGISTRY_H
+
+#include <map>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+typedef double Type;
+
+/* model signature used by SobolIndices: first arg is the vector of
+ * random parameters, second the vector of fixed constants */
+typedef Type (*ModelFunction)(const std::vector<Type>&,
+			      const std::vector<Type>&);
+
+/* batched form of a model: evaluates the n points stored row-major in
+ * X (n x dim) and writes the n outputs to Y */
+typedef void (*BatchModelFunction)(const Type *X, unsigned int n,
+				   int dim,
+				   const std::vector<Type> &constants,
+				   Type *Y);
+
+class ModelRegistry
+{
+ private:
+  std::map<std::string, ModelFunction> models;
+  std::map<std::string, BatchModelFunction> batchModels;
+  std::map<std::string, bool> threadSafe;  /* absent means true */
+  std::mutex registryMutex;
+  static ModelRegistry *_instance;
+  ModelRegistry();
+
+ public:
+  static ModelRegistry* Instance();
+  void Register(const std::string &name, ModelFunction model,
+		BatchModelFunction batchModel = NULL,
+		bool isThreadSafe = true);
+  ModelFunction Lookup(const std::string &name);
+  BatchModelFunction LookupBatch(const std::string &name);
+  bool IsThreadSafe(const std::string &name);
+  std::vector<std::string> GetNames();
+};
+
+/* Built-in linear model, Y = c*(x_1 + ... + x_dim) with c = constants[0]
+ * if given, 1 otherwise.  Registered as "linear". */
+Type LinearModel(const std::vector<Type> &parameters,
+		 const std::vector<Type> &constants);
+#endif
@@ -0,0 +1,94 @@
+#include "ParseUtils.h"
+#include "InverseTransformation.h"
+#include <cstdlib>
+#include <sstream>
+
+/* Splits s at every occurrence of delim; empty pieces are dropped */
+std::vector<std::string> Split(const std::string &s, char delim)
+{
+  std::vector<std::string> pieces;
+  std::string piece;
+  std::istringstream stream(s);
+  while (std::getline(stream, piece, delim))
+    {
+      if (!piece.empty())
+	{
+	  pieces.push_back(piece);
+	}
+    }
+  return pieces;
+}
+
+/* Parses a comma-separated list of numbers, false on a bad entry */
+bool ParseNumbers(const std::string &s, std::vector<Type> &numbers)
+{
+  numbers.clear();
+  for (const auto& i : Split(s, ','))
+    {
+      char *end;
+      Type value = strtod(i.c_str(), &end);
+      if (*end != '\0')
+	{
+	  return false;
+	}
+      numbers.push_back(value);
+    }
+  return true;
+}
+
+/* Parses a comma-separated index set such as "1,3".  Indices are 1
+ * based and must not exceed dim.  Returns false on a bad entry. */
+bool ParseIndexSet(const std::string &s, int dim, std::set<int> &indices)
+{
+  std::vector<Type> numbers;
+  if (!ParseNumbers(s, numbers))
+    {
+      return false;
+    }
+
+  indices.clear();
+  for (auto j : numbers)
+    {
+      if (j < 1 || j > dim || j != (int)j)
+	{
+	  return false;
+	}
+      indices.insert((int)j);
+    }
+  return true;
+}
+
+/* Parses one parameter distribution "<family>:<p1>,<p2>,..." such as
+ * "gamma:2,0.5", see InverseTransformation for the families and their
+ * parameters.  Without a family name the numbers are the mean and
+ * variance of a normal distribution.  Returns false on an unknown
+ * family or bad parameters. */
+bool ParseDistribution(const std::string &s, int &family,
+		       std::vector<Type> &params)
+{
+  std::string numbers = s;
+  family = InverseTransformation::NORMAL_PARAM;
+  size_t colon = s.find(':');
+  if (colon != std::string::npos)
+    {
+      family = InverseTransformation::FamilyFromName(s.substr(0, colon));
+      numbers = s.substr(colon + 1);
+    }
+  return ParseNumbers(numbers, params)
+    && InverseTransformation::ValidParams(family, params);
+}
+
+/* Formats an index set as "1,2,3" */
+std::string FormatSet(const std::set<int> &s)
+{
+  std::ostringstream out;
+  for (std::set<int>::const_iterator i = s.begin(); i != s.end(); ++i)
+    {
+      if (i != s.begin())
+	{
+	  out << ",";
+	}
+      out << *i;
+    }
+  return out.str();
+}
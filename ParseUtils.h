@@ -0,0 +1,21 @@
+/* Small text helpers shared by the drivers and the server that read
+ * job descriptions: splitting, number lists, index sets and parameter
+ * distributions.
+ */
+
+#ifndef PARSEUTILS_H
+#define PARSEUTILS_H
+
+#include <set>
+#include <string>
+#include <vector>
+
+typedef double Type;
+
+std::vector<std::string> Split(const std::string &s, char delim);
+bool ParseNumbers(const std::string &s, std::vector<Type> &numbers);
+bool ParseIndexSet(const std::string &s, int dim, std::set<int> &indices);
+bool ParseDistribution(const std::string &s, int &family,
+		       std::vector<Type> &params);
+std::string FormatSet(const std::set<int> &s);
+#endif
@@ -0,0 +1,148 @@
+#include "Philox.h"
+
+/* Ctor
+ * Input:
+ *   seed = 64-bit key of the generator
+ */
+Philox::Philox(uint64_t seed)
+{
+  SetSeed(seed);
+}
+
+void Philox::SetSeed(uint64_t seed)
+{
+  key[0] = (uint32_t)seed;
+  key[1] = (uint32_t)(seed >> 32);
+}
+
+/* one Philox round on counter c with round key k */
+static inline void PhiloxRound(uint32_t c[4], const uint32_t k[2])
+{
+  uint64_t p0 = (uint64_t)PHILOX_M0*c[0];
+  uint64_t p1 = (uint64_t)PHILOX_M1*c[2];
+  uint32_t hi0 = (uint32_t)(p0 >> 32), lo0 = (uint32_t)p0;
+  uint32_t hi1 = (uint32_t)(p1 >> 32), lo1 = (uint32_t)p1;
+  c[0] = hi1 ^ c[1] ^ k[0];
+  c[1] = lo1;
+  c[2] = hi0 ^ c[3] ^ k[1];
+  c[3] = lo0;
+}
+
+/* 53-bit double in the open interval (0,1) from two 32-bit words, as
+ * MersenneTwister::genrand64_real3() */
+static inline Type ToUniform(uint32_t hi, uint32_t lo)
+{
+  uint64_t x = ((uint64_t)hi << 32) | lo;
+  return ((x >> 12) + 0.5) * (1.0/4503599627370496.0);
+}
+
+/* Philox4x32-10 of counter under key_, into out */
+void Philox::Block(const uint32_t counter[4], const uint32_t key_[2],
+		   uint32_t out[4])
+{
+  uint32_t c[4] = {counter[0], counter[1], counter[2], counter[3]};
+  uint32_t k[2] = {key_[0], key_[1]};
+  for (int r = 0; r < PHILOX_ROUNDS; ++r)
+    {
+      if (r > 0)
+	{
+	  k[0] += PHILOX_W0;
+	  k[1] += PHILOX_W1;
+	}
+      PhiloxRound(c, k);
+    }
+  out[0] = c[0];
+  out[1] = c[1];
+  out[2] = c[2];
+  out[3] = c[3];
+}
+
+/* Returns coordinate d (0-based) of the given sample, in (0,1) */
+Type Philox::Uniform(uint64_t sample, unsigned int d) const
+{
+  uint32_t counter[4] = {d/2, 0, (uint32_t)sample,
+			 (uint32_t)(sample >> 32)};
+  uint32_t out[4];
+  Block(counter, key, out);
+  return (d % 2) ? ToUniform(out[2], out[3]) : ToUniform(out[0], out[1]);
+}
+
+/* Fills u (row-major, n rows of dim) with samples firstSample, ...,
+ * firstSample + n - 1; row i equals Uniform(firstSample + i, d) for
+ * d = 0..dim-1.  PHILOX_LANES counters go through the rounds side by
+ * side, in separate arrays per word, so the compiler can put the
+ * 32x32->64 bit multiplies of different counters in one SIMD register.
+ */
+void Philox::Fill(uint64_t firstSample, unsigned int n, unsigned int dim,
+		  Type *u) const
+{
+  const unsigned int blocks = (dim + 1)/2;
+  const uint64_t total = (uint64_t)n*blocks;
+
+  uint32_t c0[PHILOX_LANES], c1[PHILOX_LANES], c2[PHILOX_LANES],
+    c3[PHILOX_LANES];
+  uint64_t rowOf[PHILOX_LANES];
+  unsigned int blockOf[PHILOX_LANES];
+
+  /* (row, block) of the next counter, advanced without divisions */
+  uint64_t row = 0;
+  unsigned int block = 0;
+
+  for (uint64_t first = 0; first < total; first += PHILOX_LANES)
+    {
+      unsigned int lanes = (total - first < PHILOX_LANES)
+	? (unsigned int)(total - first) : PHILOX_LANES;
+
+      /* counters of (sample, block) pairs first .. first+lanes-1; idle
+       * lanes repeat the last one */
+      for (unsigned int l = 0; l < PHILOX_LANES; ++l)
+	{
+	  uint64_t sample = firstSample + row;
+	  rowOf[l] = row;
+	  blockOf[l] = block;
+	  c0[l] = block;
+	  c1[l] = 0;
+	  c2[l] = (uint32_t)sample;
+	  c3[l] = (uint32_t)(sample >> 32);
+	  if (l + 1 < lanes && ++block == blocks)
+	    {
+	      block = 0;
+	      ++row;
+	    }
+	}
+      if (++block == blocks)
+	{
+	  block = 0;
+	  ++row;
+	}
+
+      uint32_t k0 = key[0], k1 = key[1];
+      for (int r = 0; r < PHILOX_ROUNDS; ++r)
+	{
+	  if (r > 0)
+	    {
+	      k0 += PHILOX_W0;
+	      k1 += PHILOX_W1;
+	    }
+	  for (unsigned int l = 0; l < PHILOX_LANES; ++l)
+	    {
+	      uint64_t p0 = (uint64_t)PHILOX_M0*c0[l];
+	      uint64_t p1 = (uint64_t)PHILOX_M1*c2[l];
+	      c0[l] = (uint32_t)(p1 >> 32) ^ c1[l] ^ k0;
+	      c1[l] = (uint32_t)p1;
+	      c2[l] = (uint32_t)(p0 >> 32) ^ c3[l] ^ k1;
+	      c3[l] = (uint32_t)p0;
+	    }
+	}
+
+      for (unsigned int l = 0; l < lanes; ++l)
+	{
+	  Type *out = u + rowOf[l]*dim + 2*blockOf[l];
+	  out[0] = ToUniform(c0[l], c1[l]);
+	  if (2*blockOf[l] + 1 < dim)
+	    {
+	      out[1] = ToUniform(c2[l], c3[l]);
+	    }
+	}
+    }
+}
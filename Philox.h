@@ -0,0 +1,44 @@
+/* Class Philox is the counter-based Philox4x32-10 generator of Salmon
+ * et al. (Random123).  It keeps no stream state: the numbers for a
+ * sample are a pure function of (seed, sample index, dimension), so any
+ * thread or process can produce any sample on its own and results do
+ * not depend on how the samples are split among threads.
+ *
+ * Each call of the block cipher maps the 128-bit counter
+ * (block, 0, sample lo, sample hi) under the 64-bit key (the seed) to
+ * four 32-bit words, which make two doubles in (0,1).  Coordinate d of
+ * a sample therefore comes from block d/2.
+ */
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U  /* golden ratio */
+#define PHILOX_W1 0xBB67AE85U  /* sqrt(3) - 1 */
+#define PHILOX_ROUNDS 10
+#define PHILOX_LANES 8  /* counters processed together in Fill() */
+
+typedef double Type;
+
+class Philox
+{
+ private:
+  uint32_t key[2];
+
+ public:
+  Philox(uint64_t seed = 0);
+  void SetSeed(uint64_t seed);
+  uint64_t GetSeed() const {return ((uint64_t)key[1] << 32) | key[0];}
+
+  static void Block(const uint32_t counter[4], const uint32_t key_[2],
+		    uint32_t out[4]);
+  Type Uniform(uint64_t sample, unsigned int d) const;
+  void Fill(uint64_t firstSample, unsigned int n, unsigned int dim,
+	    Type *u) const;
+};
+#endif
@@ -0,0 +1,196 @@
+#include "QMCDesign.h"
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Ctor
+ * Input:
+ *
+ * N_ = number of points in the design
+ * cols_ = number of coordinates per point, 2*dim for Sobol' indices
+ */
+QMCDesign::QMCDesign(unsigned int N_, int cols_)
+{
+  N = N_;
+  cols = cols_;
+  isStandardNormal = false;
+  points.resize((size_t)N*cols);
+  data = points.data();
+  mapping = NULL;
+  mappingLength = 0;
+}
+
+/* Dtor: unmaps a mapped design */
+QMCDesign::~QMCDesign()
+{
+  if (mapping)
+    {
+      munmap(mapping, mappingLength);
+    }
+}
+
+/* Maps the design saved in path read-only.  Returns NULL if the file
+ * does not exist or is not a complete design of this version; the
+ * caller owns the returned object. */
+QMCDesign* QMCDesign::Map(const std::string &path)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    {
+      return NULL;
+    }
+
+  struct stat st;
+  void *map = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size >= QMCDESIGN_DATA_OFFSET)
+    {
+      map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+  close(fd);
+  if (map == MAP_FAILED)
+    {
+      return NULL;
+    }
+
+  QMCDesignHeader header;
+  std::memcpy(&header, map, sizeof(header));
+  size_t length = st.st_size;
+  if (std::memcmp(header.magic, QMCDESIGN_MAGIC, sizeof(header.magic))
+      || header.version != QMCDESIGN_VERSION
+      || header.typeSize != sizeof(Type)
+      || header.dataOffset != QMCDESIGN_DATA_OFFSET
+      || length != header.dataOffset + header.N*header.cols*sizeof(Type))
+    {
+      std::cout << path << " is not a design of this version\n";
+      munmap(map, length);
+      return NULL;
+    }
+
+  QMCDesign *design = new QMCDesign(0, header.cols);
+  design->N = header.N;
+  design->isStandardNormal = header.isStandardNormal;
+  design->data = (const Type*)((const char*)map + header.dataOffset);
+  design->mapping = map;
+  design->mappingLength = length;
+  return design;
+}
+
+/* Writes the design to path.  The file is written under a temporary
+ * name and renamed into place, so other processes see either no file
+ * or the complete one, and concurrent writers of the same design just
+ * replace each other's copy.  Returns false on I/O errors. */
+bool QMCDesign::Save(const std::string &path) const
+{
+  std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+  int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    {
+      std::cout << "cannot write " << tmpPath << "\n";
+      return false;
+    }
+
+  std::vector<char> head(QMCDESIGN_DATA_OFFSET, 0);
+  QMCDesignHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, QMCDESIGN_MAGIC, sizeof(header.magic));
+  header.version = QMCDESIGN_VERSION;
+  header.typeSize = sizeof(Type);
+  header.N = N;
+  header.cols = cols;
+  header.isStandardNormal = isStandardNormal;
+  header.dataOffset = QMCDESIGN_DATA_OFFSET;
+  std::memcpy(&head[0], &header, sizeof(header));
+
+  bool ok = true;
+  const char *chunks[2] = {&head[0], (const char*)data};
+  size_t lengths[2] = {head.size(), (size_t)N*cols*sizeof(Type)};
+  for (int c = 0; c < 2 && ok; ++c)
+    {
+      size_t done = 0;
+      while (done < lengths[c])
+	{
+	  ssize_t n = write(fd, chunks[c] + done, lengths[c] - done);
+	  if (n <= 0)
+	    {
+	      ok = false;
+	      break;
+	    }
+	  done += n;
+	}
+    }
+  ok = (fsync(fd) == 0) && ok;
+  ok = (close(fd) == 0) && ok;
+  if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+      std::cout << "cannot write " << path << "\n";
+      unlink(tmpPath.c_str());
+      return false;
+    }
+  return true;
+}
+
+/* Fills the design with the next N points of RNG.  The generator may
+ * have been initialized with more than cols dimensions, in which case
+ * only the first cols coordinates of each point are kept.
+ */
+void QMCDesign::Generate(halton *RNG)
+{
+  if (mapping)
+    {
+      std::cout << "QMCDesign::Generate: design is read-only\n";
+      return;
+    }
+
+  for (unsigned int i = 0; i < N; ++i)
+    {
+      RNG->genHalton();
+
+      Type *row = &points[(size_t)i*cols];
+      for (int j = 0; j < cols; ++j)
+	{
+	  row[j] = RNG->get_rnd(j+1);
+	}
+    }
+  isStandardNormal = false;
+}
+
+/* Fills the design with samples firstSample, ..., firstSample + N - 1
+ * of the counter-based generator philox, for plain MC instead of QMC */
+void QMCDesign::Generate(const Philox &philox, uint64_t firstSample)
+{
+  if (mapping)
+    {
+      std::cout << "QMCDesign::Generate: design is read-only\n";
+      return;
+    }
+  philox.Fill(firstSample, N, cols, &points[0]);
+  isStandardNormal = false;
+}
+
+/* Maps every Unif(0,1) coordinate to N(0,1).  A N(mean,variance) value
+ * is then mean + sqrt(variance)*z, which is exactly what
+ * InverseTransformation::Normal() would return for the original
+ * uniform, so the per-job transform reduces to a multiply-add.
+ */
+void QMCDesign::TransformToStandardNormal(InverseTransformation *invTrans)
+{
+  if (isStandardNormal)
+    {
+      return;
+    }
+  if (mapping)
+    {
+      std::cout << "QMCDesign::TransformToStandardNormal: design is "
+		<< "read-only\n";
+      return;
+    }
+
+  for (auto& u : points)
+    {
+      u = invTrans->Normal(u, 0.0, 1.0);
+    }
+  isStandardNormal = true;
+}
@@ -0,0 +1,71 @@
+/* Class QMCDesign holds a block of quasi-random points, one row per
+ * Monte Carlo run, so that the same points can be reused by several
+ * Sobol' index computations instead of being regenerated each time.
+ * Rows hold the 2*dim coordinates consumed by one iteration of
+ * SobolIndices::ComputeSensitivityIndices(): the first dim for x1, the
+ * last dim for x2.
+ *
+ * A design can be saved to a binary file and mapped back read-only by
+ * later runs or other processes, which then share the page cache; see
+ * DesignStore.  The file is a QMCDesignHeader, padded to
+ * QMCDESIGN_DATA_OFFSET so that the points start page aligned, then the
+ * row-major N x cols matrix of doubles in native byte order.
+ */
+
+#ifndef QMCDESIGN_H
+#define QMCDESIGN_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "Halton.h"
+#include "InverseTransformation.h"
+#include "Philox.h"
+
+#define QMCDESIGN_MAGIC "QMCDSGN"  /* 8 bytes with the terminating 0 */
+#define QMCDESIGN_VERSION 1
+#define QMCDESIGN_DATA_OFFSET 4096
+
+typedef double Type;
+
+struct QMCDesignHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t typeSize;  /* sizeof(Type) */
+  uint64_t N;
+  uint64_t cols;
+  uint32_t isStandardNormal;
+  uint32_t reserved;
+  uint64_t dataOffset;
+};
+
+class QMCDesign
+{
+ private:
+  unsigned int N;  /* number of points (rows) */
+  int cols;  /* number of coordinates stored per point */
+  bool isStandardNormal;  /* true once mapped from Unif(0,1) to N(0,1) */
+  std::vector<Type> points;  /* row-major N x cols matrix */
+  const Type *data;  /* &points[0], or the points of the mapped file */
+  void *mapping;  /* mapped file, NULL if the points are in memory */
+  size_t mappingLength;
+
+  QMCDesign(const QMCDesign&) = delete;
+  QMCDesign& operator=(const QMCDesign&) = delete;
+
+ public:
+  QMCDesign(unsigned int N_, int cols_);
+  ~QMCDesign();
+  static QMCDesign* Map(const std::string &path);
+  bool Save(const std::string &path) const;
+  void Generate(halton *RNG);
+  void Generate(const Philox &philox, uint64_t firstSample);
+  void TransformToStandardNormal(InverseTransformation *invTrans);
+  const Type* Row(unsigned int i) const {return data + (size_t)i*cols;}
+  unsigned int GetN() const {return N;}
+  int GetCols() const {return cols;}
+  bool IsStandardNormal() const {return isStandardNormal;}
+  bool IsMapped() const {return mapping != NULL;}
+};
+#endif
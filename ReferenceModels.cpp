@@ -0,0 +1,348 @@
+#include "ReferenceModels.h"
+#include <cmath>
+#include <complex>
+
+/* Returns c[i] if the caller supplied it, otherwise dflt */
+static inline Type Constant(const std::vector<Type> &c, size_t i,
+			    Type dflt)
+{
+  return i < c.size() ? c[i] : dflt;
+}
+
+/* default a_i of the g-function: two important, two moderately
+ * important and the rest unimportant parameters */
+static inline Type GFunctionA(const std::vector<Type> &c, int i)
+{
+  static const Type a[] = {0, 1, 4.5, 9};
+  return Constant(c, i, i < 4 ? a[i] : 99);
+}
+
+/**** Ishigami: sin x1 + a sin^2 x2 + b x3^4 sin x1 ****/
+
+static inline Type IshigamiKernel(const Type *x, Type a, Type b)
+{
+  Type s = sin(x[1]);
+  return sin(x[0])*(1 + b*pow(x[2], 4.0)) + a*s*s;
+}
+
+Type Ishigami(const std::vector<Type> &x, const std::vector<Type> &c)
+{
+  return IshigamiKernel(&x[0], Constant(c, 0, 7), Constant(c, 1, 0.1));
+}
+
+void IshigamiBatch(const Type *X, unsigned int n, int dim,
+		   const std::vector<Type> &c, Type *Y)
+{
+  Type a = Constant(c, 0, 7), b = Constant(c, 1, 0.1);
+  for (unsigned int i = 0; i < n; ++i)
+    {
+      Y[i] = IshigamiKernel(X + (size_t)i*dim, a, b);
+    }
+}
+
+/**** Sobol' g-function: prod (|4 x_i - 2| + a_i)/(1 + a_i) ****/
+
+Type GFunction(const std::vector<Type> &x, const std::vector<Type> &c)
+{
+  Type Y = 1;
+  for (size_t i = 0; i < x.size(); ++i)
+    {
+      Type a = GFunctionA(c, i);
+      Y *= (std::abs(4*x[i] - 2) + a)/(1 + a);
+    }
+  return Y;
+}
+
+void GFunctionBatch(const Type *X, unsigned int n, int dim,
+		    const std::vector<Type> &c, Type *Y)
+{
+  std::vector<Type> a(dim), scale(dim);
+  for (int j = 0; j < dim; ++j)
+    {
+      a[j] = GFunctionA(c, j);
+      scale[j] = 1/(1 + a[j]);
+    }
+
+  for (unsigned int i = 0; i < n; ++i)
+    {
+      const Type *x = X + (size_t)i*dim;
+      Type y = 1;
+      for (int j = 0; j < dim; ++j)
+	{
+	  y *= (std::abs(4*x[j] - 2) + a[j])*scale[j];
+	}
+      Y[i] = y;
+    }
+}
+
+/**** Bratley: sum_i (-1)^i prod_{j <= i} x_j ****/
+
+static inline Type BratleyKernel(const Type *x, int dim)
+{
+  Type Y = 0, product = 1, sign = -1;
+  for (int i = 0; i < dim; ++i)
+    {
+      product *= x[i];
+      Y += sign*product;
+      sign = -sign;
+    }
+  return Y;
+}
+
+Type Bratley(const std::vector<Type> &x, const std::vector<Type> &c)
+{
+  return BratleyKernel(&x[0], x.size());
+}
+
+void BratleyBatch(const Type *X, unsigned int n, int dim,
+		  const std::vector<Type> &c, Type *Y)
+{
+  for (unsigned int i = 0; i < n; ++i)
+    {
+      Y[i] = BratleyKernel(X + (size_t)i*dim, dim);
+    }
+}
+
+/**** Additive: sum_i x_i/i ****/
+
+Type Additive(const std::vector<Type> &x, const std::vector<Type> &c)
+{
+  Type Y = 0;
+  for (size_t i = 0; i < x.size(); ++i)
+    {
+      Y += x[i]/(i + 1);
+    }
+  return Y;
+}
+
+void AdditiveBatch(const Type *X, unsigned int n, int dim,
+		   const std::vector<Type> &c, Type *Y)
+{
+  std::vector<Type> weight(dim);
+  for (int j = 0; j < dim; ++j)
+    {
+      weight[j] = 1.0/(j + 1);
+    }
+
+  for (unsigned int i = 0; i < n; ++i)
+    {
+      const Type *x = X + (size_t)i*dim;
+      Type y = 0;
+      for (int j = 0; j < dim; ++j)
+	{
+	  y += x[j]*weight[j];
+	}
+      Y[i] = y;
+    }
+}
+
+/**** Vasicek zero-coupon bond price P(0,T), params log a, log b,
+ **** log sigma as in the drivers ****/
+
+static inline Type VasicekKernel(const Type *x, Type r0, Type T)
+{
+  /* drew log a, log b, log sigma, so convert back */
+  Type a = exp(x[0]), b = exp(x[1]), sigma = exp(x[2]);
+
+  Type B = (1 - exp(-a*T))/a;
+  Type logA = (b - sigma*sigma/(2*a*a))*(B - T)
+    - sigma*sigma*B*B/(4*a);
+  return exp(logA - B*r0);
+}
+
+Type Vasicek(const std::vector<Type> &x, const std::vector<Type> &c)
+{
+  return VasicekKernel(&x[0], Constant(c, 0, 0.03), Constant(c, 1, 5));
+}
+
+void VasicekBatch(const Type *X, unsigned int n, int dim,
+		  const std::vector<Type> &c, Type *Y)
+{
+  Type r0 = Constant(c, 0, 0.03), T = Constant(c, 1, 5);
+  for (unsigned int i = 0; i < n; ++i)
+    {
+      Y[i] = VasicekKernel(X + (size_t)i*dim, r0, T);
+    }
+}
+
+/**** Heston European call, params kappa, theta, sigma, rho, v0.
+ **** Price from the characteristic function (Albrecher et al.'s
+ **** formulation, which avoids the branch cut of the complex log),
+ **** integrated with the midpoint rule on (0, HESTON_UMAX]. ****/
+
+#define HESTON_NODES 64
+#define HESTON_UMAX 64.0
+
+/* Re[exp(-iu log K) phi_j(u)/(iu)] for j = 1 (P1) or j = 2 (P2) */
+static inline Type HestonIntegrand(int j, Type u, const Type *p,
+				   Type S0, Type K, Type r, Type T)
+{
+  typedef std::complex<Type> Complex;
+  const Complex i(0, 1);
+  Type kappa = p[0], theta = p[1], sigma = p[2], rho = p[3], v0 = p[4];
+
+  Type uj = (j == 1) ? 0.5 : -0.5;
+  Type bj = (j == 1) ? kappa - rho*sigma : kappa;
+
+  Complex rsiu = rho*sigma*i*u;
+  Complex d = sqrt((rsiu - bj)*(rsiu - bj)
+		   - sigma*sigma*(2.0*uj*i*u - u*u));
+  Complex g = (bj - rsiu - d)/(bj - rsiu + d);
+  Complex edT = exp(-d*T);
+  Complex C = r*i*u*T + kappa*theta/(sigma*sigma)
+    *((bj - rsiu - d)*T - 2.0*log((1.0 - g*edT)/(1.0 - g)));
+  Complex D = (bj - rsiu - d)/(sigma*sigma)*(1.0 - edT)/(1.0 - g*edT);
+  Complex phi = exp(C + D*v0 + i*u*log(S0));
+
+  return std::real(exp(-i*u*log(K))*phi/(i*u));
+}
+
+static inline Type HestonKernel(const Type *p, Type S0, Type K, Type r,
+				Type T)
+{
+  const Type h = HESTON_UMAX/HESTON_NODES;
+  Type I1 = 0, I2 = 0;
+  for (int k = 0; k < HESTON_NODES; ++k)
+    {
+      Type u = (k + 0.5)*h;
+      I1 += HestonIntegrand(1, u, p, S0, K, r, T);
+      I2 += HestonIntegrand(2, u, p, S0, K, r, T);
+    }
+  Type P1 = 0.5 + I1*h/M_PI;
+  Type P2 = 0.5 + I2*h/M_PI;
+  return S0*P1 - K*exp(-r*T)*P2;
+}
+
+Type Heston(const std::vector<Type> &x, const std::vector<Type> &c)
+{
+  return HestonKernel(&x[0], Constant(c, 0, 100), Constant(c, 1, 100),
+		      Constant(c, 2, 0.03), Constant(c, 3, 1));
+}
+
+void HestonBatch(const Type *X, unsigned int n, int dim,
+		 const std::vector<Type> &c, Type *Y)
+{
+  Type S0 = Constant(c, 0, 100), K = Constant(c, 1, 100);
+  Type r = Constant(c, 2, 0.03), T = Constant(c, 3, 1);
+  for (unsigned int i = 0; i < n; ++i)
+    {
+      Y[i] = HestonKernel(X + (size_t)i*dim, S0, K, r, T);
+    }
+}
+
+/* Adds the reference models to ModelRegistry */
+void RegisterReferenceModels()
+{
+  ModelRegistry *registry = ModelRegistry::Instance();
+  registry->Register("ishigami", Ishigami, IshigamiBatch);
+  registry->Register("gfunction", GFunction, GFunctionBatch);
+  registry->Register("bratley", Bratley, BratleyBatch);
+  registry->Register("additive", Additive, AdditiveBatch);
+  registry->Register("vasicek", Vasicek, VasicekBatch);
+  registry->Register("heston", Heston, HestonBatch);
+}
+
+/* Closed index Var(E[f | x_S]) of the Bratley function.  With
+ * g_j = x_j for j in S and 1/2 otherwise, E[f | x_S] = sum_i (-1)^i Q_i
+ * where Q_i = prod_{j <= i} g_j, and for i <= k
+ * E[Q_i Q_k] = prod_{j <= i} E[g_j^2] * 2^-(k-i). */
+static Type BratleyClosedIndex(const std::set<int> &S, int dim)
+{
+  Type variance = 0;
+  for (int i = 1; i <= dim; ++i)
+    {
+      Type secondMoment = 1;  /* prod_{j <= i} E[g_j^2] */
+      for (int j = 1; j <= i; ++j)
+	{
+	  secondMoment *= S.count(j) ? 1.0/3 : 0.25;
+	}
+      for (int k = i; k <= dim; ++k)
+	{
+	  Type EQiQk = secondMoment*pow(0.5, k - i);
+	  Type covariance = EQiQk - pow(0.5, i)*pow(0.5, k);
+	  Type sign = ((i + k) % 2 == 0) ? 1 : -1;
+	  variance += (k == i ? 1 : 2)*sign*covariance;
+	}
+    }
+  return variance;
+}
+
+/* Computes the exact non-normalized closed (lower) and total indices of
+ * index set S (1 based) for the analytic reference models.  Returns
+ * false for models without analytic indices.
+ */
+bool AnalyticIndices(const std::string &name, const std::set<int> &S,
+		     int dim, const std::vector<Type> &constants,
+		     Type &lowerIndex, Type &totalIndex)
+{
+  std::set<int> complement;
+  for (int j = 1; j <= dim; ++j)
+    {
+      if (!S.count(j))
+	{
+	  complement.insert(j);
+	}
+    }
+
+  if (name == "ishigami")
+    {
+      Type a = Constant(constants, 0, 7), b = Constant(constants, 1, 0.1);
+      Type pi4 = pow(M_PI, 4.0), pi8 = pi4*pi4;
+
+      /* the only non-zero ANOVA terms */
+      Type V1 = 0.5*pow(1 + b*pi4/5, 2.0);
+      Type V2 = a*a/8;
+      Type V13 = 8*b*b*pi8/225;
+
+      bool has1 = S.count(1), has2 = S.count(2), has3 = S.count(3);
+      lowerIndex = (has1 ? V1 : 0) + (has2 ? V2 : 0)
+	+ (has1 && has3 ? V13 : 0);
+      totalIndex = (has1 ? V1 : 0) + (has2 ? V2 : 0)
+	+ (has1 || has3 ? V13 : 0);
+      return true;
+    }
+
+  if (name == "gfunction")
+    {
+      /* closed index of T is prod_{i in T} (1 + V_i) - 1 */
+      Type closedS = 1, closedC = 1;
+      for (int j = 1; j <= dim; ++j)
+	{
+	  Type Vj = 1/(3*pow(1 + GFunctionA(constants, j-1), 2.0));
+	  if (S.count(j))
+	    {
+	      closedS *= 1 + Vj;
+	    }
+	  else
+	    {
+	      closedC *= 1 + Vj;
+	    }
+	}
+      lowerIndex = closedS - 1;
+      totalIndex = closedS*closedC - closedC;
+      return true;
+    }
+
+  if (name == "bratley")
+    {
+      std::set<int> all(S);
+      all.insert(complement.begin(), complement.end());
+      lowerIndex = BratleyClosedIndex(S, dim);
+      totalIndex = BratleyClosedIndex(all, dim)
+	- BratleyClosedIndex(complement, dim);
+      return true;
+    }
+
+  if (name == "additive")
+    {
+      lowerIndex = 0;
+      for (auto j : S)
+	{
+	  lowerIndex += 1/(12.0*j*j);
+	}
+      totalIndex = lowerIndex;
+      return true;
+    }
+
+  return false;
+}
@@ -0,0 +1,54 @@
+/* Reference models for benchmarking the Sobol' index computations.
+ * Each model comes in a scalar form with the usual model signature and
+ * a batched form (see BatchModelFunction).  For the analytic test
+ * functions, AnalyticIndices() gives the exact non-normalized indices
+ * that SobolIndices estimates: the closed (lower) index D_S and the
+ * total index D_S^T of an index set S.
+ *
+ *   name       dim  inputs                    constants (defaults)
+ *   ishigami     3  Unif(-pi,pi)              a, b (7, 0.1)
+ *   gfunction    8  Unif(0,1)                 a_1..a_dim (0,1,4.5,9,99,..)
+ *   bratley     10  Unif(0,1)                 none
+ *   additive   100  Unif(0,1)                 none, f = sum x_i/i
+ *   vasicek      3  N on log a, log b, log s  r0, T (0.03, 5)
+ *   heston       5  N on kappa, theta, sigma, S0, K, r, T
+ *                   rho, v0                   (100, 100, 0.03, 1)
+ *
+ * Vasicek returns the zero-coupon bond price and Heston the European
+ * call price; neither has analytic Sobol' indices.
+ */
+
+#ifndef REFERENCEMODELS_H
+#define REFERENCEMODELS_H
+
+#include <set>
+#include <string>
+#include <vector>
+#include "ModelRegistry.h"
+
+typedef double Type;
+
+Type Ishigami(const std::vector<Type> &x, const std::vector<Type> &c);
+void IshigamiBatch(const Type *X, unsigned int n, int dim,
+		   const std::vector<Type> &c, Type *Y);
+Type GFunction(const std::vector<Type> &x, const std::vector<Type> &c);
+void GFunctionBatch(const Type *X, unsigned int n, int dim,
+		    const std::vector<Type> &c, Type *Y);
+Type Bratley(const std::vector<Type> &x, const std::vector<Type> &c);
+void BratleyBatch(const Type *X, unsigned int n, int dim,
+		  const std::vector<Type> &c, Type *Y);
+Type Additive(const std::vector<Type> &x, const std::vector<Type> &c);
+void AdditiveBatch(const Type *X, unsigned int n, int dim,
+		   const std::vector<Type> &c, Type *Y);
+Type Vasicek(const std::vector<Type> &x, const std::vector<Type> &c);
+void VasicekBatch(const Type *X, unsigned int n, int dim,
+		  const std::vector<Type> &c, Type *Y);
+Type Heston(const std::vector<Type> &x, const std::vector<Type> &c);
+void HestonBatch(const Type *X, unsigned int n, int dim,
+		 const std::vector<Type> &c, Type *Y);
+
+void RegisterReferenceModels();
+bool AnalyticIndices(const std::string &name, const std::set<int> &S,
+		     int dim, const std::vector<Type> &constants,
+		     Type &lowerIndex, Type &totalIndex);
+#endif
@@ -0,0 +1,206 @@
+#include "RngStream.h"
+#include <atomic>
+#include <iostream>
+
+/* log2 of the block length and of the stream spacing, as rnglib */
+#define RNGSTREAM_W 30
+#define RNGSTREAM_VW 50
+
+/* Ctor
+ * Input:
+ *   ig1_, ig2_ = seed of the stream, 1 <= ig1_ < m1, 1 <= ig2_ < m2;
+ *     defaulted to rnglib's initial seed
+ */
+RngStream::RngStream(int ig1_, int ig2_)
+{
+  if (ig1_ < 1 || ig1_ >= m1 || ig2_ < 1 || ig2_ >= m2)
+    {
+      std::cout << "RngStream: seed out of bounds, using default\n";
+      ig1_ = 1234567890;
+      ig2_ = 123456789;
+    }
+  ig1 = ig1_;
+  ig2 = ig2_;
+  antithetic = false;
+  InitGenerator(0);
+}
+
+/* Returns stream g of the family seeded by (ig1_, ig2_), i.e. the
+ * stream starting 2^50 g values after (ig1_, ig2_) */
+RngStream RngStream::Stream(unsigned long long g, int ig1_, int ig2_)
+{
+  RngStream stream(ig1_, ig2_);
+  int b1 = PowMod(a1, 1ULL << RNGSTREAM_VW, m1);
+  int b2 = PowMod(a2, 1ULL << RNGSTREAM_VW, m2);
+  stream.ig1 = (long long)PowMod(b1, g, m1)*stream.ig1 % m1;
+  stream.ig2 = (long long)PowMod(b2, g, m2)*stream.ig2 % m2;
+  stream.InitGenerator(0);
+  return stream;
+}
+
+/* Returns a^e mod m by repeated squaring */
+int RngStream::PowMod(int a, unsigned long long e, int m)
+{
+  long long result = 1, base = a % m;
+  while (e)
+    {
+      if (e & 1)
+	{
+	  result = result*base % m;
+	}
+      base = base*base % m;
+      e >>= 1;
+    }
+  return (int)result;
+}
+
+/* Resets the current state, as rnglib's init_generator():
+ *   t = 0: to the start of the stream,
+ *   t = 1: to the start of the current block,
+ *   t = 2: to the start of the next block.
+ */
+void RngStream::InitGenerator(int t)
+{
+  if (t == 0)
+    {
+      lg1 = ig1;
+      lg2 = ig2;
+    }
+  else if (t == 2)
+    {
+      JumpBlocks(1);
+      return;
+    }
+  else if (t != 1)
+    {
+      std::cout << "RngStream::InitGenerator: t out of bounds\n";
+      return;
+    }
+  cg1 = lg1;
+  cg2 = lg2;
+}
+
+/* Advances the current state by 2^k values, as rnglib's
+ * advance_state() */
+void RngStream::AdvanceState(int k)
+{
+  int b1 = a1, b2 = a2;
+  for (int i = 1; i <= k; ++i)
+    {
+      b1 = (long long)b1*b1 % m1;
+      b2 = (long long)b2*b2 % m2;
+    }
+  cg1 = (long long)b1*cg1 % m1;
+  cg2 = (long long)b2*cg2 % m2;
+}
+
+/* Advances the current state by n values */
+void RngStream::Advance(unsigned long long n)
+{
+  cg1 = (long long)PowMod(a1, n, m1)*cg1 % m1;
+  cg2 = (long long)PowMod(a2, n, m2)*cg2 % m2;
+}
+
+/* Moves the block seed n blocks on and resets the current state to
+ * it; n = 1 is InitGenerator(2) */
+void RngStream::JumpBlocks(unsigned long long n)
+{
+  int b1 = PowMod(PowMod(a1, 1ULL << RNGSTREAM_W, m1), n, m1);
+  int b2 = PowMod(PowMod(a2, 1ULL << RNGSTREAM_W, m2), n, m2);
+  lg1 = (long long)b1*lg1 % m1;
+  lg2 = (long long)b2*lg2 % m2;
+  cg1 = lg1;
+  cg2 = lg2;
+}
+
+/* Sets the current state and makes it the start of the stream, as
+ * rnglib's set_seed() */
+void RngStream::SetSeed(int cg1_, int cg2_)
+{
+  if (cg1_ < 1 || cg1_ >= m1 || cg2_ < 1 || cg2_ >= m2)
+    {
+      std::cout << "RngStream::SetSeed: seed out of bounds\n";
+      return;
+    }
+  ig1 = cg1_;
+  ig2 = cg2_;
+  InitGenerator(0);
+}
+
+/* Returns a uniform integer in [1, 2147483562], as rnglib's i4_uni() */
+int RngStream::i4_uni()
+{
+  int k = cg1/53668;
+  cg1 = a1*(cg1 - k*53668) - k*12211;
+  if (cg1 < 0)
+    {
+      cg1 += m1;
+    }
+
+  k = cg2/52774;
+  cg2 = a2*(cg2 - k*52774) - k*3791;
+  if (cg2 < 0)
+    {
+      cg2 += m2;
+    }
+
+  int z = cg1 - cg2;
+  if (z < 1)
+    {
+      z += m1 - 1;
+    }
+  return antithetic ? m1 - z : z;
+}
+
+/* Fills x with the next n values of r8_uni_01(), keeping the state in
+ * registers for the whole array */
+void RngStream::Fill(size_t n, double *x)
+{
+  int c1 = cg1, c2 = cg2;
+  for (size_t i = 0; i < n; ++i)
+    {
+      int k = c1/53668;
+      c1 = a1*(c1 - k*53668) - k*12211;
+      if (c1 < 0)
+	{
+	  c1 += m1;
+	}
+
+      k = c2/52774;
+      c2 = a2*(c2 - k*52774) - k*3791;
+      if (c2 < 0)
+	{
+	  c2 += m2;
+	}
+
+      int z = c1 - c2;
+      if (z < 1)
+	{
+	  z += m1 - 1;
+	}
+      x[i] = (double)(antithetic ? m1 - z : z)*4.656613057E-10;
+    }
+  cg1 = c1;
+  cg2 = c2;
+}
+
+static std::atomic<unsigned long long> nextLocalStream(0);
+
+static RngStream& LocalStorage()
+{
+  thread_local RngStream stream = RngStream::Stream(nextLocalStream++);
+  return stream;
+}
+
+/* Returns the calling thread's default stream */
+RngStream& RngStream::Local()
+{
+  return LocalStorage();
+}
+
+/* Replaces the calling thread's default stream, e.g. by Stream(i) in
+ * worker i for results that do not depend on thread start order */
+void RngStream::SetLocal(const RngStream &stream)
+{
+  LocalStorage() = stream;
+}
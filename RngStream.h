@@ -0,0 +1,61 @@
+/* Class RngStream is L'Ecuyer's combined multiplicative generator of
+ * rnglib.cpp as an object.  rnglib keeps the state of its 32
+ * generators in static arrays, so its samplers are process-global; an
+ * RngStream carries its own current state, stream seed and block
+ * (substream) seed, and any number of them can be used at once.
+ *
+ * Streams follow rnglib's layout: stream g starts 2^50 g values
+ * after stream 0, and each stream is split into blocks of 2^30 values.
+ * With the default seed, Stream(g) gives the same numbers as rnglib's
+ * generator g after initialize().  All jumps are by modular powers, so
+ * they cost O(log n) multiplications.
+ *
+ * Local() is a thread-local default stream; threads get distinct
+ * streams in the order they first call it, or the stream given to
+ * SetLocal().  With thread_streams_set(true) the rnglib uniforms, and
+ * through them every pdflib sampler (r8_uniform_01_sample then takes
+ * OPTION 0), draw from Local(), so they can be called from parallel
+ * workers without locks.
+ */
+
+#ifndef RNGSTREAM_H
+#define RNGSTREAM_H
+
+#include <cstddef>
+
+class RngStream
+{
+ private:
+  int cg1, cg2;  /* current state */
+  int ig1, ig2;  /* seed of the stream */
+  int lg1, lg2;  /* seed of the current block */
+  bool antithetic;  /* if true, returns m1 - z instead of z */
+
+ public:
+  static const int m1 = 2147483563;
+  static const int m2 = 2147483399;
+  static const int a1 = 40014;
+  static const int a2 = 40692;
+
+  RngStream(int ig1_ = 1234567890, int ig2_ = 123456789);
+  static RngStream Stream(unsigned long long g, int ig1_ = 1234567890,
+			  int ig2_ = 123456789);
+  static int PowMod(int a, unsigned long long e, int m);
+
+  void InitGenerator(int t);
+  void AdvanceState(int k);
+  void Advance(unsigned long long n);
+  void JumpBlocks(unsigned long long n);
+  void SetSeed(int cg1_, int cg2_);
+  void GetState(int &cg1_, int &cg2_) const {cg1_ = cg1; cg2_ = cg2;}
+  void SetAntithetic(bool antithetic_) {antithetic = antithetic_;}
+
+  int i4_uni();
+  float r4_uni_01() {return (float)i4_uni()*4.656613057E-10;}
+  double r8_uni_01() {return (double)i4_uni()*4.656613057E-10;}
+  void Fill(size_t n, double *x);
+
+  static RngStream& Local();
+  static void SetLocal(const RngStream &stream);
+};
+#endif
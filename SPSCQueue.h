@@ -0,0 +1,106 @@
+/* Class SPSCQueue is a bounded lock-free queue between exactly one
+ * producer thread and one consumer thread, a ring of a power-of-two
+ * number of slots.  Only the producer writes tail and only the consumer
+ * writes head, so a push or pop is one acquire load and one release
+ * store, and the two indices sit on separate cache lines to keep the
+ * threads from invalidating each other's line on every operation.
+ *
+ * Push() and Pop() wait by yielding the processor, which suits the
+ * stages of a pipeline that are expected to be busy most of the time.
+ */
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#define SPSC_CACHE_LINE 64
+
+template <class T>
+class SPSCQueue
+{
+ private:
+  std::vector<T> slots;
+  size_t mask;  /* slots.size() - 1 */
+  char pad0[SPSC_CACHE_LINE];
+  std::atomic<size_t> head;  /* next slot to pop */
+  char pad1[SPSC_CACHE_LINE];
+  std::atomic<size_t> tail;  /* next slot to push */
+  char pad2[SPSC_CACHE_LINE];
+
+ public:
+  /* Ctor
+   * Input:
+   *   capacity = least number of items the queue must hold, rounded up
+   *     to a power of two
+   */
+  SPSCQueue(size_t capacity = 1) : head(0), tail(0)
+  {
+    Resize(capacity);
+  }
+  SPSCQueue(const SPSCQueue&) = delete;
+  SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+  /* empties the queue and makes it hold at least capacity items; only
+   * while no other thread uses it */
+  void Resize(size_t capacity)
+  {
+    size_t size = 1;
+    while (size < capacity)
+      {
+	size <<= 1;
+      }
+    slots.assign(size, T());
+    mask = size - 1;
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+  }
+
+  /* producer: returns false if the queue is full */
+  bool TryPush(const T &item)
+  {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) > mask)
+      {
+	return false;
+      }
+    slots[t & mask] = item;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /* consumer: returns false if the queue is empty */
+  bool TryPop(T &item)
+  {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+      {
+	return false;
+      }
+    item = slots[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  void Push(const T &item)
+  {
+    while (!TryPush(item))
+      {
+	std::this_thread::yield();
+      }
+  }
+
+  T Pop()
+  {
+    T item;
+    while (!TryPop(item))
+      {
+	std::this_thread::yield();
+      }
+    return item;
+  }
+};
+#endif
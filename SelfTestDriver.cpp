@@ -0,0 +1,181 @@
+#include "SobolIndices.h"
+#include "pdflib.h"
+#include "rnglib.h"
+#include "RngStream.h"
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/* Self-checks of behaviour that the other drivers do not show in their
+ * output.  Each check prints "ok <name>" or "FAILED <name>: <reason>";
+ * the exit status is the number of failed checks.
+ *
+ * Usage: ./a.out
+ */
+
+#define SELFTEST_DRAWS 1000  /* draws per sampler and thread */
+
+/* Draws SELFTEST_DRAWS values from each of a few pdflib samplers, scalar
+ * and bulk, on stream g of the calling thread */
+static std::vector<double> DrawPdflib(unsigned long long g)
+{
+  RngStream::SetLocal(RngStream::Stream(g));
+
+  std::vector<double> draws;
+  for (int i = 0; i < SELFTEST_DRAWS; ++i)
+    {
+      draws.push_back(r8_normal_01_sample());
+      draws.push_back(r8_gamma_01_sample(2.5));
+      draws.push_back(r8_beta_sample(2.0, 3.0));
+    }
+
+  std::vector<double> x(SELFTEST_DRAWS);
+  r8_normal_01_fill(SELFTEST_DRAWS, &x[0]);
+  draws.insert(draws.end(), x.begin(), x.end());
+  r8_gamma_01_fill(2.5, SELFTEST_DRAWS, &x[0]);
+  draws.insert(draws.end(), x.begin(), x.end());
+  return draws;
+}
+
+/* Runs DrawPdflib() on streams 0 and 1 in two threads at once */
+static void DrawPdflibThreads(std::vector<double> draws[2])
+{
+  std::thread threads[2];
+  for (int t = 0; t < 2; ++t)
+    {
+      threads[t] = std::thread([t, draws]()
+			       {
+				 draws[t] = DrawPdflib(t);
+			       });
+    }
+  for (int t = 0; t < 2; ++t)
+    {
+      threads[t].join();
+    }
+}
+
+/* With thread_streams_set(true) the pdflib samplers must draw from the
+ * calling thread's RngStream only: two threads get different numbers,
+ * the same ones in every run and on a single thread, whatever srand()
+ * was given, and the state of rand() is left alone. */
+static bool CheckThreadStreams(std::string &reason)
+{
+  thread_streams_set(true);
+
+  std::vector<double> first[2], second[2];
+  srand(1);
+  DrawPdflibThreads(first);
+  int next = rand();
+  srand(1);
+  bool randUntouched = (rand() == next);
+
+  srand(2);
+  DrawPdflibThreads(second);
+  std::vector<double> single = DrawPdflib(1);
+  thread_streams_set(false);
+
+  if (!randUntouched)
+    {
+      reason = "the samplers drew from rand()";
+      return false;
+    }
+  if (first[0] == first[1])
+    {
+      reason = "both threads drew the same numbers";
+      return false;
+    }
+  for (int t = 0; t < 2; ++t)
+    {
+      if (first[t] != second[t])
+	{
+	  reason = "a run after another srand() drew different numbers";
+	  return false;
+	}
+    }
+  if (single != first[1])
+    {
+      reason = "stream 1 differs between a worker and the main thread";
+      return false;
+    }
+  return true;
+}
+
+/* y = sum_j (j+1) x_j, for the SobolIndices checks */
+static Type WeightedSum(const std::vector<Type> &x,
+			const std::vector<Type> &constants)
+{
+  Type y = 0;
+  for (size_t j = 0; j < x.size(); ++j)
+    {
+      y += (j + 1)*x[j];
+    }
+  return y;
+}
+
+/* ExtendSensitivityIndices() with fewer runs than already held must
+ * leave the estimate and N alone; a larger target must give the
+ * estimate of a single computation with that many runs (Philox
+ * sampler, so both see the same points) */
+static bool CheckExtendBelowHeld(std::string &reason)
+{
+  std::vector<std::vector<Type> > distroParams = {{0, 1}, {0, 4}, {0, 9}};
+  std::set<int> indices = {1};
+
+  SobolIndices sobol(WeightedSum, std::vector<Type>(), indices,
+		     distroParams, 3, 2000, 1.0,
+		     SobolIndices::PHILOX_SAMPLER, 7);
+  sobol.ComputeSensitivityIndices();
+  Type lower = sobol.GetLowerIndex(), total = sobol.GetTotalIndex();
+
+  sobol.ExtendSensitivityIndices(1000);
+  if (sobol.GetN() != 2000 || sobol.GetLowerIndex() != lower
+      || sobol.GetTotalIndex() != total)
+    {
+      reason = "a target below the runs held changed the estimate or N";
+      return false;
+    }
+
+  sobol.ExtendSensitivityIndices(3000);
+  SobolIndices direct(WeightedSum, std::vector<Type>(), indices,
+		      distroParams, 3, 3000, 1.0,
+		      SobolIndices::PHILOX_SAMPLER, 7);
+  direct.ComputeSensitivityIndices();
+  if (sobol.GetN() != 3000
+      || sobol.GetLowerIndex() != direct.GetLowerIndex()
+      || sobol.GetTotalIndex() != direct.GetTotalIndex())
+    {
+      reason = "extending to 3000 runs differs from computing 3000 runs";
+      return false;
+    }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  struct
+  {
+    const char *name;
+    bool (*run)(std::string &reason);
+  } checks[] =
+      {
+	{"thread_streams", CheckThreadStreams},
+	{"extend_below_held", CheckExtendBelowHeld},
+      };
+
+  int failed = 0;
+  for (auto& check : checks)
+    {
+      std::string reason;
+      if (check.run(reason))
+	{
+	  std::cout << "ok " << check.name << "\n";
+	}
+      else
+	{
+	  std::cout << "FAILED " << check.name << ": " << reason << "\n";
+	  ++failed;
+	}
+    }
+  return failed;
+}
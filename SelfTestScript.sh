@@ -0,0 +1,5 @@
+#!/bin/bash
+
+g++ -O2 -std=c++0x -pthread SelfTestDriver.cpp SobolIndices.cpp EvaluationCache.cpp Philox.cpp Instrumentation.cpp QMCDesign.cpp CorrelatedNormal.cpp ThreadPool.cpp WorkStealingPool.cpp Halton.cpp MT64.cpp InverseTransformation.cpp InverseCDFTable.cpp MersenneTwister.cpp DSFMT.cpp pdflib.cpp rnglib.cpp RngStream.cpp
+
+# ./a.out
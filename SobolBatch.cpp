@@ -0,0 +1,479 @@
+#include "SobolBatch.h"
+#include "ParseUtils.h"
+#include <map>
+#include <algorithm>
+#include <limits>
+#include <cerrno>
+
+/* Ctor
+ * Input:
+ *
+ * model_ = model to compute indices of, see SobolIndices
+ * constants_ = vector of constants for model
+ */
+SobolBatch::SobolBatch(ModelFunction model_,
+		       const std::vector<Type> &constants_)
+{
+  model = model_;
+  batchModel = NULL;
+  constants = constants_;
+  dim = 0;
+  modelEvaluations = 0;
+  cache = NULL;
+  externalModel = NULL;
+  numThreads = 1;
+  pool = NULL;
+}
+
+SobolBatch::~SobolBatch()
+{
+  delete pool;
+}
+
+void SobolBatch::SetNumThreads(unsigned int numThreads_)
+{
+  delete pool;
+  pool = NULL;
+  numThreads = numThreads_;
+}
+
+/* Reads the jobs in filename.  Returns false, after printing the
+ * offending line, if a job cannot be parsed or its number of
+ * parameters differs from the previous jobs'. */
+bool SobolBatch::ReadJobFile(const std::string &filename)
+{
+  std::ifstream jobFile(filename.c_str());
+  if (!jobFile.is_open())
+    {
+      std::cout << "unable to open job file " << filename << "\n";
+      return false;
+    }
+
+  std::string line;
+  unsigned int lineNumber = 0;
+  while (std::getline(jobFile, line))
+    {
+      ++lineNumber;
+      size_t first = line.find_first_not_of(" \t\r");
+      if (first == std::string::npos || line[first] == '#')
+	{
+	  continue;
+	}
+
+      SobolBatchJob job;
+      SobolBatchGroup distros;
+      if (!ParseJob(line, job, distros)
+	  || !AddJob(job.indices, distros.families, distros.distroParams,
+		     job.N))
+	{
+	  std::cout << filename << ":" << lineNumber
+		    << ": bad job: " << line << "\n";
+	  return false;
+	}
+      jobs.back().distroText = job.distroText;
+    }
+
+  return true;
+}
+
+/* Adds one job.  families holds the InverseTransformation::*_PARAM
+ * distribution of each parameter and distroParams its parameters.
+ * Returns false if the number of parameters differs from the previous
+ * jobs', a distribution is invalid or an index is out of range. */
+bool SobolBatch::
+AddJob(const std::set<int> &indices, const std::vector<int> &families,
+       const std::vector<std::vector<Type> > &distroParams,
+       unsigned int N)
+{
+  int jobDim = distroParams.size();
+  if (jobDim == 0 || 2*jobDim > HALTON_DIM || (dim && jobDim != dim)
+      || families.size() != distroParams.size() || N == 0
+      || (!indices.empty() && (*indices.begin() < 1
+			       || *indices.rbegin() > jobDim)))
+    {
+      return false;
+    }
+  for (int j = 0; j < jobDim; ++j)
+    {
+      if (!InverseTransformation::ValidParams(families[j], distroParams[j]))
+	{
+	  return false;
+	}
+    }
+  dim = jobDim;
+
+  SobolBatchJob job;
+  job.indices = indices;
+  job.N = N;
+
+  /* find the group of jobs with the same distributions */
+  job.group = groups.size();
+  for (size_t g = 0; g < groups.size(); ++g)
+    {
+      if (groups[g].families == families
+	  && groups[g].distroParams == distroParams)
+	{
+	  job.group = g;
+	  break;
+	}
+    }
+  if (job.group == groups.size())
+    {
+      SobolBatchGroup group;
+      group.families = families;
+      group.distroParams = distroParams;
+      group.maxN = 0;
+      groups.push_back(group);
+    }
+  groups[job.group].maxN = std::max(groups[job.group].maxN, N);
+
+  jobs.push_back(job);
+  return true;
+}
+
+/* Fills job and distros from one job line */
+bool SobolBatch::
+ParseJob(const std::string &line, SobolBatchJob &job,
+	 SobolBatchGroup &distros)
+{
+  std::map<std::string, std::string> fields;
+  for (const auto& i : Split(line, ' '))
+    {
+      size_t equals = i.find('=');
+      if (equals == std::string::npos)
+	{
+	  return false;
+	}
+      fields[i.substr(0, equals)] = i.substr(equals + 1);
+    }
+  if (!fields.count("indices") || !fields.count("params")
+      || !fields.count("N"))
+    {
+      return false;
+    }
+
+  job.distroText = fields["params"];
+  for (const auto& i : Split(fields["params"], ';'))
+    {
+      int family;
+      std::vector<Type> params;
+      if (!ParseDistribution(i, family, params))
+	{
+	  return false;
+	}
+      distros.families.push_back(family);
+      distros.distroParams.push_back(params);
+    }
+
+  if (!ParseIndexSet(fields["indices"], distros.distroParams.size(),
+		     job.indices))
+    {
+      return false;
+    }
+
+  /* strtoul() takes a sign and wraps negative values, so only digits */
+  const std::string &text = fields["N"];
+  if (text.empty() || text[0] < '0' || text[0] > '9')
+    {
+      return false;
+    }
+  char *end;
+  errno = 0;
+  unsigned long N = strtoul(text.c_str(), &end, 10);
+  if (*end != '\0' || errno == ERANGE || N == 0
+      || N > std::numeric_limits<unsigned int>::max())
+    {
+      return false;
+    }
+  job.N = N;
+  return true;
+}
+
+/* Runs every job.  One design of max(N) points is generated, then each
+ * group of jobs with the same distributions is run on it. */
+void SobolBatch::Run()
+{
+  if (jobs.empty())
+    {
+      return;
+    }
+
+  unsigned int maxN = 0;
+  for (const auto& i : groups)
+    {
+      maxN = std::max(maxN, i.maxN);
+    }
+
+  auto generate = [this](QMCDesign &design)
+    {
+      /* init RNG: length of Halton vector, random start, random
+       * permute */
+      halton RNG;
+      RNG.init(2*dim,true,true);
+      design.Generate(&RNG);
+    };
+
+  std::shared_ptr<const QMCDesign> design;
+  if (!designDirectory.empty())
+    {
+      design = DesignStore(designDirectory).Get("halton", maxN, 2*dim,
+						false, generate);
+    }
+  else
+    {
+      QMCDesign *generated = new QMCDesign(maxN, 2*dim);
+      generate(*generated);
+      design.reset(generated);
+    }
+
+  InverseTransformation invTrans;
+  modelEvaluations = 0;
+  for (size_t g = 0; g < groups.size(); ++g)
+    {
+      RunGroup(g, *design, &invTrans);
+    }
+}
+
+/* Runs the jobs of group g.  x1, x2, f and f2 are computed once for the
+ * group; model(arg1) and model(arg2) once per distinct index set. */
+void SobolBatch::
+RunGroup(size_t g, const QMCDesign &design,
+	 InverseTransformation *invTrans)
+{
+  const SobolBatchGroup &group = groups[g];
+  unsigned int rows = group.maxN;
+
+  /* inverse CDF tables of the Gamma and Beta parameters */
+  std::vector<InverseCDFTable> tables(dim);
+  for (int j = 0; j < dim; ++j)
+    {
+      if (InverseTransformation::IsIterative(group.families[j]))
+	{
+	  invTrans->Tabulate(group.families[j], group.distroParams[j],
+			     tables[j]);
+	}
+    }
+
+  /* transformed samples, row-major rows x dim */
+  std::vector<Type> X1((size_t)rows*dim), X2((size_t)rows*dim);
+  for (unsigned int r = 0; r < rows; ++r)
+    {
+      const Type *point = design.Row(r);
+      for (int j = 0; j < dim; ++j)
+	{
+	  if (tables[j].IsBuilt())
+	    {
+	      X1[(size_t)r*dim + j] = tables[j].Evaluate(point[j]);
+	      X2[(size_t)r*dim + j] = tables[j].Evaluate(point[j+dim]);
+	      continue;
+	    }
+	  X1[(size_t)r*dim + j]
+	    = invTrans->Transform(point[j], group.families[j],
+				  group.distroParams[j]);
+	  X2[(size_t)r*dim + j]
+	    = invTrans->Transform(point[j+dim], group.families[j],
+				  group.distroParams[j]);
+	}
+    }
+
+  /* f and f2 do not depend on the index set */
+  std::vector<Type> f(rows), f2(rows);
+  Evaluate(&X1[0], rows, &f[0]);
+  Evaluate(&X2[0], rows, &f2[0]);
+
+  /* model arguments and outputs for one block of runs */
+  const unsigned int blockSize = 256;
+  std::vector<Type> Arg1((size_t)blockSize*dim), Arg2((size_t)blockSize*dim);
+  std::vector<Type> model1(blockSize), model2(blockSize);
+
+  /* jobs of this group by index set, sorted by N */
+  std::map<std::set<int>, std::vector<size_t> > setJobs;
+  for (size_t i = 0; i < jobs.size(); ++i)
+    {
+      if (jobs[i].group == g)
+	{
+	  setJobs[jobs[i].indices].push_back(i);
+	}
+    }
+
+  for (auto& i : setJobs)
+    {
+      const std::set<int> &indices = i.first;
+      std::vector<size_t> &list = i.second;
+      std::sort(list.begin(), list.end(),
+		[this](size_t a, size_t b) {return jobs[a].N < jobs[b].N;});
+      unsigned int setRows = jobs[list.back()].N;
+
+      SobolAccumulator acc;
+      size_t next = 0;  /* next job in list to read off */
+      for (unsigned int begin = 0; begin < setRows; begin += blockSize)
+	{
+	  unsigned int n = std::min(blockSize, setRows - begin);
+
+	  /* same assignment as SobolIndices::AssignModelArguments */
+	  for (unsigned int b = 0; b < n; ++b)
+	    {
+	      size_t r = (size_t)(begin + b)*dim;
+	      for (int j = 0; j < dim; ++j)
+		{
+		  Type x1j = X1[r + j], x2j = X2[r + j];
+		  if (indices.count(j+1))
+		    {
+		      Arg1[(size_t)b*dim + j] = x1j;
+		      Arg2[(size_t)b*dim + j] = x2j;
+		    }
+		  else
+		    {
+		      Arg1[(size_t)b*dim + j] = x2j;
+		      Arg2[(size_t)b*dim + j] = x1j;
+		    }
+		}
+	    }
+
+	  Evaluate(&Arg1[0], n, &model1[0]);
+	  Evaluate(&Arg2[0], n, &model2[0]);
+
+	  for (unsigned int b = 0; b < n; ++b)
+	    {
+	      unsigned int r = begin + b;
+	      acc.Add(f[r], f2[r], model1[b], model2[b]);
+
+	      while (next < list.size() && jobs[list[next]].N == r+1)
+		{
+		  jobs[list[next]].result = acc;
+		  ++next;
+		}
+	    }
+	}
+    }
+}
+
+/* Evaluates the model at the n points stored row-major in X, through
+ * the cache and the batched form if they were set */
+void SobolBatch::Evaluate(const Type *X, unsigned int n, Type *Y)
+{
+  /* with a cache, only the points it misses go to the model, packed
+   * into one smaller block */
+  if (cache)
+    {
+      std::vector<unsigned int> missed;
+      for (unsigned int i = 0; i < n; ++i)
+	{
+	  if (!cache->Lookup(X + (size_t)i*dim, dim, constants, Y[i]))
+	    {
+	      missed.push_back(i);
+	    }
+	}
+      if (missed.empty())
+	{
+	  return;
+	}
+
+      std::vector<Type> missedX(missed.size()*dim), missedY(missed.size());
+      for (size_t k = 0; k < missed.size(); ++k)
+	{
+	  std::copy(X + (size_t)missed[k]*dim, X + (size_t)(missed[k]+1)*dim,
+		    &missedX[k*dim]);
+	}
+      EvaluateModel(&missedX[0], missed.size(), &missedY[0]);
+      for (size_t k = 0; k < missed.size(); ++k)
+	{
+	  Y[missed[k]] = missedY[k];
+	  cache->Insert(&missedX[k*dim], dim, constants, missedY[k]);
+	}
+      return;
+    }
+
+  EvaluateModel(X, n, Y);
+}
+
+/* Evaluates the model at the n points X, without the cache, by the
+ * external workers or else in this process, in numThreads contiguous
+ * slices of X when there are enough points */
+void SobolBatch::EvaluateModel(const Type *X, unsigned int n, Type *Y)
+{
+  modelEvaluations += n;
+
+  if (externalModel)
+    {
+      externalModel->Evaluate(X, n, dim, constants, Y);
+      return;
+    }
+
+  if (numThreads != 1 && n >= SOBOLBATCH_MIN_SPLIT)
+    {
+      if (!pool)
+	{
+	  pool = new ThreadPool(numThreads);
+	}
+      unsigned int parts = pool->GetNumThreads();
+      unsigned int slice = (n + parts - 1)/parts;
+      for (unsigned int first = 0; first < n; first += slice)
+	{
+	  unsigned int m = std::min(slice, n - first);
+	  pool->Enqueue([this, X, Y, first, m]()
+			{
+			  EvaluateRange(X + (size_t)first*dim, m, Y + first);
+			});
+	}
+      pool->Wait();
+      return;
+    }
+
+  EvaluateRange(X, n, Y);
+}
+
+/* Evaluates the model at the n points X by the batched form or the
+ * model function */
+void SobolBatch::EvaluateRange(const Type *X, unsigned int n, Type *Y)
+{
+  if (batchModel)
+    {
+      batchModel(X, n, dim, constants, Y);
+      return;
+    }
+
+  std::vector<Type> x(dim);
+  for (unsigned int i = 0; i < n; ++i)
+    {
+      x.assign(X + (size_t)i*dim, X + (size_t)(i+1)*dim);
+      Y[i] = model(x,constants);
+    }
+}
+
+/* Writes one row per job, in job file order.  Indices are
+ * non-normalized, as in SobolIndices. */
+bool SobolBatch::WriteResults(const std::string &filename)
+{
+  std::ofstream resultsFile(filename.c_str());
+  if (!resultsFile.is_open())
+    {
+      std::cout << "unable to open results file " << filename << "\n";
+      return false;
+    }
+
+  resultsFile.precision(12);
+  resultsFile << "# N indices lower total mean variance params\n";
+  for (const auto& i : jobs)
+    {
+      resultsFile << i.N << " " << FormatSet(i.indices) << " "
+		  << i.result.LowerIndex() << " "
+		  << i.result.TotalIndex() << " "
+		  << i.result.Mean() << " "
+		  << i.result.Variance() << " "
+		  << i.distroText << "\n";
+    }
+
+  return true;
+}
+
+/* Model evaluations the jobs would need if each were run separately */
+unsigned long long SobolBatch::GetSeparateRunEvaluations()
+{
+  unsigned long long total = 0;
+  for (const auto& i : jobs)
+    {
+      total += 4*(unsigned long long)i.N;
+    }
+  return total;
+}
@@ -0,0 +1,121 @@
+/* Class SobolBatch runs many Sobol' index computations for one model
+ * in a single pass.  Jobs are read from a job file, one per line:
+ *
+ *   indices=<i>,<j> params=<p1>;<p2>;... N=<runs>
+ *
+ * where each parameter is "<family>:<p1>,<p2>,...", e.g.
+ * "normal:<mean>,<variance>" (the "normal:" prefix may be omitted),
+ * "uniform:<a>,<b>" or "gamma:<shape>,<scale>"; see
+ * InverseTransformation for all families.  Every family is sampled by
+ * its inverse CDF, one design coordinate per parameter, so the QMC
+ * design keeps its structure.  Lines starting with # are comments.
+ *
+ * Setup is shared as much as the jobs allow:
+ *   - one QMC design of max(N) points is generated; a job with N runs
+ *     uses its first N points, exactly as a separate run would;
+ *   - jobs with the same parameter distributions share the transformed
+ *     samples x1, x2 and the model evaluations f = model(x1) and
+ *     f2 = model(x2), which do not depend on the index set;
+ *   - jobs that also have the same index set share model(arg1) and
+ *     model(arg2); smaller N are read off the running sums on the way.
+ * All results go into one table, one row per job.  With a design
+ * store the design is mapped from a file when an earlier run (or a
+ * concurrent shard) has already generated it.
+ */
+
+#ifndef SOBOLBATCH_H
+#define SOBOLBATCH_H
+
+#include <string>
+#include "SobolIndices.h"
+#include "ModelRegistry.h"
+#include "DesignStore.h"
+#include "EvaluationCache.h"
+#include "ExternalModelPool.h"
+#include "ThreadPool.h"
+
+/* smallest number of points split among threads by EvaluateModel */
+#define SOBOLBATCH_MIN_SPLIT 1024
+
+typedef double Type;
+
+/* one job of the batch and, after Run(), its result */
+struct SobolBatchJob
+{
+  std::set<int> indices;  /* index set to compute indices for */
+  std::string distroText;  /* params field as given in the job file */
+  unsigned int N;  /* number of MC runs */
+  size_t group;  /* jobs with equal distributions share a group */
+  SobolAccumulator result;  /* MC sums after N runs */
+};
+
+/* jobs sharing the same parameter distributions */
+struct SobolBatchGroup
+{
+  std::vector<int> families;  /* InverseTransformation::*_PARAM */
+  std::vector<std::vector<Type> > distroParams;
+  unsigned int maxN;
+};
+
+class SobolBatch
+{
+ private:
+  ModelFunction model;
+  BatchModelFunction batchModel;  /* used instead of model if set */
+  std::vector<Type> constants;
+  int dim;  /* number of model parameters, same for all jobs */
+  std::vector<SobolBatchJob> jobs;
+  std::vector<SobolBatchGroup> groups;
+  unsigned long long modelEvaluations;  /* model calls made by Run() */
+  std::string designDirectory;  /* DesignStore directory, "" if none */
+  EvaluationCache *cache;  /* model outputs on disk, NULL if not used */
+  ExternalModelPool *externalModel;  /* used instead of model if set */
+  unsigned int numThreads;  /* threads for model calls, 0 = all */
+  ThreadPool *pool;  /* created on first use if numThreads != 1 */
+
+  bool ParseJob(const std::string &line, SobolBatchJob &job,
+		SobolBatchGroup &distros);
+  void RunGroup(size_t g, const QMCDesign &design,
+		InverseTransformation *invTrans);
+  void Evaluate(const Type *X, unsigned int n, Type *Y);
+  void EvaluateModel(const Type *X, unsigned int n, Type *Y);
+  void EvaluateRange(const Type *X, unsigned int n, Type *Y);
+
+ public:
+  SobolBatch(ModelFunction model_,
+	     const std::vector<Type> &constants_);
+  SobolBatch(const SobolBatch&) = delete;
+  SobolBatch& operator=(const SobolBatch&) = delete;
+  ~SobolBatch();
+  void SetBatchModel(BatchModelFunction batchModel_)
+  {
+    batchModel = batchModel_;
+  }
+  bool ReadJobFile(const std::string &filename);
+  bool AddJob(const std::set<int> &indices,
+	      const std::vector<int> &families,
+	      const std::vector<std::vector<Type> > &distroParams,
+	      unsigned int N);
+  void SetDesignStore(const std::string &directory)
+  {
+    designDirectory = directory;
+  }
+  /* serves model calls from cache_, owned by the caller */
+  void SetEvaluationCache(EvaluationCache *cache_) {cache = cache_;}
+  /* evaluates the model with the worker processes of pool, owned by
+   * the caller */
+  void SetExternalModel(ExternalModelPool *pool) {externalModel = pool;}
+  /* splits the in-process model calls among numThreads_ threads (0 =
+   * one per hardware thread); only for models that may be called
+   * concurrently, see ModelRegistry::IsThreadSafe */
+  void SetNumThreads(unsigned int numThreads_);
+  void Run();
+  bool WriteResults(const std::string &filename);
+  size_t GetNumJobs() {return jobs.size();}
+  int GetDim() {return dim;}
+  /* model calls made by Run(), not counting cache hits */
+  unsigned long long GetModelEvaluations() {return modelEvaluations;}
+  unsigned long long GetSeparateRunEvaluations();
+  const SobolAccumulator& GetResult(size_t i) {return jobs[i].result;}
+};
+#endif
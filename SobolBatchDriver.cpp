@@ -0,0 +1,133 @@
+#include "SobolBatch.h"
+#include "ModelPlugin.h"
+#include <chrono>
+#include <sstream>
+
+/* Runs every job of a job file for one model and writes a single
+ * results table.
+ *
+ * Usage: ./a.out <job file> [results file] [model name] [design dir]
+ *          [cache dir]
+ *
+ * The model is looked up in ModelRegistry ("linear" by default), or is
+ * "exec:<program> [args]" for a model program run by one worker
+ * process per hardware thread (see ExternalModelPool and
+ * ExternalModelWorker.cpp), or the path of a model plugin ending in
+ * ".so" (see ModelPlugin and LinearPlugin.cpp).  Registered models use
+ * their batched form if they have one, and are evaluated by one
+ * thread per hardware thread if they are thread safe.  See
+ * SobolBatch.h for the job file format and SobolBatchJobs.txt for an
+ * example.  With a design directory, the design is kept there (see
+ * DesignStore) and later runs with the same dimension and N map it
+ * instead of generating it.  With a cache directory, model outputs are
+ * kept there (see EvaluationCache) and reruns only evaluate new points.
+ */
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+    {
+      std::cout << "usage: " << argv[0]
+		<< " <job file> [results file] [model name]"
+		<< " [design dir] [cache dir]\n";
+      return 1;
+    }
+
+  std::string jobFilename = argv[1];
+  std::string resultsFilename = argc > 2 ? argv[2] : "BatchResults.txt";
+  std::string modelName = argc > 3 ? argv[3] : "linear";
+
+  /* specify constant model parameters */
+  std::vector<Type> constants = {};
+
+  ModelFunction model = NULL;
+  ExternalModelPool *pool = NULL;
+  if (modelName.compare(0, 5, "exec:") == 0)
+    {
+      std::vector<std::string> command;
+      std::istringstream words(modelName.substr(5));
+      std::string word;
+      while (words >> word)
+	{
+	  command.push_back(word);
+	}
+      pool = new ExternalModelPool(command);
+    }
+  else
+    {
+      if (modelName.size() > 3
+	  && modelName.compare(modelName.size() - 3, 3, ".so") == 0)
+	{
+	  modelName = ModelPlugin::Load(modelName);
+	  if (modelName.empty())
+	    {
+	      return 1;
+	    }
+	}
+      model = ModelRegistry::Instance()->Lookup(modelName);
+    }
+  if (!model && !pool)
+    {
+      std::cout << "unknown model " << modelName << "\n";
+      return 1;
+    }
+
+  SobolBatch batch(model, constants);
+  if (pool)
+    {
+      batch.SetExternalModel(pool);
+    }
+  else
+    {
+      batch.SetBatchModel(ModelRegistry::Instance()->LookupBatch(modelName));
+      if (ModelRegistry::Instance()->IsThreadSafe(modelName))
+	{
+	  batch.SetNumThreads(0);
+	}
+    }
+  if (argc > 4)
+    {
+      batch.SetDesignStore(argv[4]);
+    }
+  EvaluationCache *cache = NULL;
+  if (argc > 5)
+    {
+      cache = new EvaluationCache(argv[5], EVALCACHE_DEFAULT_BYTES,
+				  modelName);
+      batch.SetEvaluationCache(cache);
+    }
+  if (!batch.ReadJobFile(jobFilename))
+    {
+      return 1;
+    }
+
+  std::cout << "running " << batch.GetNumJobs() << " jobs, dim = "
+	    << batch.GetDim() << "...\n\n";
+
+  std::chrono::steady_clock::time_point tic
+    = std::chrono::steady_clock::now();
+
+  batch.Run();
+
+  Type toc = std::chrono::duration<Type>
+    (std::chrono::steady_clock::now() - tic).count();
+
+  std::cout << "...done.\n\n";
+  std::cout << "total time: " << toc << "\n";
+  std::cout << "model evaluations: " << batch.GetModelEvaluations()
+	    << " (separate runs: " << batch.GetSeparateRunEvaluations()
+	    << ")\n\n";
+
+  if (!batch.WriteResults(resultsFilename))
+    {
+      return 1;
+    }
+  std::cout << "results written to " << resultsFilename << "\n";
+
+  if (cache)
+    {
+      std::cout << "cache hits: " << cache->GetHits() << ", misses: "
+		<< cache->GetMisses() << "\n";
+      delete cache;
+    }
+  delete pool;
+}
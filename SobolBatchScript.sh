@@ -0,0 +1,12 @@
+#!/bin/bash
+
+g++ -O2 -std=c++0x -pthread SobolBatch.cpp SobolBatchDriver.cpp ExternalModelPool.cpp SobolIndices.cpp EvaluationCache.cpp Philox.cpp Instrumentation.cpp QMCDesign.cpp DesignStore.cpp CorrelatedNormal.cpp ThreadPool.cpp WorkStealingPool.cpp ModelRegistry.cpp ModelPlugin.cpp ParseUtils.cpp Halton.cpp MT64.cpp InverseTransformation.cpp InverseCDFTable.cpp MersenneTwister.cpp DSFMT.cpp -ldl
+g++ -O2 -std=c++0x ExternalModelWorker.cpp -o linear_worker
+g++ -O2 -std=c++0x -shared -fPIC LinearPlugin.cpp -o linear_plugin.so
+
+# ./a.out SobolBatchJobs.txt BatchResults.txt
+# ./a.out SobolBatchJobs.txt BatchResults.txt linear
+# ./a.out SobolBatchJobs.txt BatchResults.txt linear designs
+# ./a.out SobolBatchJobs.txt BatchResults.txt linear designs evalcache
+# ./a.out SobolBatchJobs.txt BatchResults.txt "exec:./linear_worker"
+# ./a.out SobolBatchJobs.txt BatchResults.txt ./linear_plugin.so
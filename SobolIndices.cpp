@@ -1,6 +1,9 @@
 #include "SobolIndices.h"
 #include <fstream>
 
+/* runs whose Philox uniforms are generated in one Fill() call */
+#define PHILOX_BATCH 256U
+
 /* Ctor
  * Input:
  *
@@ -13,6 +16,12 @@
  * N_MC_ = number of Monte Carlo runs
  * CoV_ = defaulted to 1.0 to construct object without specifying CoV,
  *   used for CoV script.
+ * sampler_ = HALTON_SAMPLER (default) for the randomized Halton
+ *   sequence, PHILOX_SAMPLER for plain MC with the counter-based
+ *   Philox generator; then run i of the k-th call of
+ *   ComputeSensitivityIndices() uses sample (k-1)*N_MC + i, whatever
+ *   the thread
+ * seed_ = Philox key, unused for HALTON_SAMPLER
  */
 SobolIndices::
 SobolIndices(Type (*model_)(const std::vector<Type>&,
@@ -23,7 +32,10 @@ SobolIndices(Type (*model_)(const std::vector<Type>&,
 	     &initialDistroParams_,
 	     int dim_,
 	     unsigned int N_MC_,
-	     Type CoV_)
+	     Type CoV_,
+	     int sampler_,
+	     unsigned long long seed_)
+  : philox(seed_)
 {
   model = model_;
   constants = constants_;
@@ -32,6 +44,12 @@ SobolIndices(Type (*model_)(const std::vector<Type>&,
   dim = dim_;
   N_MC = N_MC_;
   CoV = CoV_;
+  numThreads = 0;
+  pipelineGenerators = 0;
+  pipelineEvaluators = 0;
+  stealPool = NULL;
+  sampler = sampler_;
+  nextSample = 0;
 
   /* initialize SIs */
   lowerIndex = 0;
@@ -39,15 +57,35 @@ SobolIndices(Type (*model_)(const std::vector<Type>&,
   modelVariance = 0;
   modelMean = 0;
 
+  /* normal parameters unless SetFamilies() says otherwise */
+  families.assign(dim, InverseTransformation::NORMAL_PARAM);
+  tables.resize(dim);
+
   /* allocate memory for model arg vectors */
   x1.resize(dim);
   x2.resize(dim);
   arg1.resize(dim);
   arg2.resize(dim);
 
-  /* construct halton (RASRAP) & InverseTransformation objects */
-  randomNumberGenerator = new halton();
+  /* construct InverseTransformation object.  The halton (RASRAP)
+   * object is built on first use in InitGenerator(), so objects that
+   * only ever run on a precomputed QMCDesign skip the prime, power
+   * buffer and permutation setup. */
+  randomNumberGenerator = NULL;
   invTrans = new InverseTransformation();
+  cache = NULL;
+}
+
+/* Constructs and initializes the halton (RASRAP) object if this has
+ * not been done yet */
+void SobolIndices::InitGenerator()
+{
+  if (randomNumberGenerator)
+    {
+      return;
+    }
+
+  randomNumberGenerator = new halton();
 
   /* init RNG: length of Halton vector, random start, random permute */
   randomNumberGenerator->init(2*dim,true,true);
@@ -86,6 +124,10 @@ void SobolIndices::DisplayMembers()
  * Overloading previous function to allow different indices than those
  * passed into ctor, as need in CoV routine.
  *
+ * The runs continue the generator from the previous call, so repeated
+ * calls give independent estimates.  The sums are kept, so that
+ * ExtendSensitivityIndices() can add runs to this estimate later.
+ *
  * Input:
  *   uncertainties = vector of parameter variances to use
  *   indices - set of parameters to compute sensitivity index for,
@@ -97,29 +139,162 @@ ComputeSensitivityIndices(const std::vector<Type> &uncertainties,
 {
   // std::cout << "Computing SIs, CoV \n";
 
-  /* MC accumulators */
-  Type f0_sum = 0, Dy_sum = 0, DT_sum = 0, D_sum = 0;
+  resumeAcc = SobolAccumulator();
+  resumeIndices = indices_.empty() ? indices : indices_;
+  resumeUncertainties = uncertainties;
+  AccumulateRuns(N_MC, resumeAcc);
+  AssignIndices(resumeAcc);
 
-  /* model evaluations */
-  Type f, f2, model1, model2;
+  return totalIndex;
+}
+
+/* Adds runs to the estimate of the last ComputeSensitivityIndices() or
+ * ExtendSensitivityIndices() call until it holds N_target runs, and
+ * reassigns the indices.  The new runs continue the generator where
+ * that call left it, so with the Halton sampler the result is the
+ * estimate a single call with N_target runs would give on the same
+ * points; a convergence study over increasing N then costs as much as
+ * its largest N.  N_MC becomes N_target.  If uncertainties or
+ * indices_ differ from the last call (or nothing was computed since
+ * the distributions were last changed) it starts from zero runs.  Runs
+ * cannot be taken back: an N_target below the runs already held is
+ * refused, and the estimate and N_MC are left as they are.
+ *
+ * Input:
+ *   N_target = total number of MC runs wanted
+ *   uncertainties, indices_ = as for ComputeSensitivityIndices()
+ */
+Type SobolIndices::
+ExtendSensitivityIndices(unsigned int N_target,
+			 const std::vector<Type> &uncertainties,
+			 const std::set<int> &indices_)
+{
+  const std::set<int> &S = indices_.empty() ? indices : indices_;
+  if (S != resumeIndices || uncertainties != resumeUncertainties)
+    {
+      resumeAcc = SobolAccumulator();
+      resumeIndices = S;
+      resumeUncertainties = uncertainties;
+    }
 
-  for (unsigned int i = 0; i < N_MC; ++i)
+  if (N_target < resumeAcc.n)
     {
-      /* generate 2*dim random numbers */
-      randomNumberGenerator->genHalton();
+      std::cout << "ExtendSensitivityIndices: already " << resumeAcc.n
+		<< " runs, cannot go down to " << N_target << "\n";
+      return totalIndex;
+    }
 
-      /* transform each random number to its distro. */
-      TransformToModelDomain(uncertainties);
+  if (N_target > resumeAcc.n)
+    {
+      AccumulateRuns(N_target - resumeAcc.n, resumeAcc);
+    }
+  N_MC = N_target;
+  if (resumeAcc.n > 0)
+    {
+      AssignIndices(resumeAcc);
+    }
 
-      /* assign xformed random numbers to proper model arg vectors */
-      if (indices_.empty())
+  return totalIndex;
+}
+
+/* Adds n runs for resumeIndices and resumeUncertainties to acc, taking
+ * the points from this object's generator */
+void SobolIndices::AccumulateRuns(unsigned int n, SobolAccumulator &acc)
+{
+  const std::vector<Type> &uncertainties = resumeUncertainties;
+
+  /* correlated params: all runs go through one design, so that the
+   * transform works on blocks of points */
+  if (!covariance.empty())
+    {
+      QMCDesign design(n, 2*dim);
+      if (sampler == PHILOX_SAMPLER)
 	{
-	  AssignModelArguments(indices);
+	  design.Generate(philox, nextSample);
+	  nextSample += n;
 	}
       else
 	{
-	  AssignModelArguments(indices_);
+	  InitGenerator();
+	  design.Generate(randomNumberGenerator);
 	}
+      AccumulateCorrelated(design, resumeIndices, n, acc);
+      return;
+    }
+
+  if (sampler != PHILOX_SAMPLER)
+    {
+      InitGenerator();
+    }
+  if (stealPool)
+    {
+      QMCDesign *design = NULL;
+      if (sampler != PHILOX_SAMPLER)
+	{
+	  PhaseTimer timer(PHASE_GENHALTON);
+	  design = new QMCDesign(n, 2*dim);
+	  design->Generate(randomNumberGenerator);
+	}
+      AccumulateBlocks(design, nextSample, n, resumeIndices,
+		       resumeUncertainties, acc);
+      delete design;
+      nextSample += n;
+      return;
+    }
+  if (pipelineEvaluators > 0)
+    {
+      AccumulatePipelined(n, acc);
+      nextSample += n;
+      return;
+    }
+  if (sampler == PHILOX_SAMPLER)
+    {
+      philoxPoints.resize(PHILOX_BATCH*2*dim);
+    }
+
+  /* model evaluations */
+  Type f, f2, model1, model2;
+
+  for (unsigned int i = 0; i < n; ++i)
+    {
+      /* generate 2*dim random numbers; Philox fills PHILOX_BATCH runs
+       * at a time */
+      {
+	PhaseTimer timer(PHASE_GENHALTON);
+	if (sampler == PHILOX_SAMPLER)
+	  {
+	    if (i % PHILOX_BATCH == 0)
+	      {
+		philox.Fill(nextSample + i,
+			    std::min(PHILOX_BATCH, n - i), 2*dim,
+			    &philoxPoints[0]);
+	      }
+	  }
+	else
+	  {
+	    randomNumberGenerator->genHalton();
+	  }
+      }
+
+      /* transform each random number to its distro. */
+      {
+	PhaseTimer timer(PHASE_TRANSFORM);
+	if (sampler == PHILOX_SAMPLER)
+	  {
+	    TransformToModelDomain(&philoxPoints[(i % PHILOX_BATCH)*2*dim],
+				   false, uncertainties);
+	  }
+	else
+	  {
+	    TransformToModelDomain(uncertainties);
+	  }
+      }
+
+      /* assign xformed random numbers to proper model arg vectors */
+      {
+	PhaseTimer timer(PHASE_ASSIGN);
+	AssignModelArguments(resumeIndices);
+      }
 
       // DisplayVector(x1);
       // DisplayVector(x2);
@@ -127,10 +302,13 @@ ComputeSensitivityIndices(const std::vector<Type> &uncertainties,
       // DisplayVector(arg2);
 
       /* MC accumulations */
-      f = model(x1,constants);
-      f2 = model(x2,constants);
-      model1 = model(arg1,constants);
-      model2 = model(arg2,constants);
+      {
+	PhaseTimer timer(PHASE_MODEL, 4);
+	f = EvaluateModel(x1);
+	f2 = EvaluateModel(x2);
+	model1 = EvaluateModel(arg1);
+	model2 = EvaluateModel(arg2);
+      }
 
       // std::cout << "f = " << f << "\n";
       // std::cout << "f2 = " << f2 << "\n";
@@ -138,18 +316,553 @@ ComputeSensitivityIndices(const std::vector<Type> &uncertainties,
       // std::cout << "model2 = " << model2 << "\n";
 
 
-      f0_sum += f;
-      D_sum += f*f;
-      Dy_sum += f*(model1 - f2);
-      DT_sum += pow((f - model2), 2.0);
+      PhaseTimer timer(PHASE_ACCUMULATE);
+      acc.Add(f, f2, model1, model2);
+    }
+  nextSample += n;
+}
+
+/* Adds n runs to acc, with the 2*dim uniforms of run i taken from row
+ * i of design or, if design is NULL, from Philox sample firstSample + i.
+ * The runs are split into tasks of SOBOL_STEAL_BLOCK runs, which run
+ * on stealPool if it is set; each task sums its runs on its own and
+ * adds the block sums to acc as it finishes.  The sums are exact, so
+ * the result does not depend on the pool or its number of threads.
+ */
+void SobolIndices::
+AccumulateBlocks(const QMCDesign *design, unsigned long long firstSample,
+		 unsigned int n, const std::set<int> &indices_,
+		 const std::vector<Type> &uncertainties,
+		 SobolAccumulator &acc)
+{
+  size_t numBlocks = (n + SOBOL_STEAL_BLOCK - 1)/SOBOL_STEAL_BLOCK;
+  std::mutex accMutex;
+
+  std::function<void(size_t)> task = [&](size_t b)
+    {
+      unsigned int first = b*SOBOL_STEAL_BLOCK;
+      unsigned int count = std::min(SOBOL_STEAL_BLOCK, n - first);
+      SobolAccumulator partial;
+      if (design)
+	{
+	  AccumulateBlock(design->Row(first), count, indices_,
+			  uncertainties, partial);
+	}
+      else
+	{
+	  std::vector<Type> points((size_t)count*2*dim);
+	  {
+	    PhaseTimer timer(PHASE_GENHALTON);
+	    philox.Fill(firstSample + first, count, 2*dim, &points[0]);
+	  }
+	  AccumulateBlock(&points[0], count, indices_, uncertainties,
+			  partial);
+	}
+      std::lock_guard<std::mutex> lock(accMutex);
+      acc.Merge(partial);
+    };
+
+  if (stealPool)
+    {
+      stealPool->ParallelFor(numBlocks, task);
+    }
+  else
+    {
+      for (size_t b = 0; b < numBlocks; ++b)
+	{
+	  task(b);
+	}
+    }
+}
+
+/* Adds the count runs whose uniforms are the rows of points (2*dim
+ * each) to acc.  Uses its own argument vectors, so that blocks can run
+ * concurrently. */
+void SobolIndices::
+AccumulateBlock(const Type *points, unsigned int count,
+		const std::set<int> &indices_,
+		const std::vector<Type> &uncertainties,
+		SobolAccumulator &acc)
+{
+  std::vector<Type> y1(dim), y2(dim), a1(dim), a2(dim);
+
+  for (unsigned int i = 0; i < count; ++i)
+    {
+      const Type *point = points + (size_t)i*2*dim;
+      {
+	PhaseTimer timer(PHASE_TRANSFORM);
+	for (int j = 0; j < dim; ++j)
+	  {
+	    y1[j] = TransformParameter(j, point[j], false, uncertainties);
+	    y2[j] = TransformParameter(j, point[j+dim], false,
+				       uncertainties);
+	  }
+      }
+      {
+	PhaseTimer timer(PHASE_ASSIGN);
+	for (int j = 0; j < dim; ++j)
+	  {
+	    bool inIndexSet = indices_.count(j+1);
+	    a1[j] = inIndexSet ? y1[j] : y2[j];
+	    a2[j] = inIndexSet ? y2[j] : y1[j];
+	  }
+      }
+
+      Type f, f2, model1, model2;
+      {
+	PhaseTimer timer(PHASE_MODEL, 4);
+	f = EvaluateModel(y1);
+	f2 = EvaluateModel(y2);
+	model1 = EvaluateModel(a1);
+	model2 = EvaluateModel(a2);
+      }
+
+      PhaseTimer timer(PHASE_ACCUMULATE);
+      acc.Add(f, f2, model1, model2);
+    }
+}
+
+/* Adds n runs for indices_ and uncertainties to acc, on Philox samples
+ * firstSample, ..., firstSample + n - 1 whatever the sampler, in block
+ * tasks on the work-stealing pool if one is set (see
+ * AccumulateBlocks()).  Changes no member, so it may be called from
+ * several threads at once, e.g. by the tasks of a Super Sobol loop.
+ */
+void SobolIndices::
+AccumulateSamples(unsigned long long firstSample, unsigned int n,
+		  const std::vector<Type> &uncertainties,
+		  const std::set<int> &indices_, SobolAccumulator &acc)
+{
+  AccumulateBlocks(NULL, firstSample, n,
+		   indices_.empty() ? indices : indices_, uncertainties,
+		   acc);
+}
+
+/* SOBOL_PIPELINE_BLOCK consecutive runs on their way through the
+ * pipeline of AccumulatePipelined() */
+struct SobolPipelineBlock
+{
+  unsigned int first, count;  /* runs first .. first+count-1 */
+  std::vector<Type> uniforms;  /* count rows of 2*dim, Philox only */
+  std::vector<Type> args;  /* per run x1, x2, arg1, arg2, dim each */
+  std::vector<Type> outputs;  /* per run f, f2, model1, model2 */
+};
+
+/* AccumulateRuns() with the stages of a run on different threads, so
+ * that model evaluations never wait for point generation and a slow
+ * model call does not hold up the generators:
+ *
+ *   generators  draw, transform and assemble the arguments of blocks
+ *               of SOBOL_PIPELINE_BLOCK runs; generator g takes blocks
+ *               g, g+G, ...  (G = 1 for the Halton sampler, whose
+ *               points come in sequence);
+ *   evaluators  make the 4 model calls of every run of blocks e, e+E,
+ *               ...;
+ *   reducer     the calling thread, adds the runs to acc in run order.
+ *
+ * Every pair of neighbouring stages is connected by an SPSCQueue, and
+ * since each stage takes its blocks in increasing order the next block
+ * a stage needs is always at the front of the queue it reads.  Block
+ * buffers go back to their generator through a queue from the
+ * reducer, which bounds the memory at G*E*SOBOL_PIPELINE_DEPTH blocks.
+ * The sums are those of the sequential loop, bit for bit.  The model
+ * must be safe to call from several threads.
+ */
+void SobolIndices::AccumulatePipelined(unsigned int n,
+				       SobolAccumulator &acc)
+{
+  const std::vector<Type> &uncertainties = resumeUncertainties;
+  const unsigned int E = pipelineEvaluators;
+  const unsigned int G = (sampler == PHILOX_SAMPLER)
+    ? std::max(pipelineGenerators, 1U) : 1;
+  const unsigned int perGenerator = E*SOBOL_PIPELINE_DEPTH;
+  const unsigned int numBlocks
+    = (n + SOBOL_PIPELINE_BLOCK - 1)/SOBOL_PIPELINE_BLOCK;
+
+  std::vector<SobolPipelineBlock> blocks(G*perGenerator);
+  std::vector<SPSCQueue<SobolPipelineBlock*> > toEvaluator(G*E);
+  std::vector<SPSCQueue<SobolPipelineBlock*> > toReducer(E);
+  std::vector<SPSCQueue<SobolPipelineBlock*> > freeBlocks(G);
+  /* sized to hold every block that can be in them, so pushes never
+   * wait */
+  for (unsigned int q = 0; q < G*E; ++q)
+    {
+      toEvaluator[q].Resize(perGenerator);
+    }
+  for (unsigned int e = 0; e < E; ++e)
+    {
+      toReducer[e].Resize(G*perGenerator);
+    }
+  for (unsigned int g = 0; g < G; ++g)
+    {
+      freeBlocks[g].Resize(perGenerator);
+      for (unsigned int k = 0; k < perGenerator; ++k)
+	{
+	  freeBlocks[g].Push(&blocks[g*perGenerator + k]);
+	}
+    }
+
+  /* parameter j+1 in the index set, looked up once */
+  std::vector<char> inIndexSet(dim);
+  for (int j = 0; j < dim; ++j)
+    {
+      inIndexSet[j] = resumeIndices.count(j+1);
+    }
+
+  ThreadPool pool(G + E);
+  for (unsigned int g = 0; g < G; ++g)
+    {
+      pool.Enqueue([&, g]()
+	{
+	  for (unsigned int b = g; b < numBlocks; b += G)
+	    {
+	      SobolPipelineBlock *block = freeBlocks[g].Pop();
+	      block->first = b*SOBOL_PIPELINE_BLOCK;
+	      block->count = std::min(SOBOL_PIPELINE_BLOCK,
+				      n - block->first);
+	      block->args.resize(SOBOL_PIPELINE_BLOCK*4*dim);
+	      if (sampler == PHILOX_SAMPLER)
+		{
+		  PhaseTimer timer(PHASE_GENHALTON);
+		  block->uniforms.resize(SOBOL_PIPELINE_BLOCK*2*dim);
+		  philox.Fill(nextSample + block->first, block->count, 2*dim,
+			      &block->uniforms[0]);
+		}
+
+	      for (unsigned int i = 0; i < block->count; ++i)
+		{
+		  Type *x = &block->args[i*4*dim];
+		  if (sampler != PHILOX_SAMPLER)
+		    {
+		      PhaseTimer timer(PHASE_GENHALTON);
+		      randomNumberGenerator->genHalton();
+		    }
+		  {
+		    PhaseTimer timer(PHASE_TRANSFORM);
+		    if (sampler == PHILOX_SAMPLER)
+		      {
+			const Type *u = &block->uniforms[i*2*dim];
+			for (int j = 0; j < dim; ++j)
+			  {
+			    x[j] = TransformParameter(j, u[j], false,
+						      uncertainties);
+			    x[dim+j] = TransformParameter(j, u[j+dim], false,
+							  uncertainties);
+			  }
+		      }
+		    else
+		      {
+			for (int j = 0; j < dim; ++j)
+			  {
+			    Type u1 = randomNumberGenerator->get_rnd(j+1);
+			    Type u2 = randomNumberGenerator->get_rnd(j+1+dim);
+			    x[j] = TransformParameter(j, u1, false,
+						      uncertainties);
+			    x[dim+j] = TransformParameter(j, u2, false,
+							  uncertainties);
+			  }
+		      }
+		  }
+		  PhaseTimer timer(PHASE_ASSIGN);
+		  for (int j = 0; j < dim; ++j)
+		    {
+		      x[2*dim+j] = inIndexSet[j] ? x[j] : x[dim+j];
+		      x[3*dim+j] = inIndexSet[j] ? x[dim+j] : x[j];
+		    }
+		}
+	      toEvaluator[g*E + b % E].Push(block);
+	    }
+	});
+    }
+
+  for (unsigned int e = 0; e < E; ++e)
+    {
+      pool.Enqueue([&, e]()
+	{
+	  std::vector<Type> x(dim);
+	  for (unsigned int b = e; b < numBlocks; b += E)
+	    {
+	      SobolPipelineBlock *block = toEvaluator[(b % G)*E + e].Pop();
+	      block->outputs.resize(SOBOL_PIPELINE_BLOCK*4);
+	      PhaseTimer timer(PHASE_MODEL, 4*block->count);
+	      for (unsigned int k = 0; k < 4*block->count; ++k)
+		{
+		  const Type *arg = &block->args[k*dim];
+		  x.assign(arg, arg + dim);
+		  block->outputs[k] = EvaluateModel(x);
+		}
+	      toReducer[e].Push(block);
+	    }
+	});
+    }
+
+  for (unsigned int b = 0; b < numBlocks; ++b)
+    {
+      SobolPipelineBlock *block = toReducer[b % E].Pop();
+      {
+	PhaseTimer timer(PHASE_ACCUMULATE);
+	const Type *y = &block->outputs[0];
+	for (unsigned int i = 0; i < block->count; ++i, y += 4)
+	  {
+	    acc.Add(y[0], y[1], y[2], y[3]);
+	  }
+      }
+      freeBlocks[b % G].Push(block);
+    }
+  pool.Wait();
+}
+
+/* Changes the source of the uniforms to sampler_ (HALTON_SAMPLER or
+ * PHILOX_SAMPLER, see the ctor) with Philox key seed_, starting again
+ * from the first sample */
+void SobolIndices::SetSampler(int sampler_, unsigned long long seed_)
+{
+  sampler = sampler_;
+  philox.SetSeed(seed_);
+  nextSample = 0;
+  resumeAcc = SobolAccumulator();
+}
+
+/* Runs the generator-driven computations as a pipeline on generators
+ * + evaluators threads besides the calling one (see
+ * AccumulatePipelined()); evaluators = 0 turns the pipeline off.  With
+ * the Halton sampler there is always one generator.  Correlated
+ * parameters are not pipelined, and a work-stealing pool takes
+ * precedence.
+ */
+void SobolIndices::SetPipeline(unsigned int generators,
+			       unsigned int evaluators)
+{
+  pipelineGenerators = generators;
+  pipelineEvaluators = evaluators;
+}
+
+/* Computes the upper and lower Sobol' indices like the function above,
+ * but draws the random numbers from the rows of a precomputed design
+ * instead of this object's halton generator.  The generator is never
+ * constructed on this path, so many SobolIndices objects can share one
+ * design.
+ *
+ * Input:
+ *   design - points to use; the first N_MC rows (or all rows if the
+ *            design is smaller) are used
+ *   uncertainties = vector of parameter variances to use
+ *   indices - set of parameters to compute sensitivity index for,
+ *             defaulted to empty in header
+ */
+Type SobolIndices::
+ComputeSensitivityIndices(const QMCDesign &design,
+			  const std::vector<Type> &uncertainties,
+			  const std::set<int> &indices_)
+{
+  if (design.GetCols() < 2*dim)
+    {
+      std::cout << "design has " << design.GetCols()
+		<< " columns, need " << 2*dim << "\n";
+      return totalIndex;
+    }
+
+  unsigned int N = std::min(N_MC, design.GetN());
+
+  if (!covariance.empty())
+    {
+      SobolAccumulator acc;
+      if (AccumulateCorrelated(design, indices_.empty() ? indices
+			       : indices_, N, acc))
+	{
+	  AssignIndices(acc);
+	}
+      return totalIndex;
+    }
+
+  /* MC accumulators */
+  SobolAccumulator acc;
+
+  /* model evaluations */
+  Type f, f2, model1, model2;
+
+  for (unsigned int i = 0; i < N; ++i)
+    {
+      /* transform the design point to the model domain */
+      {
+	PhaseTimer timer(PHASE_TRANSFORM);
+	TransformToModelDomain(design.Row(i), design.IsStandardNormal(),
+			       uncertainties);
+      }
+
+      /* assign xformed random numbers to proper model arg vectors */
+      {
+	PhaseTimer timer(PHASE_ASSIGN);
+	if (indices_.empty())
+	  {
+	    AssignModelArguments(indices);
+	  }
+	else
+	  {
+	    AssignModelArguments(indices_);
+	  }
+      }
+
+      /* MC accumulations */
+      {
+	PhaseTimer timer(PHASE_MODEL, 4);
+	f = EvaluateModel(x1);
+	f2 = EvaluateModel(x2);
+	model1 = EvaluateModel(arg1);
+	model2 = EvaluateModel(arg2);
+      }
+
+      PhaseTimer timer(PHASE_ACCUMULATE);
+      acc.Add(f, f2, model1, model2);
+    }
+
+  AssignIndices(acc);
+
+  return totalIndex;
+}
+
+/* Accumulates the indices of the index set S = indices_ for correlated
+ * normal parameters, with the estimators of Kucherenko, Tarantola and
+ * Annoni, "Estimation of global sensitivity indices for models with
+ * dependent variables", Comput. Phys. Commun. 183 (2012) 937-946:
+ *
+ *   lowerIndex = Var(E[f | y]),  totalIndex = E[Var(f | z)],
+ *
+ * y the parameters in S and z the others, non-normalized as in the
+ * independent case.  Both need draws of one group conditional on the
+ * other.  With the covariance factored in the order (y, z), the first
+ * |y| normal coordinates fix y and new values of the rest draw z given
+ * y; so the lower index is the usual pick-freeze estimator on that
+ * factor, and the total index the one on the factor ordered (z, y).
+ * Each run evaluates the model five times.  The factors are computed
+ * once per call and each block of runs goes through
+ * CorrelatedNormal::Transform() as a whole.  The sums go into acc;
+ * returns false if the covariance cannot be factored.
+ *
+ * Input:
+ *   design - Unif(0,1) or N(0,1) points, first dim coordinates for
+ *            sample A, next dim for sample B
+ *   indices_ - index set S
+ *   N - number of rows of design to use
+ */
+bool SobolIndices::
+AccumulateCorrelated(const QMCDesign &design,
+		     const std::set<int> &indices_, unsigned int N,
+		     SobolAccumulator &acc)
+{
+
+  /* variable orders (y, z) and (z, y) */
+  std::vector<int> yFirst, zFirst;
+  for (int j = 0; j < dim; ++j)
+    {
+      if (indices_.count(j+1))
+	{
+	  yFirst.push_back(j);
+	}
+    }
+  int ny = yFirst.size();
+  for (int j = 0; j < dim; ++j)
+    {
+      if (!indices_.count(j+1))
+	{
+	  yFirst.push_back(j);
+	  zFirst.push_back(j);
+	}
+    }
+  zFirst.insert(zFirst.end(), yFirst.begin(), yFirst.begin() + ny);
+
+  std::vector<Type> mean(dim);
+  for (int j = 0; j < dim; ++j)
+    {
+      mean[j] = distroParams[j][0];
+    }
+  CorrelatedNormal givenY, givenZ;
+  if (!givenY.Factor(mean, covariance, yFirst)
+      || !givenZ.Factor(mean, covariance, zFirst))
+    {
+      return false;
     }
 
+  /* normal coordinates of samples A, B and the two mixes, and the
+   * model arguments, for one block of runs */
+  const unsigned int blockSize = 4*CORRNORMAL_ROW_TILE;
+  size_t blockLen = (size_t)blockSize*dim;
+  std::vector<Type> UA(blockLen), UB(blockLen), UAB(blockLen),
+    UBA(blockLen);
+  std::vector<Type> XA(blockLen), XB(blockLen), XAB(blockLen),
+    XAT(blockLen), XBA(blockLen);
+  std::vector<Type> xT(dim);
+
+  for (unsigned int begin = 0; begin < N; begin += blockSize)
+    {
+      unsigned int n = std::min(blockSize, N - begin);
+      {
+	PhaseTimer timer(PHASE_TRANSFORM, n);
+	for (unsigned int r = 0; r < n; ++r)
+	  {
+	    const Type *point = design.Row(begin + r);
+	    Type *a = &UA[(size_t)r*dim], *b = &UB[(size_t)r*dim];
+	    for (int j = 0; j < dim; ++j)
+	      {
+		a[j] = design.IsStandardNormal() ? point[j]
+		  : invTrans->Normal(point[j], 0.0, 1.0);
+		b[j] = design.IsStandardNormal() ? point[j+dim]
+		  : invTrans->Normal(point[j+dim], 0.0, 1.0);
+	      }
+
+	    /* y from A and z from B in the order (y, z); z from A and
+	     * y from B in the order (z, y) */
+	    for (int p = 0; p < dim; ++p)
+	      {
+		UAB[(size_t)r*dim + p] = (p < ny) ? a[p] : b[p];
+		UBA[(size_t)r*dim + p] = (p < dim - ny) ? a[p] : b[p];
+	      }
+	  }
+
+	givenY.Transform(&UA[0], dim, n, &XA[0]);
+	givenY.Transform(&UB[0], dim, n, &XB[0]);
+	givenY.Transform(&UAB[0], dim, n, &XAB[0]);
+	givenZ.Transform(&UA[0], dim, n, &XAT[0]);
+	givenZ.Transform(&UBA[0], dim, n, &XBA[0]);
+      }
+
+      for (unsigned int r = 0; r < n; ++r)
+	{
+	  size_t row = (size_t)r*dim;
+	  x1.assign(XA.begin() + row, XA.begin() + row + dim);
+	  x2.assign(XB.begin() + row, XB.begin() + row + dim);
+	  arg1.assign(XAB.begin() + row, XAB.begin() + row + dim);
+	  xT.assign(XAT.begin() + row, XAT.begin() + row + dim);
+	  arg2.assign(XBA.begin() + row, XBA.begin() + row + dim);
+
+	  Type f, f2, model1, fT, model2;
+	  {
+	    PhaseTimer timer(PHASE_MODEL, 5);
+	    f = EvaluateModel(x1);
+	    f2 = EvaluateModel(x2);
+	    model1 = EvaluateModel(arg1);
+	    fT = EvaluateModel(xT);
+	    model2 = EvaluateModel(arg2);
+	  }
+
+	  PhaseTimer timer(PHASE_ACCUMULATE);
+	  acc.AddDependent(f, f2, model1, fT, model2);
+	}
+    }
+
+  return true;
+}
+
+/* Turns the MC sums in acc into the member variables lowerIndex,
+ * totalIndex, modelVariance and modelMean */
+void SobolIndices::AssignIndices(const SobolAccumulator &acc)
+{
   /* compute sensitivity indices */
-  modelMean = f0_sum/N_MC;
-  modelVariance = D_sum/N_MC  - modelMean*modelMean;
+  modelMean = acc.Mean();
+  modelVariance = acc.Variance();
 
-  Type Dy = Dy_sum/N_MC;
-  Type DT = DT_sum/N_MC;
+  Type Dy = acc.Dy_sum.Value()/acc.n;
+  Type DT = acc.DT_sum.Value()/acc.n;
 
   // std::cout << "Dy = " << Dy << "\n";
   // std::cout << "DT = " << DT << "\n";
@@ -161,9 +874,6 @@ ComputeSensitivityIndices(const std::vector<Type> &uncertainties,
   /* non-normalized */
   lowerIndex = Dy;
   totalIndex = DT/2.0;
-
-  return totalIndex;
-
 }
 
 /* Function AssignModelArguments fills the two vectors that will be 
@@ -216,19 +926,6 @@ TransformToModelDomain(const std::vector<Type> &uncertainties)
       /* true if "j" is in ORIGINAL index set */
       bool inIndexSet = indices.count(j+1);
 
-      Type mean = distroParams[j][0], var;
-
-      /* If parameter uncertainty not changed, leave as initial. Ow
-       * change to new uncertainty. */
-      if (uncertainties.empty())
-	{
-	  var = distroParams[j][1];
-	}
-      else
-	{
-	  var = uncertainties[j];
-	}
-
       /* change variance of parameter of interest by CoV.
        // * Also need to check the the index set being passed in is the
        // * one of the original index set, since also passing in the
@@ -240,8 +937,8 @@ TransformToModelDomain(const std::vector<Type> &uncertainties)
       // 	  var = pow(distroParams[j][0]*CoV, 2.0);
       // 	}
 
-      x1[j] = invTrans->Normal(x1[j], mean, var);
-      x2[j] = invTrans->Normal(x2[j], mean, var);
+      x1[j] = TransformParameter(j, x1[j], false, uncertainties);
+      x2[j] = TransformParameter(j, x2[j], false, uncertainties);
     }
 
   // /* For Vasicek, drew log a, log b, log sigma, so convert back to
@@ -254,6 +951,155 @@ TransformToModelDomain(const std::vector<Type> &uncertainties)
   // x2[2] = exp(x2[2]);  // convert log sigma -> sigma
 }
 
+/* Same as the function above, but the 2*dim random numbers come from
+ * one row of a QMCDesign instead of the halton generator.
+ *
+ * Input:
+ *    point = 2*dim coordinates, first dim for x1, last dim for x2
+ *    isStandardNormal = true if point holds N(0,1) values rather than
+ *        Unif(0,1) ones
+ *    uncertainties = vector of parameter uncertainties, may be empty
+ */
+void SobolIndices::
+TransformToModelDomain(const Type *point, bool isStandardNormal,
+		       const std::vector<Type> &uncertainties)
+{
+  for (int j = 0; j < dim; ++j)
+    {
+      x1[j] = TransformParameter(j, point[j], isStandardNormal,
+				 uncertainties);
+      x2[j] = TransformParameter(j, point[j+dim], isStandardNormal,
+				 uncertainties);
+    }
+}
+
+/* Transforms one coordinate u of parameter j (zero based) to the
+ * parameter's distribution, by inverse CDF so that a QMC point keeps
+ * its low discrepancy.  If isStandardNormal, u is a N(0,1) value and is
+ * first mapped back to Unif(0,1).  uncertainties, if not empty,
+ * replace the variance of normal, lognormal and truncated normal
+ * parameters; the other families keep their parameters.
+ */
+Type SobolIndices::
+TransformParameter(int j, Type u, bool isStandardNormal,
+		   const std::vector<Type> &uncertainties)
+{
+  const std::vector<Type> &params = distroParams[j];
+  int family = families[j];
+
+  if (family == InverseTransformation::NORMAL_PARAM
+      || family == InverseTransformation::LOGNORMAL_PARAM)
+    {
+      Type var = ParameterVariance(j, uncertainties);
+      Type x = isStandardNormal ? params[0] + sqrt(var)*u
+	: invTrans->Normal(u, params[0], var);
+      return (family == InverseTransformation::LOGNORMAL_PARAM)
+	? exp(x) : x;
+    }
+
+  if (isStandardNormal)
+    {
+      u = 0.5*erfc(-u/M_SQRT2);
+    }
+  if (tables[j].IsBuilt())
+    {
+      return tables[j].Evaluate(u);
+    }
+  if (family == InverseTransformation::TRUNCNORMAL_PARAM)
+    {
+      return invTrans->TruncatedNormal(u, params[0],
+				       ParameterVariance(j, uncertainties),
+				       params[2], params[3]);
+    }
+  return invTrans->Transform(u, family, params);
+}
+
+/* Sets the distribution of each parameter to the given
+ * InverseTransformation::*_PARAM family; distroParams must hold that
+ * family's parameters.  Returns false, and keeps the old families, if
+ * the sizes or parameters do not match.  Gamma and Beta parameters get
+ * an inverse CDF table, see InverseTransformation::Tabulate().
+ * PlotCoV() varies normal variances and so assumes normal parameters
+ * throughout.
+ */
+bool SobolIndices::SetFamilies(const std::vector<int> &families_)
+{
+  if ((int)families_.size() != dim)
+    {
+      return false;
+    }
+  for (int j = 0; j < dim; ++j)
+    {
+      if (!InverseTransformation::ValidParams(families_[j], distroParams[j]))
+	{
+	  std::cout << "bad parameters for distribution of parameter "
+		    << j+1 << "\n";
+	  return false;
+	}
+    }
+  families = families_;
+  for (int j = 0; j < dim; ++j)
+    {
+      tables[j] = InverseCDFTable();
+      if (InverseTransformation::IsIterative(families[j]))
+	{
+	  invTrans->Tabulate(families[j], distroParams[j], tables[j]);
+	}
+    }
+  resumeAcc = SobolAccumulator();
+  return true;
+}
+
+/* Makes the parameters correlated normal with means distroParams[j][0]
+ * and the given covariance (row-major dim x dim), which replaces the
+ * variances and families of distroParams; the indices are then those
+ * for dependent inputs, see AccumulateCorrelated().  An empty
+ * covariance goes back to independent parameters.  Returns false, and
+ * keeps the old setting, if the covariance has the wrong size or is
+ * not positive definite. */
+bool SobolIndices::SetCovariance(const std::vector<Type> &covariance_)
+{
+  if (!covariance_.empty())
+    {
+      std::vector<Type> mean(dim);
+      for (int j = 0; j < dim; ++j)
+	{
+	  mean[j] = distroParams[j][0];
+	}
+      CorrelatedNormal check;
+      if (!check.Factor(mean, covariance_))
+	{
+	  return false;
+	}
+    }
+  covariance = covariance_;
+  resumeAcc = SobolAccumulator();
+  return true;
+}
+
+/* Makes parameter j (zero based) follow the distribution whose inverse
+ * CDF table is given, e.g. one built from empirical samples; its
+ * distroParams are then unused */
+void SobolIndices::SetTable(int j, const InverseCDFTable &table)
+{
+  families[j] = InverseTransformation::TABULATED_PARAM;
+  tables[j] = table;
+  resumeAcc = SobolAccumulator();
+}
+
+/* Returns the variance to use for parameter j (zero based).  If
+ * parameter uncertainty not changed, leave as initial. Ow change to new
+ * uncertainty. */
+Type SobolIndices::
+ParameterVariance(int j, const std::vector<Type> &uncertainties)
+{
+  if (uncertainties.empty())
+    {
+      return distroParams[j][1];
+    }
+  return uncertainties[j];
+}
+
 /* Computes the indices for the range of CoVs in the CoV_ vector.
  * The resulting indices are stored in a 2D vector:
  *     first row = total index of origianl set,
@@ -261,6 +1107,23 @@ TransformToModelDomain(const std::vector<Type> &uncertainties)
  *     third row = model variance.
  * These indices are written to a file for plotting.
  *
+ * For a given CoV the parameters in the original index set get
+ * variance (mean*CoV)^2, the others keep their initial variance.  A
+ * zero mean would make that variance zero for every CoV, so a
+ * parameter with mean 0 gets standard deviation CoV times its initial
+ * one instead.  A CoV therefore only rescales N(0,1) draws, so one
+ * N(0,1) design of N_MC points is generated and shared by every CoV in
+ * the sweep.
+ *
+ * Both indices of a CoV come from the same pass over the design: with
+ * C the complement of the index set S, arg1 for C equals arg2 for S, so
+ * the lower index of C and the total index of S need only f, f2 and
+ * model(arg2), three model calls per run instead of eight.  The sweep
+ * is split into (CoV, block of runs) tasks that run concurrently on
+ * numThreads threads; block sums are added in block order, so the
+ * results do not depend on the number of threads.  The model must be
+ * safe to call from several threads.
+ *
  * Input:
  *     CoV_Vector = vector of CoVs to use in plotting
  *     filename = name of file for plotting
@@ -271,68 +1134,151 @@ PlotCoV(const std::vector<Type> &CoV_Vector,
 {
   std::cout << "PlotCoV \n";
 
-  // /* allocate Sobol index vectors */
-  // size_t num_CoV = CoV_Vector.size();
-  // std::vector<std::vector<Type> > 
-  //   results(3, std::vector<Type>(num_CoV));
-
-  // /* construct set containing complement of current param index */
-  // std::set<int> complement_indices;
-  // for (int i = 0; i < dim; ++i)
-  //   {
-  //     /* true if "i" is in index set */
-  //     bool inIndexSet = indices.count(i+1);
-
-  //     /* add index to complement set if not in original index set */
-  //     if (!inIndexSet)
-  // 	{
-  // 	  complement_indices.insert(i+1);
-  // 	}
-  //   }
-
-  // /* compute sensitivity indices */
-  // for (int i = 0; i < num_CoV; ++i)
-  //   {
-  //     /* change the class' CoV to the current one in the vector */
-  //     CoV = CoV_Vector[i];
-
-  //     /* compute the sobol indices for original index using this CoV */
-  //     ComputeSensitivityIndices();
-
-  //     /* store total index of original set in index vector */
-  //     results[0][i] = totalIndex;
-
-  //     /* compute sobol indices for complement set */
-  //     ComputeSensitivityIndices(complement_indices);
-
-  //     /* store lower index of complement set in index vector */
-  //     results[1][i] = lowerIndex;
-
-  //     /* store model variance */
-  //     results[2][i] = modelVariance;
-  //   }
-
-  // /* open plotting file and write data to it */
-  // std::ofstream plotFile(filename.c_str());
-  // if (plotFile.is_open())
-  //   {
-  //     for (int i = 0; i < num_CoV; ++i)
-  // 	{
-  // 	  plotFile << CoV_Vector[i] << " " << results[0][i] << " " 
-  // 		   << results[1][i] << " " << " " 
-  // 		   << results[2][i] << "\n";
-  // 	}
-  //   }
-  // else
-  //   {
-  //     std::cout << "unable to open plot file \n";
-  //   }
-
-  // /* close plotting file */
-  // plotFile.close();
-
-  // /* return Sobol indices */
-  // return results;
+  /* allocate Sobol index vectors */
+  size_t num_CoV = CoV_Vector.size();
+  std::vector<std::vector<Type> > 
+    results(3, std::vector<Type>(num_CoV));
+
+  /* one N(0,1) design for the whole sweep */
+  InitGenerator();
+  QMCDesign design(N_MC, 2*dim);
+  design.Generate(randomNumberGenerator);
+  design.TransformToStandardNormal(invTrans);
+
+  /* standard deviation of every parameter for every CoV */
+  std::vector<std::vector<Type> > sd(num_CoV, std::vector<Type>(dim));
+  for (size_t i = 0; i < num_CoV; ++i)
+    {
+      for (int j = 0; j < dim; ++j)
+	{
+	  /* true if "j" is in index set */
+	  bool inIndexSet = indices.count(j+1);
+
+	  Type var = distroParams[j][1];
+	  if (inIndexSet)
+	    {
+	      /* CoV relative to the initial sd if the mean is zero */
+	      Type scale = distroParams[j][0] != 0 ? distroParams[j][0]
+		: sqrt(distroParams[j][1]);
+	      var = pow(scale*CoV_Vector[i], 2.0);
+	    }
+	  sd[i][j] = sqrt(var);
+	}
+    }
+
+  /* compute sensitivity indices, one task per (CoV, block of runs) */
+  const unsigned int blockSize = 4096;
+  size_t numBlocks = (N_MC + blockSize - 1)/blockSize;
+  std::vector<SobolAccumulator> partial(num_CoV*numBlocks);
+  {
+    ThreadPool pool(numThreads);
+    for (size_t i = 0; i < num_CoV; ++i)
+      {
+	for (size_t b = 0; b < numBlocks; ++b)
+	  {
+	    unsigned int begin = b*blockSize;
+	    unsigned int end = std::min(N_MC, begin + blockSize);
+	    SobolAccumulator *acc = &partial[i*numBlocks + b];
+	    const std::vector<Type> *sd_i = &sd[i];
+	    pool.Enqueue([this, &design, sd_i, begin, end, acc]()
+			 {
+			   AccumulateCoVBlock(design, *sd_i, begin, end,
+					      *acc);
+			 });
+	  }
+      }
+    pool.Wait();
+  }
+
+  for (size_t i = 0; i < num_CoV; ++i)
+    {
+      SobolAccumulator acc;
+      for (size_t b = 0; b < numBlocks; ++b)
+	{
+	  acc.Merge(partial[i*numBlocks + b]);
+	}
+
+      /* store total index of original set in index vector */
+      results[0][i] = acc.TotalIndex();
+
+      /* store lower index of complement set in index vector */
+      results[1][i] = acc.LowerIndex();
+
+      /* store model variance */
+      results[2][i] = acc.Variance();
+    }
+
+  /* open plotting file and write data to it */
+  std::ofstream plotFile(filename.c_str());
+  if (plotFile.is_open())
+    {
+      for (size_t i = 0; i < num_CoV; ++i)
+	{
+	  plotFile << CoV_Vector[i] << " " << results[0][i] << " " 
+		   << results[1][i] << " " 
+		   << results[2][i] << "\n";
+	}
+    }
+  else
+    {
+      std::cout << "unable to open plot file \n";
+    }
+
+  /* close plotting file */
+  plotFile.close();
+
+  /* return Sobol indices */
+  return results;
+}
+
+/* Accumulates runs begin..end-1 of the design for PlotCoV().  sd holds
+ * the standard deviation of each parameter for the current CoV.  Uses
+ * its own argument vectors so that blocks can run concurrently.  The
+ * sums are arranged so that acc.TotalIndex() is the total index of the
+ * index set and acc.LowerIndex() the lower index of its complement.
+ */
+void SobolIndices::
+AccumulateCoVBlock(const QMCDesign &design, const std::vector<Type> &sd,
+		   unsigned int begin, unsigned int end,
+		   SobolAccumulator &acc)
+{
+  std::vector<Type> y1(dim), y2(dim), arg(dim);
+
+  /* membership of each parameter in the index set, looked up once */
+  std::vector<char> inIndexSet(dim);
+  for (int j = 0; j < dim; ++j)
+    {
+      inIndexSet[j] = indices.count(j+1);
+    }
+
+  for (unsigned int i = begin; i < end; ++i)
+    {
+      const Type *point = design.Row(i);
+      {
+	/* transform and argument assembly are one loop here */
+	PhaseTimer timer(PHASE_TRANSFORM);
+	for (int j = 0; j < dim; ++j)
+	  {
+	    Type mean = distroParams[j][0];
+	    y1[j] = mean + sd[j]*point[j];
+	    y2[j] = mean + sd[j]*point[j+dim];
+
+	    /* arg2 of the index set = arg1 of its complement */
+	    arg[j] = inIndexSet[j] ? y2[j] : y1[j];
+	  }
+      }
+
+      Type f, f2, model2;
+      {
+	PhaseTimer timer(PHASE_MODEL, 3);
+	f = EvaluateModel(y1);
+	f2 = EvaluateModel(y2);
+	model2 = EvaluateModel(arg);
+      }
+
+      PhaseTimer timer(PHASE_ACCUMULATE);
+      acc.Add(f, f2, model2, model2);
+    }
 }
 
 void SobolIndices::DisplayVector(const std::vector<Type>& vec)
@@ -14,9 +14,70 @@
 #include "Halton.h"
 #include "MT64.h"
 #include "InverseTransformation.h"
+#include "QMCDesign.h"
+#include "ThreadPool.h"
+#include "Instrumentation.h"
+#include "Philox.h"
+#include "CorrelatedNormal.h"
+#include "EvaluationCache.h"
+#include "SPSCQueue.h"
+#include "WorkStealingPool.h"
+#include "ExactSum.h"
+
+/* runs per block handed between the stages of the pipelined engine */
+#define SOBOL_PIPELINE_BLOCK 256U
+/* blocks each generator may have in flight per evaluator */
+#define SOBOL_PIPELINE_DEPTH 4
+/* runs per task on a work-stealing pool */
+#define SOBOL_STEAL_BLOCK 64U
 
 typedef double Type;
 
+/* Running sums of the Monte Carlo estimators used in
+ * ComputeSensitivityIndices().  n counts the accumulated runs.  The
+ * sums are exact (see ExactSum), so the estimates depend only on which
+ * runs were added, not on their order or on how accumulators of parts
+ * of the runs were merged: sequential, pipelined and work-stealing
+ * computations agree to the last bit for any number of threads. */
+struct SobolAccumulator
+{
+  ExactSum f0_sum, D_sum, Dy_sum, DT_sum;
+  unsigned int n;
+
+  SobolAccumulator() : n(0) {}
+  void Add(Type f, Type f2, Type model1, Type model2)
+  {
+    f0_sum.Add(f);
+    D_sum.Add(f*f);
+    Dy_sum.Add(f*(model1 - f2));
+    DT_sum.Add(pow((f - model2), 2.0));
+    ++n;
+  }
+  Type Mean() const {return f0_sum.Value()/n;}
+  Type Variance() const {return D_sum.Value()/n - Mean()*Mean();}
+  /* non-normalized */
+  Type LowerIndex() const {return Dy_sum.Value()/n;}
+  Type TotalIndex() const {return DT_sum.Value()/n/2.0;}
+  /* dependent inputs: f, f2 and model1 as in Add() from the sample
+   * ordered (y, z), fT and model2 from the one ordered (z, y) */
+  void AddDependent(Type f, Type f2, Type model1, Type fT, Type model2)
+  {
+    f0_sum.Add(f);
+    D_sum.Add(f*f);
+    Dy_sum.Add(f*(model1 - f2));
+    DT_sum.Add(pow((fT - model2), 2.0));
+    ++n;
+  }
+  void Merge(const SobolAccumulator &other)
+  {
+    f0_sum.Merge(other.f0_sum);
+    D_sum.Merge(other.D_sum);
+    Dy_sum.Merge(other.Dy_sum);
+    DT_sum.Merge(other.DT_sum);
+    n += other.n;
+  }
+};
+
 
 class SobolIndices
 {
@@ -26,6 +87,9 @@ class SobolIndices
   int dim;  /* number of model parameters */
   unsigned int N_MC;  /* no. of MC runs to use */
   Type CoV;  /* coefficient of variation = std/mean */
+  unsigned int numThreads;  /* threads for PlotCoV, 0 = all hardware */
+  /* threads of the pipelined engine; no pipeline if evaluators is 0 */
+  unsigned int pipelineGenerators, pipelineEvaluators;
 
   /* Sobol indices */
   Type lowerIndex, totalIndex, modelVariance, modelMean;
@@ -35,10 +99,63 @@ class SobolIndices
 
   /* distribution params of model params */
   std::vector<std::vector<Type> > distroParams;
+  /* distribution of each model param, InverseTransformation::*_PARAM */
+  std::vector<int> families;
+  /* inverse CDF tables, built for TABULATED_PARAM and iterative
+   * families, empty otherwise */
+  std::vector<InverseCDFTable> tables;
+  /* covariance of correlated normal params, row-major dim x dim;
+   * empty for independent params */
+  std::vector<Type> covariance;
   halton *randomNumberGenerator;  /* halton (RASRAP) object */
+  int sampler;  /* HALTON_SAMPLER or PHILOX_SAMPLER */
+  Philox philox;  /* counter-based generator for PHILOX_SAMPLER */
+  unsigned long long nextSample;  /* first Philox sample of next run */
+  std::vector<Type> philoxPoints;  /* rows of uniforms from philox */
   InverseTransformation *invTrans; /* inverse tarsnformation object */
+  EvaluationCache *cache;  /* model outputs on disk, NULL if not used */
+  WorkStealingPool *stealPool;  /* runs block tasks, NULL if not used */
+
+  /* sums, index set and variances of the last generator-driven
+   * computation, continued by ExtendSensitivityIndices() */
+  SobolAccumulator resumeAcc;
+  std::set<int> resumeIndices;
+  std::vector<Type> resumeUncertainties;
+
+  void InitGenerator();
+  /* model(x, constants), through the cache if there is one */
+  Type EvaluateModel(const std::vector<Type> &x)
+  {
+    return cache ? cache->Evaluate(model, x, constants)
+      : model(x, constants);
+  }
+  Type ParameterVariance(int j, const std::vector<Type> &uncertainties);
+  Type TransformParameter(int j, Type u, bool isStandardNormal,
+			  const std::vector<Type> &uncertainties);
+  void AssignIndices(const SobolAccumulator &acc);
+  bool AccumulateCorrelated(const QMCDesign &design,
+			    const std::set<int> &indices_, unsigned int N,
+			    SobolAccumulator &acc);
+  void AccumulateRuns(unsigned int n, SobolAccumulator &acc);
+  void AccumulatePipelined(unsigned int n, SobolAccumulator &acc);
+  void AccumulateBlocks(const QMCDesign *design,
+			unsigned long long firstSample, unsigned int n,
+			const std::set<int> &indices_,
+			const std::vector<Type> &uncertainties,
+			SobolAccumulator &acc);
+  void AccumulateBlock(const Type *points, unsigned int count,
+		       const std::set<int> &indices_,
+		       const std::vector<Type> &uncertainties,
+		       SobolAccumulator &acc);
+  void AccumulateCoVBlock(const QMCDesign &design,
+			  const std::vector<Type> &sd,
+			  unsigned int begin, unsigned int end,
+			  SobolAccumulator &acc);
 
  public:
+  /* sources of the 2*dim uniforms of each MC run */
+  enum {HALTON_SAMPLER = 0, PHILOX_SAMPLER = 1};
+
   SobolIndices(Type (*model_)(const std::vector<Type>&,
 			      const std::vector<Type>&),
 	       const std::vector<Type> &constants_,
@@ -47,15 +164,33 @@ class SobolIndices
 	       &initialDistroParams_,
 	       int dim_,
 	       unsigned int N_MC_,
-	       Type CoV_ = 1.0);
+	       Type CoV_ = 1.0,
+	       int sampler_ = HALTON_SAMPLER,
+	       unsigned long long seed_ = 0);
   void DisplayMembers();
   Type ComputeSensitivityIndices(const std::vector<Type> 
+				 &uncertainties = std::vector<Type>(),
+				 const std::set<int> &indices_
+				 = std::set<int>());
+  Type ExtendSensitivityIndices(unsigned int N_target,
+				const std::vector<Type> &uncertainties
+				= std::vector<Type>(),
+				const std::set<int> &indices_
+				= std::set<int>());
+  Type ComputeSensitivityIndices(const QMCDesign &design,
+				 const std::vector<Type>
 				 &uncertainties,
 				 const std::set<int> &indices_
 				 = std::set<int>());
+  void AccumulateSamples(unsigned long long firstSample, unsigned int n,
+			 const std::vector<Type> &uncertainties,
+			 const std::set<int> &indices_,
+			 SobolAccumulator &acc);
   void AssignModelArguments(const std::set<int>& indices_);
   void TransformToModelDomain(const std::vector<Type> &uncertainties
 			      = std::vector<Type>());
+  void TransformToModelDomain(const Type *point, bool isStandardNormal,
+			      const std::vector<Type> &uncertainties);
   std::vector<std::vector<Type> >
     PlotCoV(const std::vector<Type> &CoV_Vector, 
 	    std::string &filename);
@@ -65,6 +200,23 @@ class SobolIndices
   void DisplayVector(const std::vector<std::vector<Type> >& vec);
   Type GetLowerIndex() {return lowerIndex;}
   Type GetTotalIndex() {return totalIndex;}
+  Type GetModelVariance() {return modelVariance;}
+  Type GetModelMean() {return modelMean;}
+  unsigned int GetN() {return N_MC;}
+  int GetSampler() {return sampler;}
+  unsigned long long GetSeed() {return philox.GetSeed();}
+  void SetNumThreads(unsigned int numThreads_) {numThreads = numThreads_;}
+  void SetPipeline(unsigned int generators, unsigned int evaluators);
+  /* splits the runs into block tasks on pool, owned by the caller;
+   * NULL turns it off */
+  void SetWorkStealingPool(WorkStealingPool *pool) {stealPool = pool;}
+  void SetSampler(int sampler_, unsigned long long seed_ = 0);
+  bool SetFamilies(const std::vector<int> &families_);
+  void SetTable(int j, const InverseCDFTable &table);
+  bool SetCovariance(const std::vector<Type> &covariance_);
+  /* serves model calls from cache_, which stays owned by the caller;
+   * NULL turns it off */
+  void SetEvaluationCache(EvaluationCache *cache_) {cache = cache_;}
   /* void SetDistroParams(const std::vector<std::vector<Type> >& */
   /* 		       distroParams_); */
   ~SobolIndices()
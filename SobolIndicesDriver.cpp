@@ -3,7 +3,6 @@
 #include <fstream>
 #include <thread>  // std::this_thread::sleep_for
 #include <chrono>  // std::chrono::seconds
-#include <ctime>
 
 /* Practice linear model, parameters.size() = 4 */
 Type LinearModel(const std::vector<Type> &parameters,
@@ -71,10 +70,42 @@ int main(int argc, char** argv)
   // std::cout << "indices: \n";
   // DisplaySet(indices);
 
-  // /* coefficient of variation = std/mean for current parameter group */
+  /* coefficient of variation = std/mean for current parameter group */
   // Type CoV = 0.2;
-  // std::vector<Type> CoV_Vector 
-  //   = {0.01, 0.05, 0.1, 0.15, 0.2, 0.25, 0.3, 0.35};
+  std::vector<Type> CoV_Vector 
+    = {0.01, 0.05, 0.1, 0.15, 0.2, 0.25, 0.3, 0.35};
+
+  /* "./a.out cov" runs the CoV sweep instead of a single computation */
+  bool plotCoV = (argc > 1 && std::string(argv[1]) == "cov");
+
+  /* "./a.out convergence" prints the indices for increasing N, each
+   * extending the previous estimate by the new runs only */
+  bool convergence = (argc > 1 && std::string(argv[1]) == "convergence");
+  std::vector<unsigned int> N_Vector
+    = {20000, 50000, 100000, 200000, 300000, 400000, 500000, 600000,
+       700000, 800000, 900000, 1000000};
+
+  /* "instrument" anywhere on the command line times the phases of
+   * the computation and writes them to instrumentFile */
+  bool instrument = false;
+  for (int a = 1; a < argc; ++a)
+    {
+      instrument |= (std::string(argv[a]) == "instrument");
+    }
+  std::string instrumentFile = "Instrumentation.json";
+  Instrumentation::Enable(instrument);
+
+  /* "philox" samples by plain MC with the counter-based generator
+   * instead of the randomized Halton sequence */
+  int sampler = SobolIndices::HALTON_SAMPLER;
+  for (int a = 1; a < argc; ++a)
+    {
+      if (std::string(argv[a]) == "philox")
+	{
+	  sampler = SobolIndices::PHILOX_SAMPLER;
+	}
+    }
+  unsigned long long seed = 12345;
 
   /* file name to plot indices to when using CoV routines */
   std::string filename = "IndicesData.txt";
@@ -96,27 +127,115 @@ int main(int argc, char** argv)
   // SobolIndices sobol(Heston, constants, indices, distroParams,
   // 		     dim, N_MC, CoV);
   SobolIndices sobol(LinearModel, constants, indices, distroParams,
-  			 dim,N_MC);
+  			 dim, N_MC, 1.0, sampler, seed);
+
+  /* "correlated" makes the parameters correlated normal, with the
+   * variances above and correlation 0.5 between neighbours */
+  for (int a = 1; a < argc; ++a)
+    {
+      if (std::string(argv[a]) == "correlated")
+	{
+	  std::vector<Type> covariance(dim*dim, 0.0);
+	  for (int i = 0; i < dim; ++i)
+	    {
+	      covariance[i*dim + i] = distroParams[i][1];
+	      if (i + 1 < dim)
+		{
+		  covariance[i*dim + i + 1] = covariance[(i + 1)*dim + i]
+		    = 0.5*sqrt(distroParams[i][1]*distroParams[i + 1][1]);
+		}
+	    }
+	  sobol.SetCovariance(covariance);
+	}
+    }
+
+  /* "cache" keeps the model outputs in cacheDirectory, so a rerun with
+   * the same points evaluates nothing again */
+  EvaluationCache *cache = NULL;
+  for (int a = 1; a < argc; ++a)
+    {
+      if (std::string(argv[a]) == "cache")
+	{
+	  cache = new EvaluationCache("EvalCache", EVALCACHE_DEFAULT_BYTES,
+				      "linear");
+	  sobol.SetEvaluationCache(cache);
+	}
+    }
+
+  /* "pipeline" overlaps point generation, model calls and
+   * accumulation on separate threads; the results do not change */
+  for (int a = 1; a < argc; ++a)
+    {
+      if (std::string(argv[a]) == "pipeline")
+	{
+	  sobol.SetPipeline(2, 2);
+	}
+    }
+
+  /* "steal" splits the runs into block tasks on a work-stealing pool,
+   * one thread per hardware thread */
+  WorkStealingPool *pool = NULL;
+  for (int a = 1; a < argc; ++a)
+    {
+      if (std::string(argv[a]) == "steal")
+	{
+	  pool = new WorkStealingPool();
+	  sobol.SetWorkStealingPool(pool);
+	}
+    }
 
   // /* print member of SobolIndices object for verification */
   // sobol.DisplayMembers();
 
-  clock_t tic = clock();
+  std::chrono::steady_clock::time_point tic
+    = std::chrono::steady_clock::now();
 
   /* compute sensitivity indices */
   std::cout << "computing sensitivity indices...\n\n";
-   sobol.ComputeSensitivityIndices();
-  // std::vector<std::vector<Type> > results 
-  //   = sobol.PlotCoV(CoV_Vector, filename);
+  if (plotCoV)
+    {
+      std::vector<std::vector<Type> > results 
+	= sobol.PlotCoV(CoV_Vector, filename);
+    }
+  else if (convergence)
+    {
+      for (auto N : N_Vector)
+	{
+	  sobol.ExtendSensitivityIndices(N);
+	  std::cout << N << " " << sobol.GetLowerIndex() << " "
+		    << sobol.GetTotalIndex() << "\n";
+	}
+      std::cout << "\n";
+    }
+  else
+    {
+      sobol.ComputeSensitivityIndices();
+    }
 
   std::cout << "...done.\n\n";
 
-  Type toc = (Type)(clock() - tic) / CLOCKS_PER_SEC;
+  Type toc = std::chrono::duration<Type>
+    (std::chrono::steady_clock::now() - tic).count();
   std::cout << "total time: " << toc << "\n\n";
 
+  if (instrument)
+    {
+      Instrumentation::WriteJSON(instrumentFile, toc);
+      std::cout << "instrumentation written to " << instrumentFile
+		<< "\n\n";
+    }
+
   /* display sensitivity indices */
   sobol.DisplayMembers();
 
+  if (cache)
+    {
+      std::cout << "cache hits: " << cache->GetHits() << ", misses: "
+		<< cache->GetMisses() << "\n\n";
+      delete cache;
+    }
+  delete pool;
+
   // /* write to file */
   // std::ofstream File("sigma.txt", std::ios::app);
   // File << N_MC << " " << actual_N_MC << " " << sobol.GetLowerIndex() << " " << sobol.GetTotalIndex() << "\n";
@@ -0,0 +1,55 @@
+/* C ABI of model plugins: shared objects that provide a model to the
+ * drivers at run time (see ModelPlugin).  A plugin defines
+ *
+ *   extern "C" const SobolModelPlugin* sobol_model_plugin(void);
+ *
+ * returning a description that stays valid while the plugin is
+ * loaded, and is built with e.g.
+ *
+ *   g++ -O2 -shared -fPIC MyModel.cpp -o mymodel.so
+ *
+ * Only C types cross the boundary, so plugins can be written in C,
+ * Fortran (via a C wrapper) or any C++ compiler.  See LinearPlugin.cpp.
+ */
+
+#ifndef SOBOLMODELPLUGIN_H
+#define SOBOLMODELPLUGIN_H
+
+#define SOBOL_PLUGIN_ABI_VERSION 1
+#define SOBOL_PLUGIN_ENTRY "sobol_model_plugin"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SobolModelPlugin
+{
+  int abiVersion;  /* SOBOL_PLUGIN_ABI_VERSION */
+  const char *name;  /* name the model is registered under */
+
+  /* nonzero if evaluate and evaluateBatch may run in several threads
+   * at once; otherwise calls are serialized */
+  int threadSafe;
+
+  /* output at the point x[0..dim-1] */
+  double (*evaluate)(const double *x, int dim, const double *constants,
+		     int numConstants);
+
+  /* optional: outputs Y[0..n-1] at the n points stored row-major in X
+   * (n x dim); NULL to use evaluate point by point */
+  void (*evaluateBatch)(const double *X, unsigned int n, int dim,
+			const double *constants, int numConstants,
+			double *Y);
+
+  /* optional: called in each thread before its first evaluation and
+   * when that thread exits, e.g. for per-thread work space */
+  void (*threadInit)(void);
+  void (*threadFinish)(void);
+} SobolModelPlugin;
+
+typedef const SobolModelPlugin* (*SobolModelPluginEntry)(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -2,7 +2,7 @@
 
 # g++ -O2 -std=c++0x SobolIndices.cpp SobolIndicesDriver.cpp Halton.cpp MT64.cpp InverseTransformation.cpp 
 
-g++ -O2 -std=c++0x SobolIndices.cpp SobolIndicesDriver.cpp Halton.cpp MT64.cpp InverseTransformation.cpp MersenneTwister.cpp pdflib.cpp rnglib.cpp
+g++ -O2 -std=c++0x -pthread SobolIndices.cpp EvaluationCache.cpp Philox.cpp Instrumentation.cpp SobolIndicesDriver.cpp QMCDesign.cpp CorrelatedNormal.cpp ThreadPool.cpp WorkStealingPool.cpp Halton.cpp MT64.cpp InverseTransformation.cpp InverseCDFTable.cpp MersenneTwister.cpp DSFMT.cpp pdflib.cpp rnglib.cpp RngStream.cpp
 
 # ./a.out 20000
 # ./a.out 50000
@@ -17,6 +17,15 @@ g++ -O2 -std=c++0x SobolIndices.cpp SobolIndicesDriver.cpp Halton.cpp MT64.cpp I
 # ./a.out 900000
 # ./a.out 1000000
 
+# ./a.out cov
+# ./a.out convergence
+# ./a.out instrument
+# ./a.out philox
+# ./a.out correlated
+# ./a.out philox cache
+# ./a.out philox pipeline
+# ./a.out philox steal
+
 # ./a.out 25
 # ./a.out 27.5
 # ./a.out 30
@@ -0,0 +1,544 @@
+#include "SobolServer.h"
+#include "ParseUtils.h"
+#include <sstream>
+#include <limits>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* pause before retrying a failed accept(), e.g. when out of
+ * descriptors, in milliseconds */
+#define SOBOLSERVER_ACCEPT_BACKOFF 100
+
+/* longest request line accepted, in bytes; a client that sends more
+ * without a newline is disconnected */
+#define SOBOLSERVER_MAX_LINE 65536
+
+/* Writes one reply line, silently dropped once the client has gone */
+void SobolConnection::Send(const std::string &line)
+{
+  std::lock_guard<std::mutex> lock(writeMutex);
+  if (!isOpen)
+    {
+      return;
+    }
+
+  std::string message = line + "\n";
+  size_t sent = 0;
+  while (sent < message.size())
+    {
+      ssize_t n = send(fd, message.data() + sent, message.size() - sent,
+		       MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR)
+	{
+	  continue;
+	}
+      if (n <= 0)
+	{
+	  isOpen = false;
+	  return;
+	}
+      sent += n;
+    }
+}
+
+SobolConnection::~SobolConnection()
+{
+  close(fd);
+}
+
+/* Ctor
+ * Input:
+ *
+ * socketPath_ = path of the Unix domain socket to listen on
+ * numThreads = number of job threads, 0 for one per hardware thread
+ * maxDesigns_ = number of generated designs kept in memory
+ */
+SobolServer::SobolServer(const std::string &socketPath_,
+			 unsigned int numThreads,
+			 size_t maxDesigns_)
+{
+  socketPath = socketPath_;
+  listenFd = -1;
+  running = false;
+  maxDesigns = maxDesigns_;
+
+  pool = new ThreadPool(numThreads);
+  RNG = NULL;
+  RNGCols = 0;
+  invTrans = new InverseTransformation();
+  designStore = NULL;
+}
+
+/* Keeps the designs in files in directory as well, so that they
+ * survive restarts and are shared with other processes; see
+ * DesignStore.  Call before Run(). */
+void SobolServer::SetDesignStore(const std::string &directory)
+{
+  delete designStore;
+  designStore = new DesignStore(directory);
+}
+
+/* Binds the socket and serves connections until Stop() is called or a
+ * client sends "shutdown".  Returns false if the socket could not be
+ * set up.
+ */
+bool SobolServer::Run()
+{
+  struct sockaddr_un address;
+  if (socketPath.size() >= sizeof(address.sun_path))
+    {
+      std::cout << "socket path too long: " << socketPath << "\n";
+      return false;
+    }
+
+  listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0)
+    {
+      std::cout << "unable to create socket: " << strerror(errno) << "\n";
+      return false;
+    }
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socketPath.c_str(),
+	  sizeof(address.sun_path) - 1);
+
+  /* remove a stale socket left by a previous run */
+  unlink(socketPath.c_str());
+
+  if (bind(listenFd, (struct sockaddr*)&address, sizeof(address)) < 0
+      || listen(listenFd, 64) < 0)
+    {
+      std::cout << "unable to listen on " << socketPath << ": "
+		<< strerror(errno) << "\n";
+      close(listenFd);
+      listenFd = -1;
+      return false;
+    }
+
+  std::cout << "listening on " << socketPath << " with "
+	    << pool->GetNumThreads() << " threads\n";
+
+  running = true;
+  while (running)
+    {
+      int fd = accept(listenFd, NULL, NULL);
+      ReapConnections();
+      if (fd < 0)
+	{
+	  if (!running)
+	    {
+	      break;  /* listening socket shut down by Stop() */
+	    }
+	  if (errno != EINTR)
+	    {
+	      /* e.g. EMFILE or ECONNABORTED: the server itself is fine */
+	      std::cout << "accept failed: " << strerror(errno) << "\n";
+	      std::this_thread::sleep_for
+		(std::chrono::milliseconds(SOBOLSERVER_ACCEPT_BACKOFF));
+	    }
+	  continue;
+	}
+
+      std::shared_ptr<SobolConnection> connection(new SobolConnection(fd));
+      std::lock_guard<std::mutex> lock(connectionMutex);
+      connections.push_back(connection);
+      std::thread thread([this, connection]()
+			 {
+			   ServeConnection(connection);
+			   std::lock_guard<std::mutex>
+			     lock(connectionMutex);
+			   finishedThreads.push_back
+			     (std::this_thread::get_id());
+			 });
+      connectionThreads[thread.get_id()] = std::move(thread);
+    }
+
+  /* wake up connection readers, then let running jobs finish; the
+   * last job of each connection closes its descriptor */
+  {
+    std::lock_guard<std::mutex> lock(connectionMutex);
+    for (auto& i : connections)
+      {
+	std::shared_ptr<SobolConnection> connection = i.lock();
+	if (connection)
+	  {
+	    shutdown(connection->fd, SHUT_RD);
+	  }
+      }
+  }
+  ReapConnections();
+  for (auto& i : connectionThreads)
+    {
+      i.second.join();
+    }
+  connectionThreads.clear();
+  finishedThreads.clear();
+  connections.clear();
+  pool->Wait();
+
+  close(listenFd);
+  listenFd = -1;
+  unlink(socketPath.c_str());
+  return true;
+}
+
+/* Joins the reader threads that have returned and forgets the
+ * connections that are gone */
+void SobolServer::ReapConnections()
+{
+  std::vector<std::thread> finished;
+  {
+    std::lock_guard<std::mutex> lock(connectionMutex);
+    for (auto& id : finishedThreads)
+      {
+	finished.push_back(std::move(connectionThreads[id]));
+	connectionThreads.erase(id);
+      }
+    finishedThreads.clear();
+    connections.remove_if([](const std::weak_ptr<SobolConnection> &i)
+			  {
+			    return i.expired();
+			  });
+  }
+  for (auto& thread : finished)
+    {
+      thread.join();
+    }
+}
+
+/* Makes Run() return once queued jobs are finished */
+void SobolServer::Stop()
+{
+  running = false;
+  if (listenFd >= 0)
+    {
+      shutdown(listenFd, SHUT_RDWR);
+    }
+}
+
+/* Reads requests from one client, line by line, until it disconnects
+ * or sends a line longer than SOBOLSERVER_MAX_LINE */
+void SobolServer::
+ServeConnection(std::shared_ptr<SobolConnection> connection)
+{
+  std::string buffer;
+  char chunk[4096];
+
+  for (;;)
+    {
+      ssize_t n = recv(connection->fd, chunk, sizeof(chunk), 0);
+      if (n < 0 && errno == EINTR)
+	{
+	  continue;
+	}
+      if (n <= 0)
+	{
+	  return;
+	}
+      buffer.append(chunk, n);
+
+      size_t newline;
+      while ((newline = buffer.find('\n')) != std::string::npos)
+	{
+	  std::string line = buffer.substr(0, newline);
+	  buffer.erase(0, newline + 1);
+	  if (!line.empty() && line[line.size()-1] == '\r')
+	    {
+	      line.erase(line.size()-1);
+	    }
+	  if (!line.empty())
+	    {
+	      HandleRequest(line, connection);
+	    }
+	}
+      if (buffer.size() > SOBOLSERVER_MAX_LINE)
+	{
+	  connection->Send("error request line too long");
+	  return;
+	}
+    }
+}
+
+/* Dispatches one request line */
+void SobolServer::
+HandleRequest(const std::string &line,
+	      std::shared_ptr<SobolConnection> connection)
+{
+  std::vector<std::string> words = Split(line, ' ');
+  if (words.empty())
+    {
+      return;
+    }
+
+  if (words[0] == "ping")
+    {
+      connection->Send("pong");
+      return;
+    }
+  if (words[0] == "models")
+    {
+      std::string reply = "models";
+      for (const auto& i : ModelRegistry::Instance()->GetNames())
+	{
+	  reply += " " + i;
+	}
+      connection->Send(reply);
+      return;
+    }
+  if (words[0] == "shutdown")
+    {
+      connection->Send("bye");
+      Stop();
+      return;
+    }
+  if (words[0] != "job")
+    {
+      connection->Send("error unknown request " + words[0]);
+      return;
+    }
+
+  std::shared_ptr<SobolJob> job(new SobolJob);
+  std::string error;
+  if (!ParseJob(line, *job, error))
+    {
+      connection->Send("error id=" + job->id + " " + error);
+      return;
+    }
+
+  /* designs are generated on a pool thread so that a large N does not
+   * stall the other requests of this connection */
+  std::shared_ptr<std::atomic<size_t> >
+    remaining(new std::atomic<size_t>(job->indexSets.size()));
+  pool->Enqueue([this, job, connection, remaining]()
+		{
+		  int cols = 2*job->distroParams.size();
+		  std::shared_ptr<const QMCDesign> design
+		    = GetDesign(cols, job->N);
+		  for (size_t i = 0; i < job->indexSets.size(); ++i)
+		    {
+		      pool->Enqueue([=]()
+				    {
+				      RunIndexSet(job, i, design,
+						  connection, remaining);
+				    });
+		    }
+		});
+}
+
+/* Fills job from a "job ..." request line.  Returns false and sets
+ * error if a field is missing or malformed. */
+bool SobolServer::
+ParseJob(const std::string &line, SobolJob &job, std::string &error)
+{
+  std::map<std::string, std::string> fields;
+  std::vector<std::string> words = Split(line, ' ');
+  for (size_t i = 1; i < words.size(); ++i)
+    {
+      size_t equals = words[i].find('=');
+      if (equals == std::string::npos)
+	{
+	  error = "expected key=value, got " + words[i];
+	  return false;
+	}
+      fields[words[i].substr(0, equals)] = words[i].substr(equals + 1);
+    }
+
+  job.id = fields.count("id") ? fields["id"] : "";
+
+  const char *required[] = {"id", "model", "N", "params", "sets"};
+  for (auto key : required)
+    {
+      if (!fields.count(key))
+	{
+	  error = std::string("missing ") + key;
+	  return false;
+	}
+    }
+
+  job.model = ModelRegistry::Instance()->Lookup(fields["model"]);
+  if (!job.model)
+    {
+      error = "unknown model " + fields["model"];
+      return false;
+    }
+
+  char *end;
+  unsigned long N = strtoul(fields["N"].c_str(), &end, 10);
+  if (*end != '\0' || N == 0
+      || N > std::numeric_limits<unsigned int>::max())
+    {
+      error = "bad N " + fields["N"];
+      return false;
+    }
+  job.N = N;
+
+  job.distroParams.clear();
+  job.families.clear();
+  for (const auto& i : Split(fields["params"], ';'))
+    {
+      int family;
+      std::vector<Type> params;
+      if (!ParseDistribution(i, family, params))
+	{
+	  error = "bad params entry " + i;
+	  return false;
+	}
+      job.families.push_back(family);
+      job.distroParams.push_back(params);
+    }
+  int dim = job.distroParams.size();
+  if (dim == 0 || 2*dim > HALTON_DIM)
+    {
+      error = "params must give between 1 and "
+	+ std::to_string(HALTON_DIM/2) + " parameters";
+      return false;
+    }
+
+  job.indexSets.clear();
+  for (const auto& i : Split(fields["sets"], ';'))
+    {
+      std::set<int> indexSet;
+      if (!ParseIndexSet(i, dim, indexSet))
+	{
+	  error = "bad index set " + i;
+	  return false;
+	}
+      job.indexSets.push_back(indexSet);
+    }
+  if (job.indexSets.empty())
+    {
+      error = "no index sets";
+      return false;
+    }
+
+  if (fields.count("constants")
+      && !ParseNumbers(fields["constants"], job.constants))
+    {
+      error = "bad constants " + fields["constants"];
+      return false;
+    }
+
+  return true;
+}
+
+/* Returns the N(0,1) design with cols columns and N rows, generating
+ * and caching it if it is not in memory yet.  With a design store it
+ * is mapped from there, and only generated if not stored either.
+ */
+std::shared_ptr<const QMCDesign> SobolServer::
+GetDesign(int cols, unsigned int N)
+{
+  std::pair<int, unsigned int> key(cols, N);
+  {
+    std::lock_guard<std::mutex> lock(designMutex);
+    if (designs.count(key))
+      {
+	return designs[key];
+      }
+  }
+
+  std::lock_guard<std::mutex> generatorLock(generatorMutex);
+
+  /* another job may have generated it while we waited */
+  {
+    std::lock_guard<std::mutex> lock(designMutex);
+    if (designs.count(key))
+      {
+	return designs[key];
+      }
+  }
+
+  auto generate = [this, cols](QMCDesign &design)
+    {
+      if (!RNG || RNGCols < cols)
+	{
+	  delete RNG;
+	  RNG = new halton();
+	  /* init RNG: length of Halton vector, random start, random
+	   * permute */
+	  RNG->init(cols,true,true);
+	  RNGCols = cols;
+	}
+      design.Generate(RNG);
+    };
+
+  std::shared_ptr<const QMCDesign> shared;
+  if (designStore)
+    {
+      shared = designStore->Get("halton", N, cols, true, generate);
+    }
+  else
+    {
+      QMCDesign *design = new QMCDesign(N, cols);
+      generate(*design);
+      design->TransformToStandardNormal(invTrans);
+      shared.reset(design);
+    }
+
+  std::lock_guard<std::mutex> lock(designMutex);
+  designs[key] = shared;
+  designOrder.push_back(key);
+  while (designs.size() > maxDesigns)
+    {
+      designs.erase(designOrder.front());
+      designOrder.pop_front();
+    }
+  return shared;
+}
+
+/* Computes the Sobol' indices of one index set of a job on a shared
+ * design and sends the result line, or an error line if the job's
+ * distribution families do not fit its parameters.  The last index set
+ * of the job to finish also sends "done". */
+void SobolServer::
+RunIndexSet(std::shared_ptr<const SobolJob> job, size_t set,
+	    std::shared_ptr<const QMCDesign> design,
+	    std::shared_ptr<SobolConnection> connection,
+	    std::shared_ptr<std::atomic<size_t> > remaining)
+{
+  const std::set<int> &indexSet = job->indexSets[set];
+  int dim = job->distroParams.size();
+
+  std::unique_ptr<SobolIndices> sobol
+    (new SobolIndices(job->model, job->constants, indexSet,
+		      job->distroParams, dim, job->N));
+  if (!sobol->SetFamilies(job->families))
+    {
+      connection->Send("error id=" + job->id + " set="
+		       + FormatSet(indexSet) + " bad distribution families");
+    }
+  else
+    {
+      sobol->ComputeSensitivityIndices(*design, std::vector<Type>(),
+				       indexSet);
+
+      std::ostringstream reply;
+      reply.precision(17);
+      reply << "result id=" << job->id
+	    << " set=" << FormatSet(indexSet)
+	    << " lower=" << sobol->GetLowerIndex()
+	    << " total=" << sobol->GetTotalIndex()
+	    << " mean=" << sobol->GetModelMean()
+	    << " variance=" << sobol->GetModelVariance();
+      connection->Send(reply.str());
+    }
+
+  if (--(*remaining) == 0)
+    {
+      connection->Send("done id=" + job->id);
+    }
+}
+
+SobolServer::~SobolServer()
+{
+  Stop();
+  delete pool;
+  delete RNG;
+  delete invTrans;
+  delete designStore;
+}
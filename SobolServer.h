@@ -0,0 +1,128 @@
+/* Class SobolServer is a long-running sensitivity-analysis daemon.  It
+ * listens on a local Unix domain socket, accepts Sobol' index jobs and
+ * streams the results back, keeping the Halton generator, its
+ * permutation tables and the generated point designs warm between jobs
+ * so that many small jobs do not each pay process start-up and
+ * generator setup.
+ *
+ * Protocol: one request per line, fields separated by spaces.
+ *
+ *   job id=<id> model=<name> N=<runs> params=<m1>,<v1>;<m2>,<v2>;...
+ *       sets=<i>,<j>;<k>;... [constants=<c1>,<c2>,...]
+ *
+ * params gives the N(mean,variance) distribution of each model
+ * parameter (so dim = number of entries), or another distribution as
+ * "<family>:<p1>,<p2>,..." as in SobolBatch job files, and sets lists
+ * the index sets (1 based) to compute indices for.  For every index set the server
+ * answers, as soon as it is done,
+ *
+ *   result id=<id> set=<i>,<j> lower=<Dy> total=<DT/2> mean=<f0>
+ *       variance=<D>
+ *
+ * or "error id=<id> set=<i>,<j> <message>" if that set cannot be run,
+ * followed by "done id=<id>" once the whole job has finished, or
+ * "error id=<id> <message>" if the request cannot be run.  A request
+ * line longer than SOBOLSERVER_MAX_LINE closes the connection.  Other
+ * requests: "models" lists the registered models, "ping" answers
+ * "pong" and "shutdown" stops the server.
+ *
+ * Jobs run concurrently on an internal thread pool, one task per index
+ * set.  Models must therefore be safe to call from several threads.
+ */
+
+#ifndef SOBOLSERVER_H
+#define SOBOLSERVER_H
+
+#include <map>
+#include <list>
+#include <memory>
+#include <atomic>
+#include <string>
+#include "SobolIndices.h"
+#include "ModelRegistry.h"
+#include "ThreadPool.h"
+#include "DesignStore.h"
+
+typedef double Type;
+
+/* one parsed "job" request */
+struct SobolJob
+{
+  std::string id;
+  ModelFunction model;
+  unsigned int N;
+  std::vector<std::vector<Type> > distroParams;
+  std::vector<int> families;  /* InverseTransformation::*_PARAM */
+  std::vector<std::set<int> > indexSets;
+  std::vector<Type> constants;
+};
+
+/* one client connection; shared by the jobs it submitted so that
+ * replies can still be written (or dropped) after the reader exits.
+ * The descriptor is closed when the last of them lets go. */
+struct SobolConnection
+{
+  int fd;
+  std::mutex writeMutex;
+  bool isOpen;
+  SobolConnection(int fd_) : fd(fd_), isOpen(true) {}
+  void Send(const std::string &line);
+  ~SobolConnection();
+};
+
+class SobolServer
+{
+ private:
+  std::string socketPath;  /* file system path of the socket */
+  int listenFd;  /* listening socket descriptor */
+  std::atomic<bool> running;
+  ThreadPool *pool;  /* runs the jobs */
+
+  /* reader threads by id, and the ids of those that have returned and
+   * can be joined; connections are kept weakly, to wake their readers
+   * at shutdown */
+  std::mutex connectionMutex;
+  std::map<std::thread::id, std::thread> connectionThreads;
+  std::vector<std::thread::id> finishedThreads;
+  std::list<std::weak_ptr<SobolConnection> > connections;
+
+  /* halton (RASRAP) generator shared by all jobs.  halton keeps its
+   * bases, power buffer and permutations in static members, so only
+   * one generator is kept and it is only touched with generatorMutex
+   * held.  It is re-initialized when a job needs more coordinates than
+   * it currently provides. */
+  std::mutex generatorMutex;
+  halton *RNG;
+  int RNGCols;
+  InverseTransformation *invTrans;
+
+  /* N(0,1) designs keyed by (columns, N), oldest first in designOrder */
+  std::mutex designMutex;
+  std::map<std::pair<int, unsigned int>,
+    std::shared_ptr<const QMCDesign> > designs;
+  std::list<std::pair<int, unsigned int> > designOrder;
+  size_t maxDesigns;  /* cached designs kept before evicting oldest */
+  DesignStore *designStore;  /* designs on disk, NULL if not used */
+
+  std::shared_ptr<const QMCDesign> GetDesign(int cols, unsigned int N);
+  void ServeConnection(std::shared_ptr<SobolConnection> connection);
+  void ReapConnections();
+  void HandleRequest(const std::string &line,
+		     std::shared_ptr<SobolConnection> connection);
+  bool ParseJob(const std::string &line, SobolJob &job,
+		std::string &error);
+  void RunIndexSet(std::shared_ptr<const SobolJob> job, size_t set,
+		   std::shared_ptr<const QMCDesign> design,
+		   std::shared_ptr<SobolConnection> connection,
+		   std::shared_ptr<std::atomic<size_t> > remaining);
+
+ public:
+  SobolServer(const std::string &socketPath_,
+	      unsigned int numThreads = 0,
+	      size_t maxDesigns_ = 16);
+  void SetDesignStore(const std::string &directory);
+  bool Run();
+  void Stop();
+  ~SobolServer();
+};
+#endif
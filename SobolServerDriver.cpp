@@ -0,0 +1,61 @@
+#include "SobolServer.h"
+#include "ModelPlugin.h"
+#include <cstdlib>
+
+/* Starts the resident sensitivity-analysis server.
+ *
+ * Usage: ./a.out [socket path] [number of job threads] [design dir]
+ *          [model plugin] ...
+ *
+ * Each model plugin (see ModelPlugin) is registered under the name it
+ * declares, so jobs can ask for it by model=<name>.
+ * With a design directory, the point designs are kept there as files
+ * (see DesignStore) and reused after restarts.
+ *
+ * Example session (with socat):
+ *   $ socat - UNIX-CONNECT:/tmp/supersobol.sock
+ *   job id=1 model=linear N=10000 params=0,1;0,4;0,9;0,16 sets=1;2;3,4
+ *   result id=1 set=1 lower=... total=... mean=... variance=...
+ *   ...
+ *   done id=1
+ */
+int main(int argc, char** argv)
+{
+  /* path of the Unix domain socket to listen on */
+  std::string socketPath = "/tmp/supersobol.sock";
+  if (argc > 1)
+    {
+      socketPath = argv[1];
+    }
+
+  /* number of job threads, 0 = one per hardware thread */
+  unsigned int numThreads = 0;
+  if (argc > 2)
+    {
+      numThreads = atoi(argv[2]);
+    }
+
+  /* models other than the built-in ones are registered here, e.g.
+   * ModelRegistry::Instance()->Register("heston", Heston); */
+  for (int a = 4; a < argc; ++a)
+    {
+      std::string name = ModelPlugin::Load(argv[a]);
+      if (name.empty())
+	{
+	  return 1;
+	}
+      std::cout << "model " << name << " loaded from " << argv[a] << "\n";
+    }
+
+  SobolServer server(socketPath, numThreads);
+  if (argc > 3)
+    {
+      server.SetDesignStore(argv[3]);
+    }
+  if (!server.Run())
+    {
+      return 1;
+    }
+
+  return 0;
+}
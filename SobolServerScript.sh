@@ -0,0 +1,8 @@
+#!/bin/bash
+
+g++ -O2 -std=c++0x -pthread SobolServer.cpp SobolServerDriver.cpp SobolIndices.cpp EvaluationCache.cpp Philox.cpp Instrumentation.cpp ParseUtils.cpp QMCDesign.cpp DesignStore.cpp CorrelatedNormal.cpp ModelRegistry.cpp ModelPlugin.cpp ThreadPool.cpp WorkStealingPool.cpp Halton.cpp MT64.cpp InverseTransformation.cpp InverseCDFTable.cpp MersenneTwister.cpp DSFMT.cpp -ldl
+
+# ./a.out /tmp/supersobol.sock
+# ./a.out /tmp/supersobol.sock 4
+# ./a.out /tmp/supersobol.sock 4 designs
+# ./a.out /tmp/supersobol.sock 4 designs ./linear_plugin.so
@@ -3,7 +3,6 @@
 #include <fstream>
 #include <thread>  // std::this_thread::sleep_for
 #include <chrono>  // std::chrono::seconds
-#include <ctime>
 
 /* Practice linear model, parameters.size() = 4 */
 Type LinearModel(const std::vector<Type> &parameters,
@@ -66,6 +65,16 @@ int main(int argc, char** argv)
    /* number of MC runs to compute Super Sobol indices */
    int N_Super_Sobol = 10000;
 
+  /* "instrument" anywhere on the command line times the phases of
+   * the computation and writes them to instrumentFile */
+  bool instrument = false;
+  for (int a = 1; a < argc; ++a)
+    {
+      instrument |= (std::string(argv[a]) == "instrument");
+    }
+  std::string instrumentFile = "Instrumentation.json";
+  Instrumentation::Enable(instrument);
+
 
   /* index set to compute Super Sobol index for */
   std::set<int> indices = {2};
@@ -136,7 +145,29 @@ int main(int argc, char** argv)
   /* print member of SobolIndices object for verification */
   superSobol.DisplayMembers();
 
-  clock_t tic = clock();
+  /* "telemetry" on the command line streams the running estimates */
+  for (int a = 1; a < argc; ++a)
+    {
+      if (std::string(argv[a]) == "telemetry")
+	{
+	  superSobol.EnableTelemetry("SuperSobolTelemetry.txt", 100);
+	}
+    }
+
+  /* "steal" runs the iterations and their Sobol runs as tasks on a
+   * work-stealing pool, one thread per hardware thread */
+  WorkStealingPool *pool = NULL;
+  for (int a = 1; a < argc; ++a)
+    {
+      if (std::string(argv[a]) == "steal")
+	{
+	  pool = new WorkStealingPool();
+	  superSobol.SetWorkStealingPool(pool, 12345);
+	}
+    }
+
+  std::chrono::steady_clock::time_point tic
+    = std::chrono::steady_clock::now();
 
   // /* compute sensitivity indices */
   // std::cout << "computing sensitivity indices...\n\n";
@@ -150,11 +181,20 @@ int main(int argc, char** argv)
 
   std::cout << "...done.\n\n";
 
-  Type toc = (Type)(clock() - tic) / CLOCKS_PER_SEC;
+  Type toc = std::chrono::duration<Type>
+    (std::chrono::steady_clock::now() - tic).count();
   std::cout << "total time: " << toc << "\n\n";
 
+  if (instrument)
+    {
+      Instrumentation::WriteJSON(instrumentFile, toc);
+      std::cout << "instrumentation written to " << instrumentFile
+		<< "\n\n";
+    }
+
   /* display sensitivity indices */
   superSobol.DisplayMembers();
+  delete pool;
 
   // /* write to file */
   // std::ofstream File("sigma.txt", std::ios::app);
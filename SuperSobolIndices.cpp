@@ -35,11 +35,22 @@ SuperSobolIndices(Type (*model_)(const std::vector<Type>&,
   paramUncertaintyDistroParams = paramUncertaintyDistroParams_;
   dim = dim_;
   N_Super_Sobol = N_Super_Sobol_;
+  N_MC = N_MC_;
 
   // intialize Super Sobol indices
   lowerSuperIndex = 0;
   totalSuperIndex = 0;
 
+  // no telemetry unless EnableTelemetry() is called
+  telemetry = NULL;
+  telemetryInterval = 0;
+
+  // iterations run in order unless SetWorkStealingPool() is called
+  stealPool = NULL;
+  nextSample = 0;
+  prevSampler = SobolIndices::HALTON_SAMPLER;
+  prevSeed = 0;
+
   // allocate model argument vectors
   s1.resize(dim);
   s2.resize(dim);
@@ -92,33 +103,74 @@ ComputeSuperSobolIndices()
   Type f0_sum_super = 0, Dy_sum_super = 0, DT_sum_super = 0, 
     D_sum_super = 0;
 
-  // model evaluations
-  Type F, F2, F_model1, F_model2;
-
-  for (unsigned int i = 0; i < N_Super_Sobol; ++i)
+  /* adds iteration i, with Sobol indices y[0..3] = F, F2, F_model1,
+   * F_model2; iterations must come in order */
+  auto accumulate = [&](unsigned int i, const Type *y)
     {
-      // std::cout << i << "\n";
-      // generate 2*dim random numbers
-      RNG->genHalton();
-
-      // transform each random number to parameter uncertainty distro
-      TransformToParamUncertaintyDomain();
-
-      /* assign xformed RVs to proper model argument vectors, will now
-       * have uncertainties for each parameter */
-      AssignUncertaintyModelArguments();
-
-      // compute Sobol index for given uncertainties
-      F = sobol->ComputeSensitivityIndices(s1);
-      F2 = sobol->ComputeSensitivityIndices(s2);
-      F_model1 = sobol->ComputeSensitivityIndices(s_arg1);
-      F_model2 = sobol->ComputeSensitivityIndices(s_arg2);
+      Type F = y[0], F2 = y[1], F_model1 = y[2], F_model2 = y[3];
 
       // MC accumulations for Super Sobol indices
+      PhaseTimer timer(PHASE_SUPER_ACCUMULATE);
       f0_sum_super += F;
       D_sum_super += F*F;
       Dy_sum_super += F*(F_model1 - F2); 
       DT_sum_super += pow((F - F_model2), 2.0);
+
+      // queue running estimates; the file is written by another thread
+      if (telemetry && ((i+1) % telemetryInterval == 0 
+			|| i+1 == N_Super_Sobol))
+	{
+	  Type n = i+1;
+	  Type mean = f0_sum_super/n;
+	  telemetry->Record(i+1, mean, D_sum_super/n - mean*mean,
+			    Dy_sum_super/n, DT_sum_super/n/2.0);
+	}
+    };
+
+  /* with a work-stealing pool the iterations are accumulated as the
+   * ones before them finish, see ComputeIterations() */
+  if (stealPool)
+    {
+      ComputeIterations(accumulate);
+    }
+  else
+    {
+      // model evaluations: F, F2, F_model1, F_model2
+      Type y[4];
+
+      for (unsigned int i = 0; i < N_Super_Sobol; ++i)
+	{
+	  // std::cout << i << "\n";
+	  // generate 2*dim random numbers
+	  {
+	    PhaseTimer timer(PHASE_SUPER_GENHALTON);
+	    RNG->genHalton();
+	  }
+
+	  // transform each random number to parameter uncertainty distro
+	  {
+	    PhaseTimer timer(PHASE_SUPER_TRANSFORM);
+	    TransformToParamUncertaintyDomain();
+	  }
+
+	  /* assign xformed RVs to proper model argument vectors, will now
+	   * have uncertainties for each parameter */
+	  {
+	    PhaseTimer timer(PHASE_SUPER_ASSIGN);
+	    AssignUncertaintyModelArguments();
+	  }
+
+	  // compute Sobol index for given uncertainties
+	  {
+	    PhaseTimer timer(PHASE_SUPER_SOBOL, 4);
+	    y[0] = sobol->ComputeSensitivityIndices(s1);
+	    y[1] = sobol->ComputeSensitivityIndices(s2);
+	    y[2] = sobol->ComputeSensitivityIndices(s_arg1);
+	    y[3] = sobol->ComputeSensitivityIndices(s_arg2);
+	  }
+
+	  accumulate(i, y);
+	}
     }
 
   // compute Super Sobol indices
@@ -141,6 +193,142 @@ ComputeSuperSobolIndices()
   totalSuperIndex = DT_super/2.0;
 }
 
+/* Computes the four Sobol total indices F, F2, F_model1, F_model2 of
+ * every iteration and passes them to accumulate(i, y), y[0..3] = F,
+ * F2, F_model1, F_model2, in iteration order.  The uncertainties are
+ * drawn in order as in ComputeSuperSobolIndices(); then one task per
+ * thread on stealPool takes the iterations in order, and the blocks of
+ * Sobol runs inside an iteration are tasks too, so a thread that runs
+ * out of work takes whatever is left of them.  Index c of iteration i
+ * uses the Philox samples from nextSample + (4*i + c)*N_MC on, so the
+ * results do not depend on the number of threads.
+ *
+ * A finished iteration sets its done flag, and the thread that
+ * finished it accumulates the iterations done in a row from the first
+ * one not yet accumulated.  As only a few iterations run at a time,
+ * running estimates reach the telemetry as the computation goes.
+ */
+void SuperSobolIndices::
+ComputeIterations(const std::function<void(unsigned int, const Type*)>
+		  &accumulate)
+{
+  std::vector<Type> uncertainties((size_t)N_Super_Sobol*4*dim);
+  for (unsigned int i = 0; i < N_Super_Sobol; ++i)
+    {
+      {
+	PhaseTimer timer(PHASE_SUPER_GENHALTON);
+	RNG->genHalton();
+      }
+      {
+	PhaseTimer timer(PHASE_SUPER_TRANSFORM);
+	TransformToParamUncertaintyDomain();
+      }
+      PhaseTimer timer(PHASE_SUPER_ASSIGN);
+      AssignUncertaintyModelArguments();
+      Type *s = &uncertainties[(size_t)i*4*dim];
+      std::copy(s1.begin(), s1.end(), s);
+      std::copy(s2.begin(), s2.end(), s + dim);
+      std::copy(s_arg1.begin(), s_arg1.end(), s + 2*dim);
+      std::copy(s_arg2.begin(), s_arg2.end(), s + 3*dim);
+    }
+
+  unsigned long long firstSample = nextSample;
+  nextSample += 4ULL*N_Super_Sobol*N_MC;
+
+  std::vector<Type> outputs((size_t)4*N_Super_Sobol);
+  std::vector<std::atomic<bool> > done(N_Super_Sobol);
+  std::atomic<unsigned int> next(0);  /* next iteration to start */
+  std::mutex prefixMutex;
+  unsigned int prefix = 0;  /* iterations accumulated, guarded */
+
+  /* the calling thread helps, so one task more than workers */
+  stealPool->ParallelFor(stealPool->GetNumThreads() + 1, [&](size_t)
+    {
+      for (unsigned int i = next.fetch_add(1); i < N_Super_Sobol;
+	   i = next.fetch_add(1))
+	{
+	  {
+	    PhaseTimer timer(PHASE_SUPER_SOBOL, 4);
+	    for (int c = 0; c < 4; ++c)
+	      {
+		size_t k = 4*(size_t)i + c;
+		const Type *s = &uncertainties[k*dim];
+		SobolAccumulator acc;
+		sobol->AccumulateSamples(firstSample + k*N_MC, N_MC,
+					 std::vector<Type>(s, s + dim),
+					 indices, acc);
+		outputs[k] = acc.TotalIndex();
+	      }
+	  }
+	  done[i].store(true, std::memory_order_release);
+
+	  std::lock_guard<std::mutex> lock(prefixMutex);
+	  while (prefix < N_Super_Sobol
+		 && done[prefix].load(std::memory_order_acquire))
+	    {
+	      accumulate(prefix, &outputs[(size_t)4*prefix]);
+	      ++prefix;
+	    }
+	}
+    });
+}
+
+/* Runs ComputeSuperSobolIndices() on pool (owned by the caller; NULL
+ * goes back to the sequential loop).  The Sobol indices then sample by
+ * Philox with key seed rather than by the Halton sequence, since their
+ * points must not depend on the order the iterations run in; NULL
+ * gives them back the sampler they had before.
+ */
+void SuperSobolIndices::
+SetWorkStealingPool(WorkStealingPool *pool, unsigned long long seed)
+{
+  if (pool)
+    {
+      if (!stealPool)
+	{
+	  prevSampler = sobol->GetSampler();
+	  prevSeed = sobol->GetSeed();
+	}
+      sobol->SetSampler(SobolIndices::PHILOX_SAMPLER, seed);
+      sobol->SetWorkStealingPool(pool);
+      nextSample = 0;
+    }
+  else if (stealPool)
+    {
+      sobol->SetWorkStealingPool(NULL);
+      sobol->SetSampler(prevSampler, prevSeed);
+    }
+  stealPool = pool;
+}
+
+/* Turns on the telemetry stream of ComputeSuperSobolIndices(): every
+ * interval iterations (and after the last one) the running mean,
+ * variance and Super Sobol indices are appended to filename by a
+ * background thread.
+ *
+ * Input:
+ *   filename = telemetry file, see Telemetry.h for the format
+ *   interval = number of iterations between records
+ *
+ * Output:
+ *   true if the file could be opened
+ */
+bool SuperSobolIndices::
+EnableTelemetry(const std::string &filename, unsigned int interval)
+{
+  delete telemetry;
+  telemetry = new Telemetry(filename);
+  telemetryInterval = interval > 0 ? interval : 1;
+
+  if (!telemetry->IsOpen())
+    {
+      delete telemetry;
+      telemetry = NULL;
+      return false;
+    }
+  return true;
+}
+
 /* Fills the s_arg1 and s_arg2 member vectors that hold the 
  * uncertainties for the corresponding parameters according to the
  * parameter index for which we are computing Super Sobol indices for
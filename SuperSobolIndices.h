@@ -2,6 +2,7 @@
 #define SUPERSOBOLINDICES_H
 
 #include "SobolIndices.h"
+#include "Telemetry.h"
 
 typedef double Type;
 
@@ -19,6 +20,7 @@ class SuperSobolIndices
 
   // number of MC runs to compute Super Sobol indices
   unsigned int N_Super_Sobol;
+  unsigned int N_MC;  // number of MC runs of each Sobol index
   int dim;  // number of parameters in model
   std::set<int> indices;  // index set to compute Super Sobol index of
   /* std::vector<Type> constants;  // model constants, if needed */
@@ -42,6 +44,22 @@ class SuperSobolIndices
 */
   std::vector<Type> s1, s2, s_arg1, s_arg2;
 
+  /* running estimates are recorded every telemetryInterval iterations
+   * if telemetry is set, see EnableTelemetry() */
+  Telemetry *telemetry;
+  unsigned int telemetryInterval;
+
+  /* runs the iterations and their Sobol runs as tasks if set, see
+   * SetWorkStealingPool(); nextSample is the first Philox sample of
+   * the next ComputeSuperSobolIndices(); the Sobol indices go back to
+   * prevSampler and prevSeed when the pool is taken away */
+  WorkStealingPool *stealPool;
+  unsigned long long nextSample;
+  int prevSampler;
+  unsigned long long prevSeed;
+
+  void ComputeIterations
+    (const std::function<void(unsigned int, const Type*)> &accumulate);
 
  public:
   SuperSobolIndices(Type (*model_)(const std::vector<Type>&, 
@@ -58,6 +76,10 @@ class SuperSobolIndices
   void ComputeSuperSobolIndices();
   void TransformToParamUncertaintyDomain();
   void AssignUncertaintyModelArguments();
+  bool EnableTelemetry(const std::string &filename,
+		       unsigned int interval);
+  void SetWorkStealingPool(WorkStealingPool *pool,
+			   unsigned long long seed = 0);
 
   /* void ChangeParameterUncertainty(); */
   void DisplayVector(const std::vector<std::vector<Type> > &vec);
@@ -68,6 +90,7 @@ class SuperSobolIndices
       delete RNG;
       delete invTrans;
       delete sobol;
+      delete telemetry;
     }
 };
 #endif
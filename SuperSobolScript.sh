@@ -2,8 +2,11 @@
 
 # g++ -O2 -std=c++0x SobolIndices.cpp SobolIndicesDriver.cpp Halton.cpp MT64.cpp InverseTransformation.cpp 
 
-g++ -O2 -std=c++0x SuperSobolIndices.cpp SobolIndices.cpp SuperSobolDriver.cpp Halton.cpp MT64.cpp InverseTransformation.cpp MersenneTwister.cpp pdflib.cpp rnglib.cpp
+g++ -O2 -std=c++0x -pthread SuperSobolIndices.cpp Telemetry.cpp SobolIndices.cpp EvaluationCache.cpp Philox.cpp Instrumentation.cpp SuperSobolDriver.cpp QMCDesign.cpp CorrelatedNormal.cpp ThreadPool.cpp WorkStealingPool.cpp Halton.cpp MT64.cpp InverseTransformation.cpp InverseCDFTable.cpp MersenneTwister.cpp DSFMT.cpp pdflib.cpp rnglib.cpp RngStream.cpp
 
+# ./a.out instrument
+# ./a.out telemetry
+# ./a.out steal
 # ./a.out 20000
 # ./a.out 50000
 # ./a.out 100000
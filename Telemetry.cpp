@@ -0,0 +1,91 @@
+#include "Telemetry.h"
+#include <iostream>
+
+/* Ctor
+ * Input:
+ *   filename = telemetry file; records are appended to it
+ */
+Telemetry::Telemetry(const std::string &filename)
+  : stopping(false), start(std::chrono::steady_clock::now())
+{
+  file.open(filename.c_str(), std::ios::app);
+  if (!file.is_open())
+    {
+      std::cout << "unable to open telemetry file " << filename << "\n";
+      return;
+    }
+  file << "# iteration elapsed(s) iterations/s mean variance lower total"
+       << std::endl;
+
+  writer = std::thread(&Telemetry::WriterLoop, this);
+}
+
+/* Queues one record for the writer thread.  Takes the queue lock only
+ * long enough to append, never waits on the file. */
+void Telemetry::Record(unsigned long long iteration, Type mean,
+		       Type variance, Type lowerIndex, Type totalIndex)
+{
+  if (!file.is_open())
+    {
+      return;
+    }
+
+  TelemetryRecord record;
+  record.iteration = iteration;
+  record.elapsed = Elapsed();
+  record.mean = mean;
+  record.variance = variance;
+  record.lowerIndex = lowerIndex;
+  record.totalIndex = totalIndex;
+
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    pending.push_back(record);
+  }
+  recordAvailable.notify_one();
+}
+
+/* Takes all queued records at once and writes them outside the lock */
+void Telemetry::WriterLoop()
+{
+  std::vector<TelemetryRecord> batch;
+  for (;;)
+    {
+      {
+	std::unique_lock<std::mutex> lock(queueMutex);
+	recordAvailable.wait(lock, [this]
+			     {
+			       return stopping || !pending.empty();
+			     });
+	if (pending.empty())
+	  {
+	    return;
+	  }
+	batch.swap(pending);
+      }
+
+      for (const auto& r : batch)
+	{
+	  file << r.iteration << " " << r.elapsed << " "
+	       << (r.elapsed > 0 ? r.iteration/r.elapsed : 0) << " "
+	       << r.mean << " " << r.variance << " " << r.lowerIndex << " "
+	       << r.totalIndex << "\n";
+	}
+      file.flush();
+      batch.clear();
+    }
+}
+
+/* Writes the records still queued, then stops the writer thread */
+Telemetry::~Telemetry()
+{
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    stopping = true;
+  }
+  recordAvailable.notify_one();
+  if (writer.joinable())
+    {
+      writer.join();
+    }
+}
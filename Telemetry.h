@@ -0,0 +1,59 @@
+/* Class Telemetry streams running estimates of a long computation to an
+ * append-only text file, one line per record:
+ *
+ *   <iteration> <elapsed s> <iterations/s> <mean> <variance> <lower>
+ *   <total>
+ *
+ * The computing thread only queues records; a background thread does
+ * the file I/O and flushes after every batch, so the file can be
+ * followed with tail -f while the run is in progress.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef double Type;
+
+/* running estimates after some number of iterations */
+struct TelemetryRecord
+{
+  unsigned long long iteration;  /* iterations done so far */
+  Type elapsed;  /* seconds since the Telemetry object was made */
+  Type mean, variance;  /* running model mean and variance */
+  Type lowerIndex, totalIndex;  /* running non-normalized indices */
+};
+
+class Telemetry
+{
+ private:
+  std::ofstream file;
+  std::vector<TelemetryRecord> pending;  /* records not yet written */
+  std::mutex queueMutex;  /* guards pending and stopping */
+  std::condition_variable recordAvailable;
+  bool stopping;  /* true once the dtor has been entered */
+  std::thread writer;
+  std::chrono::steady_clock::time_point start;
+
+  void WriterLoop();
+
+ public:
+  Telemetry(const std::string &filename);
+  bool IsOpen() {return file.is_open();}
+  Type Elapsed() const
+  {
+    return std::chrono::duration<Type>
+      (std::chrono::steady_clock::now() - start).count();
+  }
+  void Record(unsigned long long iteration, Type mean, Type variance,
+	      Type lowerIndex, Type totalIndex);
+  ~Telemetry();
+};
+#endif
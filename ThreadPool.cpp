@@ -0,0 +1,98 @@
+#include "ThreadPool.h"
+
+/* Ctor
+ * Input:
+ *
+ * numThreads_ = number of worker threads to start.  Zero (default)
+ *   uses the number of hardware threads.
+ */
+ThreadPool::ThreadPool(unsigned int numThreads_)
+{
+  active = 0;
+  stopping = false;
+
+  unsigned int numThreads = numThreads_;
+  if (numThreads == 0)
+    {
+      numThreads = std::thread::hardware_concurrency();
+    }
+  if (numThreads == 0)
+    {
+      numThreads = 1;
+    }
+
+  for (unsigned int i = 0; i < numThreads; ++i)
+    {
+      workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+    }
+}
+
+/* Adds a task to the queue.  The task runs on the first idle worker. */
+void ThreadPool::Enqueue(const std::function<void()> &task)
+{
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    tasks.push(task);
+  }
+  taskAvailable.notify_one();
+}
+
+/* Blocks until the queue is empty and no task is running. */
+void ThreadPool::Wait()
+{
+  std::unique_lock<std::mutex> lock(queueMutex);
+  while (!tasks.empty() || active > 0)
+    {
+      allFinished.wait(lock);
+    }
+}
+
+/* Loop run by each worker: pop a task, run it, repeat until the pool
+ * is destroyed and the queue has drained. */
+void ThreadPool::WorkerLoop()
+{
+  for (;;)
+    {
+      std::function<void()> task;
+      {
+	std::unique_lock<std::mutex> lock(queueMutex);
+	while (!stopping && tasks.empty())
+	  {
+	    taskAvailable.wait(lock);
+	  }
+	if (tasks.empty())
+	  {
+	    return;  /* stopping and nothing left to do */
+	  }
+	task = tasks.front();
+	tasks.pop();
+	++active;
+      }
+
+      task();
+
+      {
+	std::lock_guard<std::mutex> lock(queueMutex);
+	--active;
+	if (tasks.empty() && active == 0)
+	  {
+	    allFinished.notify_all();
+	  }
+      }
+    }
+}
+
+/* Dtor finishes all queued tasks before joining the workers. */
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    stopping = true;
+  }
+  taskAvailable.notify_all();
+
+  for (auto& worker : workers)
+    {
+      worker.join();
+    }
+}
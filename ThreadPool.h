@@ -0,0 +1,37 @@
+/* Class ThreadPool keeps a fixed set of worker threads alive and runs
+ * queued tasks on them.  Used wherever independent Sobol' index
+ * computations can proceed concurrently, e.g. separate jobs in the
+ * sensitivity-analysis server.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class ThreadPool
+{
+ private:
+  std::vector<std::thread> workers;  /* worker threads */
+  std::queue<std::function<void()> > tasks;  /* pending tasks */
+  std::mutex queueMutex;  /* guards tasks, active and stopping */
+  std::condition_variable taskAvailable;  /* signalled on Enqueue */
+  std::condition_variable allFinished;  /* signalled when idle */
+  unsigned int active;  /* number of tasks currently running */
+  bool stopping;  /* true once the dtor has been entered */
+
+  void WorkerLoop();
+
+ public:
+  ThreadPool(unsigned int numThreads_ = 0);
+  void Enqueue(const std::function<void()> &task);
+  void Wait();
+  unsigned int GetNumThreads() {return workers.size();}
+  ~ThreadPool();
+};
+#endif
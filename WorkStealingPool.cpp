@@ -0,0 +1,254 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+
+/* pool and worker index of the calling thread, NULL and 0 outside any
+ * pool */
+static thread_local WorkStealingPool *currentPool = NULL;
+static thread_local unsigned int currentWorker = 0;
+/* nesting depth of the task the calling thread runs, 0 outside tasks */
+static thread_local unsigned int currentLevel = 0;
+
+/* Ctor
+ * Input:
+ *
+ * numThreads_ = number of worker threads to start.  Zero (default)
+ *   uses the number of hardware threads.
+ */
+WorkStealingPool::WorkStealingPool(unsigned int numThreads_)
+  : queued(0), pushes(0)
+{
+  stopping = false;
+
+  unsigned int numThreads = numThreads_;
+  if (numThreads == 0)
+    {
+      numThreads = std::thread::hardware_concurrency();
+    }
+  if (numThreads == 0)
+    {
+      numThreads = 1;
+    }
+
+  for (unsigned int w = 0; w < numThreads; ++w)
+    {
+      queues.push_back(new WorkerQueue);
+    }
+  for (unsigned int w = 0; w < numThreads; ++w)
+    {
+      workers.push_back(std::thread(&WorkStealingPool::WorkerLoop, this,
+				    w));
+    }
+}
+
+/* Runs body(0), ..., body(n-1) on the pool and the calling thread, and
+ * returns when all of them have finished.  The calls may run in any
+ * order and concurrently. */
+void WorkStealingPool::ParallelFor(size_t n,
+				   const std::function<void(size_t)> &body)
+{
+  if (n == 0)
+    {
+      return;
+    }
+
+  std::atomic<size_t> pending(n);
+  std::vector<WorkStealingTask> tasks(n);
+  for (size_t i = 0; i < n; ++i)
+    {
+      tasks[i].body = &body;
+      tasks[i].index = i;
+      tasks[i].pending = &pending;
+      tasks[i].level = currentLevel + 1;
+    }
+
+  bool inPool = (currentPool == this);
+  if (inPool)
+    {
+      /* pushed in reverse, so the owner works through them in order
+       * and thieves take the far end */
+      std::reverse(tasks.begin(), tasks.end());
+      Push(currentWorker, &tasks[0], n);
+    }
+  else
+    {
+      /* contiguous slices, one per worker */
+      size_t numQueues = queues.size();
+      for (size_t w = 0; w < numQueues; ++w)
+	{
+	  size_t begin = n*w/numQueues, end = n*(w + 1)/numQueues;
+	  std::reverse(tasks.begin() + begin, tasks.begin() + end);
+	  Push(w, &tasks[begin], end - begin);
+	}
+    }
+
+  /* help until every task of this loop has finished, with tasks of
+   * this or deeper loops only: running a sibling of the task that
+   * called us could nest without bound */
+  unsigned int minLevel = currentLevel + 1;
+  while (pending.load(std::memory_order_acquire) > 0)
+    {
+      unsigned long long seen = pushes.load();
+
+      WorkStealingTask task;
+      if ((inPool && PopOwn(currentWorker, minLevel, task))
+	  || Steal(inPool ? currentWorker : queues.size(), minLevel, task))
+	{
+	  Run(task);
+	  continue;
+	}
+
+      /* nothing to take: the rest of the loop runs on other threads,
+       * which may queue nested tasks we can help with */
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      while (pending.load(std::memory_order_acquire) > 0
+	     && pushes.load() == seen)
+	{
+	  helpers.wait(lock);
+	}
+    }
+}
+
+/* Appends n tasks to the back of deque w and wakes sleeping workers */
+void WorkStealingPool::Push(unsigned int w, const WorkStealingTask *tasks,
+			    size_t n)
+{
+  if (n == 0)
+    {
+      return;
+    }
+  /* counted first, so that a thief never takes queued below zero */
+  queued.fetch_add(n);
+  {
+    std::lock_guard<std::mutex> lock(queues[w]->mutex);
+    queues[w]->tasks.insert(queues[w]->tasks.end(), tasks, tasks + n);
+  }
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    ++pushes;
+  }
+  wake.notify_all();
+  helpers.notify_all();
+}
+
+/* Takes the newest task of worker w's own deque if its level is at
+ * least minLevel */
+bool WorkStealingPool::PopOwn(unsigned int w, unsigned int minLevel,
+			      WorkStealingTask &task)
+{
+  std::lock_guard<std::mutex> lock(queues[w]->mutex);
+  if (queues[w]->tasks.empty()
+      || queues[w]->tasks.back().level < minLevel)
+    {
+      return false;
+    }
+  task = queues[w]->tasks.back();
+  queues[w]->tasks.pop_back();
+  queued.fetch_sub(1);
+  return true;
+}
+
+/* Takes the oldest task of another deque, trying the workers after
+ * thief in turn; thief = number of workers for a thread outside the
+ * pool.  If the oldest task is below minLevel, the newest one is taken
+ * instead when it is deep enough. */
+bool WorkStealingPool::Steal(unsigned int thief, unsigned int minLevel,
+			     WorkStealingTask &task)
+{
+  size_t numQueues = queues.size();
+  for (size_t k = 1; k <= numQueues; ++k)
+    {
+      size_t victim = (thief + k) % numQueues;
+      if (victim == thief)
+	{
+	  continue;
+	}
+      std::lock_guard<std::mutex> lock(queues[victim]->mutex);
+      std::deque<WorkStealingTask> &tasks = queues[victim]->tasks;
+      if (tasks.empty())
+	{
+	  continue;
+	}
+      if (tasks.front().level >= minLevel)
+	{
+	  task = tasks.front();
+	  tasks.pop_front();
+	}
+      else if (tasks.back().level >= minLevel)
+	{
+	  task = tasks.back();
+	  tasks.pop_back();
+	}
+      else
+	{
+	  continue;
+	}
+      queued.fetch_sub(1);
+      return true;
+    }
+  return false;
+}
+
+void WorkStealingPool::Run(const WorkStealingTask &task)
+{
+  unsigned int level = currentLevel;
+  currentLevel = task.level;
+  (*task.body)(task.index);
+  currentLevel = level;
+  /* the last task of a loop wakes its caller; pending may be gone
+   * once it reads zero */
+  if (task.pending->fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      {
+	std::lock_guard<std::mutex> lock(sleepMutex);
+      }
+      helpers.notify_all();
+    }
+}
+
+/* Loop run by each worker: run own tasks, else stolen ones, else sleep
+ * until tasks are queued or the pool is destroyed. */
+void WorkStealingPool::WorkerLoop(unsigned int w)
+{
+  currentPool = this;
+  currentWorker = w;
+
+  for (;;)
+    {
+      WorkStealingTask task;
+      if (PopOwn(w, 0, task) || Steal(w, 0, task))
+	{
+	  Run(task);
+	  continue;
+	}
+
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      while (!stopping && queued.load() == 0)
+	{
+	  wake.wait(lock);
+	}
+      if (stopping && queued.load() == 0)
+	{
+	  return;
+	}
+    }
+}
+
+/* Dtor joins the workers; every ParallelFor() has returned by then, so
+ * no task is left. */
+WorkStealingPool::~WorkStealingPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+  wake.notify_all();
+
+  for (auto& worker : workers)
+    {
+      worker.join();
+    }
+  for (auto& queue : queues)
+    {
+      delete queue;
+    }
+}
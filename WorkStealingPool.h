@@ -0,0 +1,84 @@
+/* Class WorkStealingPool runs parallel loops of small tasks whose costs
+ * differ a lot, e.g. blocks of MC runs of a model that is slow in some
+ * regions of parameter space.  Each worker has its own deque: it takes
+ * its newest task from the back, and a worker whose deque is empty
+ * steals the oldest task from the front of another's.  Idle threads
+ * therefore pick up whatever is left instead of waiting for a thread
+ * that drew the expensive part of a static split.
+ *
+ * ParallelFor() may be called from inside a task (nested loops, like
+ * the inner Sobol' runs of a Super Sobol iteration): the new tasks go to
+ * the calling worker's deque, and while it waits for them the caller
+ * runs tasks itself; it sleeps only when none it may take is queued,
+ * until more are queued or its loop has finished.  A waiting caller
+ * only takes tasks nested deeper than the one it is running, which
+ * bounds the stack by the number of loop levels.  A caller outside the
+ * pool spreads the tasks over all deques and helps as well.
+ *
+ * Tasks only get an index, and finish in any order.  A result that
+ * must not depend on the thread count is either combined exactly, so
+ * that the order does not matter (SobolIndices merges the ExactSum
+ * based SobolAccumulator of each block as it finishes), or written by
+ * task i to slot i and the slots combined in index order afterwards.
+ */
+
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* one task: call of body with index; pending counts the unfinished
+ * tasks of its ParallelFor(), level is its nesting depth (1 for loops
+ * started outside any task) */
+struct WorkStealingTask
+{
+  const std::function<void(size_t)> *body;
+  size_t index;
+  std::atomic<size_t> *pending;
+  unsigned int level;
+};
+
+class WorkStealingPool
+{
+ private:
+  /* deque of one worker, guarded by its own mutex */
+  struct WorkerQueue
+  {
+    std::mutex mutex;
+    std::deque<WorkStealingTask> tasks;
+  };
+
+  std::vector<WorkerQueue*> queues;  /* one per worker */
+  std::vector<std::thread> workers;
+  std::atomic<size_t> queued;  /* tasks in all deques */
+  std::mutex sleepMutex;  /* guards stopping, and changes of pushes */
+  std::condition_variable wake;  /* signalled when tasks are queued */
+  /* signalled when tasks are queued or a loop has finished, for
+   * ParallelFor() callers with nothing to help with */
+  std::condition_variable helpers;
+  std::atomic<unsigned long long> pushes;  /* Push() calls so far */
+  bool stopping;
+
+  void WorkerLoop(unsigned int w);
+  bool PopOwn(unsigned int w, unsigned int minLevel,
+	      WorkStealingTask &task);
+  bool Steal(unsigned int thief, unsigned int minLevel,
+	     WorkStealingTask &task);
+  void Push(unsigned int w, const WorkStealingTask *tasks, size_t n);
+  void Run(const WorkStealingTask &task);
+
+ public:
+  WorkStealingPool(unsigned int numThreads_ = 0);
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+  void ParallelFor(size_t n, const std::function<void(size_t)> &body);
+  unsigned int GetNumThreads() {return workers.size();}
+  ~WorkStealingPool();
+};
+#endif
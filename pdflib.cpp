@@ -12,6 +12,7 @@ using namespace std;
 //# include "pdflib.hpp"
 # include "pdflib.h"
 # include "rnglib.h"
+# include "Philox.h"
 
 //****************************************************************************80
 
@@ -570,6 +571,71 @@ int *i4vec_multinomial_sample ( int n, double p[], int ncat )
 }
 //****************************************************************************80
 
+void r8_beta_fill ( double aa, double bb, int n, double x[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    R8_BETA_FILL fills an array with samples of the beta distribution.
+//
+//  Discussion:
+//
+//    Each value is G1 / ( G1 + G2 ), where G1 and G2 are gamma variates
+//    of shape AA and BB from R8_GAMMA_01_FILL.  The rejection steps
+//    therefore run in batches, as described there.
+//
+//  Parameters:
+//
+//    Input, double AA, BB, the parameters of the distribution.
+//    0.0 < AA, 0.0 < BB.
+//
+//    Input, int N, the number of samples.
+//
+//    Output, double X[N], the samples.
+//
+{
+  const int chunk = 256;
+  int i;
+  int j;
+  int m;
+  double y[chunk];
+
+  if ( aa <= 0.0 )
+  {
+    cerr << "\n";
+    cerr << "R8_BETA_FILL - Fatal error!\n";
+    cerr << "  AA <= 0.0\n";
+    exit ( 1 );
+  }
+
+  if ( bb <= 0.0 )
+  {
+    cerr << "\n";
+    cerr << "R8_BETA_FILL - Fatal error!\n";
+    cerr << "  BB <= 0.0\n";
+    exit ( 1 );
+  }
+
+  for ( j = 0; j < n; j = j + m )
+  {
+    m = n - j;
+    if ( chunk < m )
+    {
+      m = chunk;
+    }
+    r8_gamma_01_fill ( aa, m, x + j );
+    r8_gamma_01_fill ( bb, m, y );
+    for ( i = 0; i < m; i++ )
+    {
+      x[j+i] = x[j+i] / ( x[j+i] + y[i] );
+    }
+  }
+
+  return;
+}
+//****************************************************************************80
+
 double r8_beta_pdf ( double alpha, double beta, double rval )
 
 //****************************************************************************80
@@ -1090,6 +1156,40 @@ double r8_epsilon ( )
 }
 //****************************************************************************80
 
+void r8_exponential_fill ( double lambda, int n, double x[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    R8_EXPONENTIAL_FILL fills an array with exponential samples.
+//
+//  Discussion:
+//
+//    Each value is distributed as R8_EXPONENTIAL_SAMPLE ( LAMBDA ).
+//
+//  Parameters:
+//
+//    Input, double LAMBDA, the parameter of the PDF.
+//
+//    Input, int N, the number of samples.
+//
+//    Output, double X[N], the samples.
+//
+{
+  int i;
+
+  r8_exponential_01_fill ( n, x );
+
+  for ( i = 0; i < n; i++ )
+  {
+    x[i] = x[i] * lambda;
+  }
+
+  return;
+}
+//****************************************************************************80
+
 double r8_exponential_pdf ( double beta, double rval )
 
 //****************************************************************************80
@@ -1187,6 +1287,39 @@ double r8_exponential_sample ( double lambda )
 }
 //****************************************************************************80
 
+void r8_exponential_01_fill ( int n, double x[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    R8_EXPONENTIAL_01_FILL fills an array with standard exponential samples.
+//
+//  Discussion:
+//
+//    The uniforms are drawn all at once, and the logarithms are taken
+//    in a separate loop, which the compiler can vectorize.
+//
+//  Parameters:
+//
+//    Input, int N, the number of samples.
+//
+//    Output, double X[N], the samples.
+//
+{
+  int i;
+
+  r8_uniform_01_fill ( n, x );
+
+  for ( i = 0; i < n; i++ )
+  {
+    x[i] = - log ( x[i] );
+  }
+
+  return;
+}
+//****************************************************************************80
+
 double r8_exponential_01_pdf ( double rval )
 
 //****************************************************************************80
@@ -1514,6 +1647,44 @@ double r8_gamma_log ( double x )
 }
 //****************************************************************************80
 
+void r8_gamma_fill ( double a, double r, int n, double x[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    R8_GAMMA_FILL fills an array with samples of a Gamma PDF.
+//
+//  Discussion:
+//
+//    Each value is distributed as R8_GAMMA_SAMPLE ( A, R ).
+//
+//  Parameters:
+//
+//    Input, double A, the rate parameter.
+//    A nonzero.
+//
+//    Input, double R, the shape parameter.
+//    0.0 < R.
+//
+//    Input, int N, the number of samples.
+//
+//    Output, double X[N], the samples.
+//
+{
+  int i;
+
+  r8_gamma_01_fill ( r, n, x );
+
+  for ( i = 0; i < n; i++ )
+  {
+    x[i] = x[i] / a;
+  }
+
+  return;
+}
+//****************************************************************************80
+
 double r8_gamma_pdf ( double beta, double alpha, double rval )
 
 //****************************************************************************80
@@ -1639,6 +1810,127 @@ double r8_gamma_sample ( double a, double r )
 }
 //****************************************************************************80
 
+void r8_gamma_01_fill ( double a, int n, double x[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    R8_GAMMA_01_FILL fills an array with samples of the standard Gamma PDF.
+//
+//  Discussion:
+//
+//    For 1 <= A this is the rejection method of Marsaglia and Tsang,
+//    run in rounds: a round proposes one candidate for every value still
+//    missing (at most CHUNK at a time), evaluates the acceptance test of
+//    all candidates in one loop, and then compacts the accepted ones to
+//    the end of the filled part of X.  More than 95 percent of the
+//    candidates are accepted, so a few rounds fill the array.
+//
+//    For A < 1, a sample G of shape A + 1 is scaled by U^(1/A), with U
+//    uniform.
+//
+//    The method differs from that of R8_GAMMA_01_SAMPLE, so the values
+//    differ from those of repeated calls, but the distribution is the same.
+//
+//  Reference:
+//
+//    George Marsaglia, Wai Wan Tsang,
+//    A Simple Method for Generating Gamma Variables,
+//    ACM Transactions on Mathematical Software,
+//    Volume 26, Number 3, September 2000, pages 363-372.
+//
+//  Parameters:
+//
+//    Input, double A, the shape parameter.
+//    0.0 < A.
+//
+//    Input, int N, the number of samples.
+//
+//    Output, double X[N], the samples.
+//
+{
+  const int chunk = 256;
+  double c;
+  double d;
+  int filled;
+  int i;
+  int j;
+  int m;
+  double u[chunk];
+  double v[chunk];
+  double z[chunk];
+
+  if ( a <= 0.0 )
+  {
+    cerr << "\n";
+    cerr << "R8_GAMMA_01_FILL - Fatal error!\n";
+    cerr << "  A <= 0.0\n";
+    exit ( 1 );
+  }
+
+  if ( a < 1.0 )
+  {
+    r8_gamma_01_fill ( a + 1.0, n, x );
+
+    for ( j = 0; j < n; j = j + m )
+    {
+      m = n - j;
+      if ( chunk < m )
+      {
+        m = chunk;
+      }
+      r8_uniform_01_fill ( m, u );
+      for ( i = 0; i < m; i++ )
+      {
+        x[j+i] = x[j+i] * exp ( log ( u[i] ) / a );
+      }
+    }
+    return;
+  }
+
+  d = a - 1.0 / 3.0;
+  c = 1.0 / sqrt ( 9.0 * d );
+
+  filled = 0;
+
+  while ( filled < n )
+  {
+    m = n - filled;
+    if ( chunk < m )
+    {
+      m = chunk;
+    }
+//
+//  Propose M candidates D * V, V = ( 1 + C * Z )^3.
+//
+    r8_normal_01_fill ( m, z );
+    r8_uniform_01_fill ( m, u );
+
+    for ( i = 0; i < m; i++ )
+    {
+      v[i] = 1.0 + c * z[i];
+      v[i] = v[i] * v[i] * v[i];
+    }
+//
+//  Accept where 0 < V and log ( U ) < Z^2/2 + D - D * V + D * log ( V ),
+//  keeping the accepted values in order.
+//
+    for ( i = 0; i < m; i++ )
+    {
+      if ( 0.0 < v[i] && 
+        log ( u[i] ) < 0.5 * z[i] * z[i] + d - d * v[i] + d * log ( v[i] ) )
+      {
+        x[filled] = d * v[i];
+        filled = filled + 1;
+      }
+    }
+  }
+
+  return;
+}
+//****************************************************************************80
+
 double r8_gamma_01_pdf ( double alpha, double rval )
 
 //****************************************************************************80
@@ -2069,6 +2361,47 @@ double r8_invchi_sample ( double df )
 }
 //****************************************************************************80
 
+void r8_invgam_fill ( double beta, double alpha, int n, double x[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    R8_INVGAM_FILL fills an array with samples of an inverse gamma PDF.
+//
+//  Discussion:
+//
+//    Each value is distributed as R8_INVGAM_SAMPLE ( BETA, ALPHA ).
+//
+//  Parameters:
+//
+//    Input, double BETA, the rate parameter.
+//    0.0 < BETA.
+//
+//    Input, double ALPHA, the shape parameter.
+//    0.0 < ALPHA.
+//
+//    Input, int N, the number of samples.
+//
+//    Output, double X[N], the samples.
+//
+{
+  int i;
+
+  r8_gamma_fill ( beta, alpha, n, x );
+
+  for ( i = 0; i < n; i++ )
+  {
+    if ( x[i] != 0.0 )
+    {
+      x[i] = 1.0 / x[i];
+    }
+  }
+
+  return;
+}
+//****************************************************************************80
+
 double r8_invgam_pdf ( double beta, double alpha, double rval )
 
 //****************************************************************************80
@@ -2262,6 +2595,36 @@ double r8_min ( double x, double y )
 }
 //****************************************************************************80
 
+void r8_normal_fill ( double av, double sd, int n, double x[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    R8_NORMAL_FILL fills an array with samples of the normal PDF.
+//
+//  Parameters:
+//
+//    Input, double AV, SD, the mean and standard deviation of the PDF.
+//
+//    Input, int N, the number of samples.
+//
+//    Output, double X[N], the samples.
+//
+{
+  int i;
+
+  r8_normal_01_fill ( n, x );
+
+  for ( i = 0; i < n; i++ )
+  {
+    x[i] = av + sd * x[i];
+  }
+
+  return;
+}
+//****************************************************************************80
+
 double r8_normal_pdf ( double av, double sd, double rval )
 
 //****************************************************************************80
@@ -2366,6 +2729,88 @@ double r8_normal_sample ( double av, double sd )
 }
 //****************************************************************************80
 
+void r8_normal_01_fill ( int n, double x[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    R8_NORMAL_01_FILL fills an array with samples of the standard normal PDF.
+//
+//  Discussion:
+//
+//    This is the Box-Muller method of R8_NORMAL_01_SAMPLE, but each pair
+//    of uniforms gives two values, R cos ( T ) and R sin ( T ), where the
+//    scalar version keeps only the first.  The uniforms of a chunk are
+//    drawn at once, and the radii, angles and outputs are computed in
+//    separate loops with no calls between them, which the compiler can
+//    vectorize.
+//
+//  Parameters:
+//
+//    Input, int N, the number of samples.
+//
+//    Output, double X[N], the samples.
+//
+{
+  const int chunk = 256;
+  int i;
+  int j;
+  int m;
+  const double pi = 3.14159265358979323;
+  double r[chunk];
+  double t[chunk];
+  double u[2*chunk];
+
+  for ( j = 0; j < n; j = j + 2 * m )
+  {
+//
+//  M pairs give the next 2 * M values, or 2 * M - 1 at the end.
+//
+    m = ( n - j + 1 ) / 2;
+    if ( chunk < m )
+    {
+      m = chunk;
+    }
+    r8_uniform_01_fill ( 2 * m, u );
+
+    for ( i = 0; i < m; i++ )
+    {
+      r[i] = sqrt ( -2.0 * log ( u[i] ) );
+    }
+    for ( i = 0; i < m; i++ )
+    {
+      t[i] = 2.0 * pi * u[m+i];
+    }
+//
+//  Both values of a pair in one loop, so that one SINCOS call serves
+//  them; the sine of the last pair is dropped when N is odd.
+//
+    if ( j + 2 * m <= n )
+    {
+      for ( i = 0; i < m; i++ )
+      {
+        x[j+i] = r[i] * cos ( t[i] );
+        x[j+m+i] = r[i] * sin ( t[i] );
+      }
+    }
+    else
+    {
+      for ( i = 0; i < m; i++ )
+      {
+        x[j+i] = r[i] * cos ( t[i] );
+      }
+      for ( i = 0; i < m - 1; i++ )
+      {
+        x[j+m+i] = r[i] * sin ( t[i] );
+      }
+    }
+  }
+
+  return;
+}
+//****************************************************************************80
+
 double r8_normal_01_pdf ( double rval )
 
 //****************************************************************************80
@@ -2577,6 +3022,36 @@ double r8_scinvchi_sample ( double df, double s )
 }
 //****************************************************************************80
 
+void r8_uniform_fill ( double low, double high, int n, double x[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    R8_UNIFORM_FILL fills an array with uniform random deviates.
+//
+//  Parameters:
+//
+//    Input, double LOW, HIGH, the lower and upper bounds.
+//
+//    Input, int N, the number of samples.
+//
+//    Output, double X[N], the samples.
+//
+{
+  int i;
+
+  r8_uniform_01_fill ( n, x );
+
+  for ( i = 0; i < n; i++ )
+  {
+    x[i] = low + ( high - low ) * x[i];
+  }
+
+  return;
+}
+//****************************************************************************80
+
 double r8_uniform_pdf ( double lower, double upper, double rval )
 
 //****************************************************************************80
@@ -2677,6 +3152,62 @@ double r8_uniform_sample ( double low, double high )
 }
 //****************************************************************************80
 
+void r8_uniform_01_fill ( int n, double x[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    R8_UNIFORM_01_FILL fills an array with random deviates on [0,1].
+//
+//  Discussion:
+//
+//    This is the bulk form of R8_UNIFORM_01_SAMPLE.  Every other _FILL
+//    function draws its uniforms here, a whole block at once.
+//
+//    With OPTION 0 the values come from R8VEC_UNI_01 of RNGLIB, which
+//    updates the generator state once for the array, or fills it from
+//    the calling thread's RngStream.  OPTION is 0 while
+//    THREAD_STREAMS_GET ( ) is TRUE and 1 otherwise.
+//
+//    With OPTION 1 two calls of "rand()" give the key of a Philox
+//    generator, which then fills the array.  SRAND still fixes the
+//    values, but the lock inside "rand()" is taken twice per call
+//    instead of once per value.  The values are not those of N calls of
+//    R8_UNIFORM_01_SAMPLE, and lie in (0,1).
+//
+//  Parameters:
+//
+//    Input, int N, the number of samples.
+//
+//    Output, double X[N], the samples.
+//
+{
+  const int option = thread_streams_get ( ) ? 0 : 1;
+
+  if ( option == 0 )
+  {
+    r8vec_uni_01 ( n, x );
+  }
+  else
+  {
+    uint64_t key = ( uint64_t ) rand ( ) << 31;
+    key = key ^ ( uint64_t ) rand ( );
+    Philox philox ( key );
+//
+//  Rows of two doubles use both words of every Philox block.
+//
+    philox.Fill ( 0, n / 2, 2, x );
+    if ( n % 2 == 1 )
+    {
+      x[n-1] = philox.Uniform ( n / 2, 0 );
+    }
+  }
+
+  return;
+}
+//****************************************************************************80
+
 double r8_uniform_01_pdf ( double rval )
 
 //****************************************************************************80
@@ -2744,6 +3275,10 @@ double r8_uniform_01_sample ( )
 //    Setting OPTION to 1 in the C++ version calls the system
 //    random number generator "rand()".
 //
+//    OPTION is 0 while THREAD_STREAMS_GET ( ) is TRUE, so that every
+//    sampler of the package draws from the calling thread's RngStream
+//    and none of them touches the global state of "rand()".
+//
 //  Licensing:
 //
 //    This code is distributed under the GNU LGPL license.
@@ -2761,7 +3296,7 @@ double r8_uniform_01_sample ( )
 //    Output, double R8_UNIFORM_01_SAMPLE, a random deviate.
 //
 {
-  const int option = 1;
+  const int option = thread_streams_get ( ) ? 0 : 1;
   double value;
 
   if ( option == 0 )
@@ -3308,6 +3843,62 @@ double r8vec_dot_product ( int n, double a1[], double a2[] )
 }
 //****************************************************************************80
 
+void r8vec_multinormal_fill ( int n, double mu[], double r[], int m, 
+  double x[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    R8VEC_MULTINORMAL_FILL fills an array with multivariate normal samples.
+//
+//  Discussion:
+//
+//    Each sample is distributed as R8VEC_MULTINORMAL_SAMPLE ( N, MU, R ).
+//    The N*M standard normals are drawn by one call of R8_NORMAL_01_FILL
+//    into X, and each sample is then replaced by MU + R' * Z in place,
+//    from the last component down, so no work arrays are needed.
+//
+//  Parameters:
+//
+//    Input, int N, the spatial dimension.
+//
+//    Input, double MU[N], the mean vector.
+//
+//    Input, double R[N*N], the upper triangular Cholesky
+//    factor of the covariance matrix C.
+//
+//    Input, int M, the number of samples.
+//
+//    Output, double X[N*M], the samples; sample K is X[K*N...K*N+N-1].
+//
+{
+  int i;
+  int j;
+  int k;
+  double s;
+  double *z;
+
+  r8_normal_01_fill ( n * m, x );
+
+  for ( k = 0; k < m; k++ )
+  {
+    z = x + k * n;
+    for ( i = n - 1; 0 <= i; i-- )
+    {
+      s = mu[i];
+      for ( j = 0; j <= i; j++ )
+      {
+        s = s + r[j+i*n] * z[j];
+      }
+      z[i] = s;
+    }
+  }
+
+  return;
+}
+//****************************************************************************80
+
 double r8vec_multinormal_pdf ( int n, double mu[], double r[], double c_det, 
   double x[] )
 
@@ -3,35 +3,45 @@ double i4_binomial_pdf ( int n, double p, int k );
 int i4_binomial_sample ( int n, double pp );
 double i4vec_multinomial_pdf ( int n, double p[], int m, int x[] );
 int *i4vec_multinomial_sample ( int n, double p[], int ncat );
+void r8_beta_fill ( double aa, double bb, int n, double x[] );
 double r8_beta_pdf ( double alpha, double beta, double rval );
 double r8_beta_sample ( double aa, double bb );
 double r8_chi_pdf ( double df, double rval );
 double r8_chi_sample ( double df );
 double r8_choose ( int n, int k );
 double r8_epsilon ( void );
+void r8_exponential_fill ( double lambda, int n, double x[] );
 double r8_exponential_pdf ( double beta, double rval );
 double r8_exponential_sample ( double lambda );
+void r8_exponential_01_fill ( int n, double x[] );
 double r8_exponential_01_pdf ( double rval );
 double r8_exponential_01_sample ( );
 double r8_gamma_log ( double x );
+void r8_gamma_fill ( double a, double r, int n, double x[] );
 double r8_gamma_pdf ( double beta, double alpha, double rval );
 double r8_gamma_sample ( double a, double r );
+void r8_gamma_01_fill ( double a, int n, double x[] );
 double r8_gamma_01_pdf ( double alpha, double rval );
 double r8_gamma_01_sample ( double a );
 double r8_invchi_pdf ( double df, double rval );
 double r8_invchi_sample ( double df );
+void r8_invgam_fill ( double beta, double alpha, int n, double x[] );
 double r8_invgam_pdf ( double beta, double alpha, double rval );
 double r8_invgam_sample ( double beta, double alpha );
 double r8_max ( double x, double y );
 double r8_min ( double x, double y );
+void r8_normal_fill ( double av, double sd, int n, double x[] );
 double r8_normal_pdf ( double av, double sd, double rval );
 double r8_normal_sample ( double av, double sd );
+void r8_normal_01_fill ( int n, double x[] );
 double r8_normal_01_pdf ( double rval );
 double r8_normal_01_sample ( );
 double r8_scinvchi_pdf ( double df, double s, double rval );
 double r8_scinvchi_sample ( double df, double s );
+void r8_uniform_fill ( double low, double high, int n, double x[] );
 double r8_uniform_pdf ( double lower, double upper, double rval );
 double r8_uniform_sample ( double low, double high );
+void r8_uniform_01_fill ( int n, double x[] );
 double r8_uniform_01_pdf ( double rval );
 double r8_uniform_01_sample ( void );
 double *r8mat_mtv_new ( int m, int n, double a[], double x[] );
@@ -42,6 +52,8 @@ double *r8mat_poinv ( int n, double r[] );
 double *r8mat_upsol ( int n, double r[], double b[] );
 double *r8mat_utsol ( int n, double r[], double b[] );
 double r8vec_dot_product ( int n, double a1[], double a2[] );
+void r8vec_multinormal_fill ( int n, double mu[], double r[], int m, 
+  double x[] );
 double r8vec_multinormal_pdf ( int n, double mu[], double r[], double c_det, 
   double x[] );
 double *r8vec_multinormal_sample ( int n, double mu[], double r[] );
@@ -2,10 +2,18 @@
 # include <iostream>
 # include <iomanip>
 # include <ctime>
+# include <atomic>
 
 using namespace std;
 
 # include "rnglib.h"
+# include "RngStream.h"
+
+//
+//  True if the uniforms come from the calling thread's RngStream,
+//  see THREAD_STREAMS_SET.
+//
+static atomic<bool> thread_streams_flag ( false );
 
 //****************************************************************************80
 
@@ -85,7 +93,7 @@ void advance_state ( int k )
   b1 = a1;
   b2 = a2;
 
-  for ( i = 1; i <= k; k++ )
+  for ( i = 1; i <= k; i++ )
   {
     b1 = multmod ( b1, b1, m1 );
     b2 = multmod ( b2, b2, m2 );
@@ -622,6 +630,13 @@ int i4_uni ( )
   bool value;
   int z;
 //
+//  Use the thread-local stream if requested.
+//
+  if ( thread_streams_flag.load ( memory_order_relaxed ) )
+  {
+    return RngStream::Local ( ).i4_uni ( );
+  }
+//
 //  Check whether the package must be initialized.
 //
   if ( ! initialized_get ( ) )
@@ -1483,6 +1498,13 @@ float r4_uni_01 ( )
   int i;
   float value;
 //
+//  Use the thread-local stream if requested.
+//
+  if ( thread_streams_flag.load ( memory_order_relaxed ) )
+  {
+    return RngStream::Local ( ).r4_uni_01 ( );
+  }
+//
 //  Check whether the package must be initialized.
 //
   if ( ! initialized_get ( ) )
@@ -1547,6 +1569,13 @@ double r8_uni_01 ( )
   int i;
   double value;
 //
+//  Use the thread-local stream if requested.
+//
+  if ( thread_streams_flag.load ( memory_order_relaxed ) )
+  {
+    return RngStream::Local ( ).r8_uni_01 ( );
+  }
+//
 //  Check whether the package must be initialized.
 //
   if ( ! initialized_get ( ) )
@@ -1569,6 +1598,95 @@ double r8_uni_01 ( )
 }
 //****************************************************************************80
 
+void r8vec_uni_01 ( int n, double x[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    R8VEC_UNI_01 returns N uniform random doubles in [0,1].
+//
+//  Discussion:
+//
+//    The values are those of N calls of R8_UNI_01, but the generator
+//    index, seeds and antithetic flag are fetched and stored once, not
+//    once per value, and the loop over the recurrence is inline.
+//
+//  Parameters:
+//
+//    Input, int N, the number of values.
+//
+//    Output, double X[N], the random values.
+//
+{
+  const int a1 = 40014;
+  const int a2 = 40692;
+  bool anti;
+  int cg1;
+  int cg2;
+  int g;
+  int i;
+  int k;
+  const int m1 = 2147483563;
+  const int m2 = 2147483399;
+  int z;
+//
+//  Use the thread-local stream if requested.
+//
+  if ( thread_streams_flag.load ( memory_order_relaxed ) )
+  {
+    RngStream::Local ( ).Fill ( n, x );
+    return;
+  }
+//
+//  Check whether the package must be initialized.
+//
+  if ( ! initialized_get ( ) )
+  {
+    cout << "\n";
+    cout << "R8VEC_UNI_01 - Note:\n";
+    cout << "  Initializing RNGLIB package.\n";
+    initialize ( );
+  }
+
+  g = cgn_get ( );
+  cg_get ( g, cg1, cg2 );
+  anti = antithetic_get ( );
+
+  for ( i = 0; i < n; i++ )
+  {
+    k = cg1 / 53668;
+    cg1 = a1 * ( cg1 - k * 53668 ) - k * 12211;
+    if ( cg1 < 0 )
+    {
+      cg1 = cg1 + m1;
+    }
+
+    k = cg2 / 52774;
+    cg2 = a2 * ( cg2 - k * 52774 ) - k * 3791;
+    if ( cg2 < 0 )
+    {
+      cg2 = cg2 + m2;
+    }
+
+    z = cg1 - cg2;
+    if ( z < 1 )
+    {
+      z = z + m1 - 1;
+    }
+    if ( anti )
+    {
+      z = m1 - z;
+    }
+    x[i] = ( double ) ( z ) * 4.656613057E-10;
+  }
+
+  cg_set ( g, cg1, cg2 );
+
+  return;
+}
+//****************************************************************************80
+
 void set_initial_seed ( int ig1, int ig2 )
 
 //****************************************************************************80
@@ -1756,6 +1874,56 @@ void set_seed ( int cg1, int cg2 )
 }
 //****************************************************************************80
 
+bool thread_streams_get ( )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    THREAD_STREAMS_GET queries whether thread-local streams are in use.
+//
+//  Parameters:
+//
+//    Output, bool THREAD_STREAMS_GET, is TRUE if I4_UNI, R4_UNI_01 and
+//    R8_UNI_01 draw from the calling thread's RngStream.
+//
+{
+  return thread_streams_flag.load ( );
+}
+//****************************************************************************80
+
+void thread_streams_set ( bool value )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    THREAD_STREAMS_SET routes the uniform generators to thread-local
+//    streams.
+//
+//  Discussion:
+//
+//    With VALUE TRUE, I4_UNI, R4_UNI_01 and R8_UNI_01, and so every
+//    PDFLIB sampler, draw from RngStream::Local ( ), a stream of the
+//    calling thread, and never touch the static generator state.  They
+//    may then be called from several threads at once.  The first
+//    thread to draw gets stream 0, which gives the same numbers as
+//    generator 0 of the package.  CGN_SET, SET_SEED and the other
+//    state functions do not affect the thread-local streams.
+//
+//    Call this before the worker threads start.
+//
+//  Parameters:
+//
+//    Input, bool VALUE, TRUE to use thread-local streams.
+//
+{
+  thread_streams_flag.store ( value );
+
+  return;
+}
+//****************************************************************************80
+
 void timestamp ( )
 
 //****************************************************************************80
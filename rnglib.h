@@ -24,7 +24,10 @@ void lg_set ( int g, int lg1, int lg2 );
 int multmod ( int a, int s, int m );
 float r4_uni_01 ( );
 double r8_uni_01 ( );
+void r8vec_uni_01 ( int n, double x[] );
 void set_initial_seed ( int ig1, int ig2 );
 void set_seed (  int cg1, int cg2 );
+bool thread_streams_get ( );
+void thread_streams_set ( bool value );
 void timestamp ( );
 